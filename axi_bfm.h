@@ -0,0 +1,312 @@
+// AXI4 master bus functional model for Vaxi_spi_flash_top.
+//
+// One outstanding transaction at a time; write bursts present W beats from
+// the first cycle, together with AW. Every access returns once its
+// response has been taken and reports its latency in system clock cycles,
+// from the cycle AWVALID/ARVALID is raised to the B handshake or the last R
+// beat. Bursts to the TX/RX FIFO windows are throttled by wready/rvalid
+// when the FIFO is full or empty. Every system clock is counted in clocks;
+// arm_spi_edge() records the cycle of the next rising SPI clock in
+// spi_edge_cycle.
+#pragma once
+
+#include "Vaxi_spi_flash_top.h"
+#include "tb_trace.h"
+#include <cstdint>
+#include <iostream>
+
+// Register map of axi_spi_master (byte addresses)
+enum AxiSpiReg : uint32_t {
+    REG_STATUS = 0x00,   // W: [0] rd [1] wr [2] qrd [3] qwr [4] swrst
+                         //    [5] perf snapshot [6] perf clear [11:8] cs
+                         // R: [7:0] ctrl state one-hot (IDLE .. WAIT_EDGE), [23:16] RX level,
+                         //    [31:24] TX level
+    REG_CLKDIV = 0x04,
+    REG_SPICMD = 0x08,   // command, first bit in [31]
+    REG_SPIADR = 0x0C,   // address, first bit in [31]
+    REG_SPILEN = 0x10,   // [7:0] cmd bits, [15:8] addr bits, [31:16] data bits
+    REG_SPIDUM = 0x14,   // [15:0] read dummy, [31:16] write dummy
+    REG_FIFOTH = 0x18,
+    REG_XIPCFG = 0x1C,   // [7:0] cmd [15:8] dummy [16] quad [17] quad addr
+                         // [18] prefetch [31] enable
+    REG_TXFIFO = 0x20,
+    REG_RXFIFO = 0x40,
+    REG_LNADDR = 0x40,   // W only: launch address, right-aligned
+    REG_LAUNCH = 0x44,   // W only, starts the transfer: [7:0] cmd
+                         // [9:8] addr 0 none 1 24-bit 2 32-bit
+                         // [11:10] 0 rd 1 wr 2 qrd 3 qwr [15:12] dummy
+                         // [27:16] data bytes [31:28] cs
+                         // (max 4095 bytes, 15 dummy cycles for rd and wr)
+    REG_PERF   = 0x80    // read-only counter snapshot, PerfCounter words
+};
+
+// Word index of a counter in the REG_PERF block (spi_master_perf)
+enum PerfCounter {
+    PERF_CYCLES   = 0,
+    PERF_XFERS    = 1,
+    PERF_TX_BYTES = 2,
+    PERF_RX_BYTES = 3,
+    PERF_TX_STALL = 4,
+    PERF_RX_STALL = 5,
+    PERF_STATE    = 8,   // + controller state, IDLE .. WAIT_EDGE
+    PERF_WORDS    = 16
+};
+
+class AxiBfm {
+public:
+    AxiBfm(Vaxi_spi_flash_top* dut, TbTrace* tfp, vluint64_t& time)
+        : dut(dut), tfp(tfp), time(time) {}
+
+    void tick(int n = 1) {
+        for (int i = 0; i < n; i++) {
+            dut->clk = 0;
+            dut->eval();
+            tfp->dump(time++);
+            dut->clk = 1;
+            dut->eval();
+            tfp->dump(time++);
+            posedge();
+        }
+    }
+
+    // All master outputs to idle
+    void reset_inputs() {
+        dut->s_axi_awvalid = 0;
+        dut->s_axi_awid    = 0;
+        dut->s_axi_awlen   = 0;
+        dut->s_axi_awaddr  = 0;
+        dut->s_axi_awuser  = 0;
+        dut->s_axi_wvalid  = 0;
+        dut->s_axi_wdata   = 0;
+        dut->s_axi_wstrb   = 0;
+        dut->s_axi_wlast   = 0;
+        dut->s_axi_wuser   = 0;
+        dut->s_axi_bready  = 0;
+        dut->s_axi_arvalid = 0;
+        dut->s_axi_arid    = 0;
+        dut->s_axi_arlen   = 0;
+        dut->s_axi_araddr  = 0;
+        dut->s_axi_aruser  = 0;
+        dut->s_axi_rready  = 0;
+    }
+
+    // -------------------------------------------------------------------------
+    // Single-beat write, address and data presented together
+    // -------------------------------------------------------------------------
+    uint64_t write32(uint32_t addr, uint32_t data) {
+        dut->s_axi_awaddr  = addr;
+        dut->s_axi_awlen   = 0;
+        dut->s_axi_awvalid = 1;
+        dut->s_axi_wdata   = data;
+        dut->s_axi_wstrb   = 0xF;
+        dut->s_axi_wlast   = 1;
+        dut->s_axi_wvalid  = 1;
+        dut->s_axi_bready  = 1;
+
+        uint64_t cycles = 0;
+        bool done = false;
+        for (int t = 0; t < timeout_cycles && !done; t++) {
+            dut->clk = 0;
+            dut->eval();
+            tfp->dump(time++);
+            bool aw_hs = dut->s_axi_awvalid && dut->s_axi_awready;
+            bool w_hs  = dut->s_axi_wvalid && dut->s_axi_wready;
+            bool b_hs  = dut->s_axi_bvalid && dut->s_axi_bready;
+            dut->clk = 1;
+            dut->eval();
+            tfp->dump(time++);
+            posedge();
+            cycles++;
+
+            if (aw_hs) dut->s_axi_awvalid = 0;
+            if (w_hs)  dut->s_axi_wvalid  = 0;
+            done = b_hs;
+        }
+        dut->s_axi_awvalid = 0;
+        dut->s_axi_wvalid  = 0;
+        dut->s_axi_bready  = 0;
+
+        if (!done) {
+            std::cout << "  [TIMEOUT] AXI write 0x" << std::hex << addr << std::dec << "\n";
+            timeouts++;
+        }
+        return cycles;
+    }
+
+    // -------------------------------------------------------------------------
+    // Write burst of beats words (one register, or the TX FIFO window);
+    // returns the latency
+    // -------------------------------------------------------------------------
+    uint64_t write_burst(uint32_t addr, const uint32_t* data, int beats) {
+        dut->s_axi_awaddr  = addr;
+        dut->s_axi_awlen   = beats - 1;
+        dut->s_axi_awvalid = 1;
+        dut->s_axi_wstrb   = 0xF;
+        dut->s_axi_bready  = 1;
+
+        uint64_t cycles = 0;
+        int sent = 0;
+        bool done = false;
+        for (int t = 0; t < timeout_cycles && !done; t++) {
+            dut->s_axi_wvalid = sent < beats;
+            dut->s_axi_wdata  = sent < beats ? data[sent] : 0;
+            dut->s_axi_wlast  = sent == beats - 1;
+
+            dut->clk = 0;
+            dut->eval();
+            tfp->dump(time++);
+            bool aw_hs = dut->s_axi_awvalid && dut->s_axi_awready;
+            bool w_hs  = dut->s_axi_wvalid && dut->s_axi_wready;
+            bool b_hs  = dut->s_axi_bvalid && dut->s_axi_bready;
+            dut->clk = 1;
+            dut->eval();
+            tfp->dump(time++);
+            posedge();
+            cycles++;
+
+            if (aw_hs) dut->s_axi_awvalid = 0;
+            if (w_hs)  sent++;
+            done = b_hs;
+        }
+        dut->s_axi_awvalid = 0;
+        dut->s_axi_wvalid  = 0;
+        dut->s_axi_wlast   = 0;
+        dut->s_axi_bready  = 0;
+
+        if (!done || sent != beats) {
+            std::cout << "  [TIMEOUT] AXI write burst 0x" << std::hex << addr << std::dec
+                      << " " << sent << "/" << beats << " beats\n";
+            timeouts++;
+        }
+        return cycles;
+    }
+
+    // -------------------------------------------------------------------------
+    // INCR read burst of beats words; returns the latency
+    // -------------------------------------------------------------------------
+    uint64_t read_burst(uint32_t addr, uint32_t* data, int beats) {
+        dut->s_axi_araddr  = addr;
+        dut->s_axi_arlen   = beats - 1;
+        dut->s_axi_arvalid = 1;
+        dut->s_axi_rready  = 1;
+
+        uint64_t cycles = 0;
+        int got = 0;
+        bool done = false;
+        for (int t = 0; t < timeout_cycles && !done; t++) {
+            dut->clk = 0;
+            dut->eval();
+            tfp->dump(time++);
+            bool     ar_hs = dut->s_axi_arvalid && dut->s_axi_arready;
+            bool     r_hs  = dut->s_axi_rvalid && dut->s_axi_rready;
+            bool     last  = dut->s_axi_rlast;
+            uint32_t rd    = dut->s_axi_rdata;
+            dut->clk = 1;
+            dut->eval();
+            tfp->dump(time++);
+            posedge();
+            cycles++;
+
+            if (ar_hs) dut->s_axi_arvalid = 0;
+            if (r_hs) {
+                if (got < beats) data[got] = rd;
+                got++;
+                done = last;
+            }
+        }
+        dut->s_axi_arvalid = 0;
+        dut->s_axi_rready  = 0;
+
+        if (!done || got != beats) {
+            std::cout << "  [TIMEOUT] AXI read 0x" << std::hex << addr << std::dec
+                      << " " << got << "/" << beats << " beats\n";
+            timeouts++;
+        }
+        return cycles;
+    }
+
+    uint32_t read32(uint32_t addr) {
+        uint32_t v = 0;
+        read_burst(addr, &v, 1);
+        return v;
+    }
+
+    // -------------------------------------------------------------------------
+    // Register-interface SPI commands on chip select 0
+    // -------------------------------------------------------------------------
+
+    // Single-write launch (REG_LAUNCH); has_addr sends addr as 24 bits and
+    // costs a REG_LNADDR write first. The fields take at most 4095 data
+    // bytes and 15 dummy cycles (one count for both directions); anything
+    // larger is reported and nothing is written, use spi_command() instead.
+    void spi_launch(uint8_t cmd, bool has_addr, uint32_t addr, int data_bytes,
+                    int dummy, uint32_t op, uint32_t cs = 0x1) {
+        if (data_bytes < 0 || data_bytes > 0xFFF || dummy < 0 || dummy > 0xF) {
+            std::cout << "  [ERROR] spi_launch: " << data_bytes << " bytes, "
+                      << dummy << " dummy cycles do not fit REG_LAUNCH\n";
+            return;
+        }
+        if (has_addr)
+            write32(REG_LNADDR, addr);
+        write32(REG_LAUNCH, (cs << 28) | (uint32_t(data_bytes) << 16) |
+                            (uint32_t(dummy) << 12) | (op << 10) |
+                            ((has_addr ? 1u : 0u) << 8) | cmd);
+    }
+
+    // Poll REG_STATUS until the controller is back in IDLE
+    void wait_idle() {
+        for (int t = 0; t < timeout_cycles; t++)
+            if (read32(REG_STATUS) & 0x01)
+                return;
+        std::cout << "  [TIMEOUT] controller never went idle\n";
+        timeouts++;
+    }
+
+    // Command, optional 24-bit address, data_bits of data; kick is the
+    // REG_STATUS operation bit (0x1 rd, 0x2 wr)
+    void spi_command(uint8_t cmd, bool has_addr, uint32_t addr, int data_bits,
+                     int dummy, uint32_t kick) {
+        write32(REG_SPICMD, uint32_t(cmd) << 24);
+        write32(REG_SPIADR, addr << 8);
+        write32(REG_SPILEN, (uint32_t(data_bits) << 16) | ((has_addr ? 24u : 0u) << 8) | 8u);
+        write32(REG_SPIDUM, uint32_t(dummy));
+        write32(REG_STATUS, 0x100 | kick);
+    }
+
+    // Clock until the edge armed by arm_spi_edge() has been seen
+    void wait_spi_edge() {
+        for (int t = 0; t < timeout_cycles && edge_armed; t++)
+            tick();
+        if (edge_armed) {
+            std::cout << "  [TIMEOUT] no SPI clock edge\n";
+            timeouts++;
+            edge_armed = false;
+        }
+    }
+
+    void arm_spi_edge() {
+        edge_armed     = true;
+        spi_edge_cycle = 0;
+    }
+
+    int timeouts = 0;
+    int timeout_cycles = 200000;
+    uint64_t clocks = 0;
+    uint64_t spi_edge_cycle = 0;
+
+private:
+    void posedge() {
+        clocks++;
+        if (edge_armed && dut->spi_clk_o && !spi_clk_q) {
+            spi_edge_cycle = clocks;
+            edge_armed     = false;
+        }
+        spi_clk_q = dut->spi_clk_o;
+    }
+
+    bool                edge_armed = false;
+    bool                spi_clk_q  = false;
+    Vaxi_spi_flash_top* dut;
+    TbTrace*            tfp;
+    vluint64_t&         time;
+};
@@ -0,0 +1,164 @@
+module axi_spi_flash_top #(
+    parameter MEMORY_SIZE    = 1024 * 256,
+    parameter SECTOR_SIZE    = 64,
+    parameter MFR_ID         = 8'h20,
+    parameter DEVICE_ID      = 16'hBA19,
+    parameter XIP_BASE_ADDR  = 32'h0100_0000,
+    parameter XIP_LINE_WORDS = 8
+) (
+    input  logic        clk,
+    input  logic        rstn,
+
+    // AXI4 slave — same as axi_spi_master with the default widths
+    input  logic        s_axi_awvalid,
+    input  logic [15:0] s_axi_awid,
+    input  logic [7:0]  s_axi_awlen,
+    input  logic [31:0] s_axi_awaddr,
+    input  logic [3:0]  s_axi_awuser,
+    output logic        s_axi_awready,
+
+    input  logic        s_axi_wvalid,
+    input  logic [31:0] s_axi_wdata,
+    input  logic [3:0]  s_axi_wstrb,
+    input  logic        s_axi_wlast,
+    input  logic [3:0]  s_axi_wuser,
+    output logic        s_axi_wready,
+
+    output logic        s_axi_bvalid,
+    output logic [15:0] s_axi_bid,
+    output logic [1:0]  s_axi_bresp,
+    output logic [3:0]  s_axi_buser,
+    input  logic        s_axi_bready,
+
+    input  logic        s_axi_arvalid,
+    input  logic [15:0] s_axi_arid,
+    input  logic [7:0]  s_axi_arlen,
+    input  logic [31:0] s_axi_araddr,
+    input  logic [3:0]  s_axi_aruser,
+    output logic        s_axi_arready,
+
+    output logic        s_axi_rvalid,
+    output logic [15:0] s_axi_rid,
+    output logic [31:0] s_axi_rdata,
+    output logic [1:0]  s_axi_rresp,
+    output logic        s_axi_rlast,
+    output logic [3:0]  s_axi_ruser,
+    input  logic        s_axi_rready,
+
+    output logic [1:0]  events_o,
+    output logic        irq_o,
+
+    // SPI bus, observed by the testbench
+    output logic        spi_clk_o,
+    output logic        spi_csn0_o
+);
+
+    // -------------------------------------------------------------------------
+    // Internal SPI bus — wires between master and flash model
+    // -------------------------------------------------------------------------
+    logic       spi_clk;
+    logic       spi_csn0, spi_csn1, spi_csn2, spi_csn3;
+    logic [1:0] spi_mode;
+    logic       spi_sdo0, spi_sdo1, spi_sdo2, spi_sdo3;
+    logic       spi_sdi0, spi_sdi1, spi_sdi2, spi_sdi3;
+
+    // Standard SPI reads MISO on IO1, the controller samples sdi0
+    logic       ctrl_sdi0;
+    assign ctrl_sdi0 = (spi_mode == 2'b00) ? spi_sdi1 : spi_sdi0;
+
+    assign spi_clk_o  = spi_clk;
+    assign spi_csn0_o = spi_csn0;
+
+    // -------------------------------------------------------------------------
+    // AXI SPI master
+    // -------------------------------------------------------------------------
+    axi_spi_master #(
+        .XIP_BASE_ADDR (XIP_BASE_ADDR),
+        .XIP_LINE_WORDS(XIP_LINE_WORDS)
+    ) u_master (
+        .s_axi_aclk     (clk),
+        .s_axi_aresetn  (rstn),
+
+        .s_axi_awvalid  (s_axi_awvalid),
+        .s_axi_awid     (s_axi_awid),
+        .s_axi_awlen    (s_axi_awlen),
+        .s_axi_awaddr   (s_axi_awaddr),
+        .s_axi_awuser   (s_axi_awuser),
+        .s_axi_awready  (s_axi_awready),
+
+        .s_axi_wvalid   (s_axi_wvalid),
+        .s_axi_wdata    (s_axi_wdata),
+        .s_axi_wstrb    (s_axi_wstrb),
+        .s_axi_wlast    (s_axi_wlast),
+        .s_axi_wuser    (s_axi_wuser),
+        .s_axi_wready   (s_axi_wready),
+
+        .s_axi_bvalid   (s_axi_bvalid),
+        .s_axi_bid      (s_axi_bid),
+        .s_axi_bresp    (s_axi_bresp),
+        .s_axi_buser    (s_axi_buser),
+        .s_axi_bready   (s_axi_bready),
+
+        .s_axi_arvalid  (s_axi_arvalid),
+        .s_axi_arid     (s_axi_arid),
+        .s_axi_arlen    (s_axi_arlen),
+        .s_axi_araddr   (s_axi_araddr),
+        .s_axi_aruser   (s_axi_aruser),
+        .s_axi_arready  (s_axi_arready),
+
+        .s_axi_rvalid   (s_axi_rvalid),
+        .s_axi_rid      (s_axi_rid),
+        .s_axi_rdata    (s_axi_rdata),
+        .s_axi_rresp    (s_axi_rresp),
+        .s_axi_rlast    (s_axi_rlast),
+        .s_axi_ruser    (s_axi_ruser),
+        .s_axi_rready   (s_axi_rready),
+
+        .events_o       (events_o),
+        .irq_o          (irq_o),
+
+        // SPI bus
+        .spi_clk        (spi_clk),
+        .spi_csn0       (spi_csn0),
+        .spi_csn1       (spi_csn1),
+        .spi_csn2       (spi_csn2),
+        .spi_csn3       (spi_csn3),
+        .spi_mode       (spi_mode),
+        .spi_sdo0       (spi_sdo0),
+        .spi_sdo1       (spi_sdo1),
+        .spi_sdo2       (spi_sdo2),
+        .spi_sdo3       (spi_sdo3),
+        .spi_sdi0       (ctrl_sdi0),
+        .spi_sdi1       (spi_sdi1),
+        .spi_sdi2       (spi_sdi2),
+        .spi_sdi3       (spi_sdi3)
+    );
+
+    // -------------------------------------------------------------------------
+    // NOR Flash simulation model (slave) on chip select 0, IO0..IO3 resolved
+    // as in spi_flash_top
+    // -------------------------------------------------------------------------
+    logic [3:0] flash_dq_o;
+    logic [3:0] flash_dq_oe;
+
+    qspi_nor_sim_model #(
+        .MEMORY_SIZE(MEMORY_SIZE),
+        .SECTOR_SIZE(SECTOR_SIZE),
+        .MFR_ID     (MFR_ID),
+        .DEVICE_ID  (DEVICE_ID)
+    ) u_flash (
+        .clk_i      (clk),
+        .sclk       (spi_clk),
+        .cs_n       (spi_csn0),
+
+        .dq_i       ({spi_sdo3, spi_sdo2, spi_sdo1, spi_sdo0}),
+        .dq_o       (flash_dq_o),
+        .dq_oe_o    (flash_dq_oe)
+    );
+
+    assign spi_sdi0 = flash_dq_oe[0] ? flash_dq_o[0] : spi_sdo0;
+    assign spi_sdi1 = flash_dq_oe[1] ? flash_dq_o[1] : spi_sdo1;
+    assign spi_sdi2 = flash_dq_oe[2] ? flash_dq_o[2] : spi_sdo2;
+    assign spi_sdi3 = flash_dq_oe[3] ? flash_dq_o[3] : spi_sdo3;
+
+endmodule
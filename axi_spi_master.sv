@@ -17,7 +17,14 @@ module axi_spi_master
     parameter AXI4_WDATA_WIDTH   = 32,
     parameter AXI4_USER_WIDTH    = 4,
     parameter AXI4_ID_WIDTH      = 16,
-    parameter BUFFER_DEPTH       = 8
+    parameter BUFFER_DEPTH       = 8,
+    parameter TX_BUFFER_DEPTH    = BUFFER_DEPTH,  // at most 127 words each,
+    parameter RX_BUFFER_DEPTH    = BUFFER_DEPTH,  // levels are 8 bit in STATUS
+    // execute-in-place read window: araddr[AXI4_ADDRESS_WIDTH-1:XIP_ADDR_WIDTH]
+    // equal to the same bits of XIP_BASE_ADDR, enabled by REG_XIPCFG[31]
+    parameter XIP_BASE_ADDR      = 32'h0100_0000,
+    parameter XIP_ADDR_WIDTH     = 24,
+    parameter XIP_LINE_WORDS     = 8
 )
 (
     input  logic                          s_axi_aclk,
@@ -59,6 +66,7 @@ module axi_spi_master
     input  logic                          s_axi_rready,
 
     output logic                    [1:0] events_o,
+    output logic                          irq_o,
 
     output logic                          spi_clk,
     output logic                          spi_csn0,
@@ -77,7 +85,8 @@ module axi_spi_master
 );
 
 
-    localparam LOG_BUFFER_DEPTH = `log2(BUFFER_DEPTH);
+    localparam TX_LOG_BUFFER_DEPTH = `log2(TX_BUFFER_DEPTH);
+    localparam RX_LOG_BUFFER_DEPTH = `log2(RX_BUFFER_DEPTH);
 
     logic   [7:0] spi_clk_div;
     logic         spi_clk_div_valid;
@@ -89,11 +98,59 @@ module axi_spi_master
     logic  [15:0] spi_data_len;
     logic  [15:0] spi_dummy_rd;
     logic  [15:0] spi_dummy_wr;
+    logic   [7:0] spi_tx_ae_th;
+    logic   [7:0] spi_rx_af_th;
+    logic   [2:0] spi_irq_en;
+    logic         tx_almost_empty;
+    logic         rx_almost_full;
+
+    // register interface / XIP read channel split
+    logic  [31:0] spi_xip_cfg;
+    logic         spi_xip_cfg_valid;
+    logic         xip_en;
+    logic         ar_in_xip;
+    logic         rd_busy_q;
+    logic         rd_xip_q;
+
+    logic                          regs_arvalid;
+    logic                          regs_arready;
+    logic                          regs_rvalid;
+    logic      [AXI4_ID_WIDTH-1:0] regs_rid;
+    logic   [AXI4_RDATA_WIDTH-1:0] regs_rdata;
+    logic                    [1:0] regs_rresp;
+    logic                          regs_rlast;
+    logic    [AXI4_USER_WIDTH-1:0] regs_ruser;
+    logic                          regs_rready;
+
+    logic                          xip_arvalid;
+    logic                          xip_arready;
+    logic                          xip_rvalid;
+    logic      [AXI4_ID_WIDTH-1:0] xip_rid;
+    logic   [AXI4_RDATA_WIDTH-1:0] xip_rdata;
+    logic                    [1:0] xip_rresp;
+    logic                          xip_rlast;
+    logic    [AXI4_USER_WIDTH-1:0] xip_ruser;
+    logic                          xip_rready;
+
+    logic         xip_busy;
+    logic         xip_rd;
+    logic         xip_qrd;
+    logic  [31:0] xip_cmd;
+    logic  [31:0] xip_addr;
+    logic   [1:0] xip_addr_lanes;
+    logic  [15:0] xip_data_len;
+    logic  [15:0] xip_dummy_rd;
+    logic         xip_rx_ready;
+    logic         fifo_rx_valid;
+    logic         fifo_rx_ready;
+
     logic         spi_swrst;
     logic         spi_rd;
     logic         spi_wr;
     logic         spi_qrd;
     logic         spi_qwr;
+    logic   [3:0] host_op;          // {qwr, qrd, wr, rd}: start pulse or held
+    logic   [3:0] host_op_q;
     logic   [3:0] spi_csreg;
     logic  [31:0] spi_data_tx;
     logic         spi_data_tx_valid;
@@ -101,7 +158,7 @@ module axi_spi_master
     logic  [31:0] spi_data_rx;
     logic         spi_data_rx_valid;
     logic         spi_data_rx_ready;
-    logic   [6:0] spi_ctrl_status;
+    logic   [7:0] spi_ctrl_status;
     logic  [31:0] spi_ctrl_data_tx;
     logic         spi_ctrl_data_tx_valid;
     logic         spi_ctrl_data_tx_ready;
@@ -111,16 +168,34 @@ module axi_spi_master
 
     logic         s_eot;
 
-    logic [LOG_BUFFER_DEPTH:0] elements_tx;
-    logic [LOG_BUFFER_DEPTH:0] elements_rx;
-    logic [LOG_BUFFER_DEPTH:0] elements_tx_old;
-    logic [LOG_BUFFER_DEPTH:0] elements_rx_old;
-
-    localparam FILL_BITS = 7-LOG_BUFFER_DEPTH;
-
-    assign spi_status = {{FILL_BITS{1'b0}},elements_tx,{FILL_BITS{1'b0}},elements_rx,9'h0,spi_ctrl_status};
+    // performance counters
+    logic         perf_snapshot;
+    logic         perf_clear;
+    logic   [3:0] perf_addr;
+    logic  [31:0] perf_rdata;
+    logic   [2:0] ctrl_state;
+    logic  [15:0] ctrl_data_len;
+    logic         ctrl_data_tx_start;
+    logic         ctrl_data_rx_start;
+    logic         ctrl_tx_stall;
+    logic         ctrl_rx_stall;
+
+    logic [TX_LOG_BUFFER_DEPTH:0] elements_tx;
+    logic [RX_LOG_BUFFER_DEPTH:0] elements_rx;
+    logic [TX_LOG_BUFFER_DEPTH:0] elements_tx_old;
+    logic [RX_LOG_BUFFER_DEPTH:0] elements_rx_old;
+
+    localparam TX_FILL_BITS = 7-TX_LOG_BUFFER_DEPTH;
+    localparam RX_FILL_BITS = 7-RX_LOG_BUFFER_DEPTH;
+
+    // FIFO watermarks from REG_FIFOTH; rx threshold 0 disables rx_almost_full
+    assign tx_almost_empty = ({{TX_FILL_BITS{1'b0}},elements_tx} <= spi_tx_ae_th);
+    assign rx_almost_full  = (spi_rx_af_th != 8'h0) && ({{RX_FILL_BITS{1'b0}},elements_rx} >= spi_rx_af_th);
+    assign irq_o = (spi_irq_en[0] & rx_almost_full) | (spi_irq_en[1] & tx_almost_empty) | (spi_irq_en[2] & s_eot & !xip_busy);
+
+    assign spi_status = {{TX_FILL_BITS{1'b0}},elements_tx,{RX_FILL_BITS{1'b0}},elements_rx,6'h0,rx_almost_full,tx_almost_empty,spi_ctrl_status};
     assign events_o[0] = (((elements_rx==4'b0100) && (elements_rx_old==4'b0101)) || ((elements_tx==4'b0101) && (elements_tx_old==4'b0100)));
-    assign events_o[1] = s_eot;
+    assign events_o[1] = s_eot && !xip_busy;   // XIP line fetches are not reported
 
     always_ff @(posedge s_axi_aclk or negedge s_axi_aresetn)
     begin
@@ -136,6 +211,115 @@ module axi_spi_master
         end
     end
 
+    // -------------------------------------------------------------------------
+    // Read channel split: one read burst in flight, owned by either the
+    // register interface or the XIP window until its last beat
+    // -------------------------------------------------------------------------
+    assign xip_en    = spi_xip_cfg[31];
+    assign ar_in_xip = xip_en && ((s_axi_araddr >> XIP_ADDR_WIDTH) == (XIP_BASE_ADDR >> XIP_ADDR_WIDTH));
+
+    assign regs_arvalid  = s_axi_arvalid && !ar_in_xip && !rd_busy_q;
+    assign xip_arvalid   = s_axi_arvalid &&  ar_in_xip && !rd_busy_q;
+    assign s_axi_arready = !rd_busy_q && (ar_in_xip ? xip_arready : regs_arready);
+
+    assign s_axi_rvalid = rd_xip_q ? xip_rvalid : regs_rvalid;
+    assign s_axi_rid    = rd_xip_q ? xip_rid    : regs_rid;
+    assign s_axi_rdata  = rd_xip_q ? xip_rdata  : regs_rdata;
+    assign s_axi_rresp  = rd_xip_q ? xip_rresp  : regs_rresp;
+    assign s_axi_rlast  = rd_xip_q ? xip_rlast  : regs_rlast;
+    assign s_axi_ruser  = rd_xip_q ? xip_ruser  : regs_ruser;
+    assign regs_rready  = s_axi_rready && rd_busy_q && !rd_xip_q;
+    assign xip_rready   = s_axi_rready && rd_busy_q &&  rd_xip_q;
+
+    always_ff @(posedge s_axi_aclk or negedge s_axi_aresetn)
+    begin
+        if (s_axi_aresetn == 1'b0)
+        begin
+            rd_busy_q <= 1'b0;
+            rd_xip_q  <= 1'b0;
+        end
+        else if (s_axi_arvalid && s_axi_arready)
+        begin
+            rd_busy_q <= 1'b1;
+            rd_xip_q  <= ar_in_xip;
+        end
+        else if (s_axi_rvalid && s_axi_rready && s_axi_rlast)
+        begin
+            rd_busy_q <= 1'b0;
+        end
+    end
+
+    spi_master_xip
+    #(
+        .AXI4_RDATA_WIDTH(AXI4_RDATA_WIDTH),
+        .AXI4_USER_WIDTH(AXI4_USER_WIDTH),
+        .AXI4_ID_WIDTH(AXI4_ID_WIDTH),
+        .XIP_ADDR_WIDTH(XIP_ADDR_WIDTH),
+        .LINE_WORDS(XIP_LINE_WORDS)
+    )
+    u_xip
+    (
+        .clk(s_axi_aclk),
+        .rstn(s_axi_aresetn),
+
+        .cfg_cmd_i(spi_xip_cfg[7:0]),
+        .cfg_dummy_i(spi_xip_cfg[15:8]),
+        .cfg_quad_i(spi_xip_cfg[16]),
+        .cfg_quad_addr_i(spi_xip_cfg[17]),
+        .cfg_prefetch_i(spi_xip_cfg[18]),
+        .cfg_inval_i(spi_xip_cfg_valid),
+
+        .arvalid_i(xip_arvalid),
+        .arid_i(s_axi_arid),
+        .arlen_i(s_axi_arlen),
+        .araddr_i(s_axi_araddr[XIP_ADDR_WIDTH-1:0]),
+        .aruser_i(s_axi_aruser),
+        .arready_o(xip_arready),
+
+        .rvalid_o(xip_rvalid),
+        .rid_o(xip_rid),
+        .rdata_o(xip_rdata),
+        .rresp_o(xip_rresp),
+        .rlast_o(xip_rlast),
+        .ruser_o(xip_ruser),
+        .rready_i(xip_rready),
+
+        .spi_idle_i(spi_ctrl_status[0]),
+        .host_req_i(|host_op),
+        .busy_o(xip_busy),
+        .spi_rd_o(xip_rd),
+        .spi_qrd_o(xip_qrd),
+        .spi_cmd_o(xip_cmd),
+        .spi_addr_o(xip_addr),
+        .spi_addr_lanes_o(xip_addr_lanes),
+        .spi_data_len_o(xip_data_len),
+        .spi_dummy_rd_o(xip_dummy_rd),
+        .eot_i(s_eot),
+
+        .rx_data_i(spi_ctrl_data_rx),
+        .rx_valid_i(spi_ctrl_data_rx_valid && xip_busy),
+        .rx_ready_o(xip_rx_ready)
+    );
+
+    // A register command started while a line fetch owns the controller is
+    // held until the fetch ends; the fetch engine does not start a line in
+    // a cycle with a register command
+    assign host_op = {spi_qwr, spi_qrd, spi_wr, spi_rd} | host_op_q;
+
+    always_ff @(posedge s_axi_aclk or negedge s_axi_aresetn)
+    begin
+        if (s_axi_aresetn == 1'b0)
+            host_op_q <= 4'h0;
+        else
+            host_op_q <= xip_busy ? host_op : 4'h0;
+    end
+
+    // RX data goes to the XIP line buffer while a line fetch owns the
+    // controller, to the RX FIFO otherwise
+    assign fifo_rx_valid          = spi_ctrl_data_rx_valid && !xip_busy;
+    assign ctrl_data_len          = xip_busy ? xip_data_len : spi_data_len;
+    assign spi_ctrl_data_rx_ready = xip_busy ? xip_rx_ready : fifo_rx_ready;
+
     spi_master_axi_if
     #(
         .AXI4_ADDRESS_WIDTH(AXI4_ADDRESS_WIDTH),
@@ -169,20 +353,20 @@ module axi_spi_master
         .s_axi_buser(s_axi_buser),
         .s_axi_bready(s_axi_bready),
 
-        .s_axi_arvalid(s_axi_arvalid),
+        .s_axi_arvalid(regs_arvalid),
         .s_axi_arid(s_axi_arid),
         .s_axi_arlen(s_axi_arlen),
         .s_axi_araddr(s_axi_araddr),
         .s_axi_aruser(s_axi_aruser),
-        .s_axi_arready(s_axi_arready),
+        .s_axi_arready(regs_arready),
 
-        .s_axi_rvalid(s_axi_rvalid),
-        .s_axi_rid(s_axi_rid),
-        .s_axi_rdata(s_axi_rdata),
-        .s_axi_rresp(s_axi_rresp),
-        .s_axi_rlast(s_axi_rlast),
-        .s_axi_ruser(s_axi_ruser),
-        .s_axi_rready(s_axi_rready),
+        .s_axi_rvalid(regs_rvalid),
+        .s_axi_rid(regs_rid),
+        .s_axi_rdata(regs_rdata),
+        .s_axi_rresp(regs_rresp),
+        .s_axi_rlast(regs_rlast),
+        .s_axi_ruser(regs_ruser),
+        .s_axi_rready(regs_rready),
 
         .spi_clk_div(spi_clk_div),
         .spi_clk_div_valid(spi_clk_div_valid),
@@ -194,6 +378,11 @@ module axi_spi_master
         .spi_data_len(spi_data_len),
         .spi_dummy_rd(spi_dummy_rd),
         .spi_dummy_wr(spi_dummy_wr),
+        .spi_tx_ae_th(spi_tx_ae_th),
+        .spi_rx_af_th(spi_rx_af_th),
+        .spi_irq_en(spi_irq_en),
+        .spi_xip_cfg(spi_xip_cfg),
+        .spi_xip_cfg_valid(spi_xip_cfg_valid),
         .spi_swrst(spi_swrst),
         .spi_rd(spi_rd),
         .spi_wr(spi_wr),
@@ -205,13 +394,35 @@ module axi_spi_master
         .spi_data_tx_ready(spi_data_tx_ready),
         .spi_data_rx(spi_data_rx),
         .spi_data_rx_valid(spi_data_rx_valid),
-        .spi_data_rx_ready(spi_data_rx_ready)
+        .spi_data_rx_ready(spi_data_rx_ready),
+        .spi_perf_snapshot(perf_snapshot),
+        .spi_perf_clear(perf_clear),
+        .spi_perf_addr(perf_addr),
+        .spi_perf_rdata(perf_rdata)
+    );
+
+    // counters over all controller traffic, XIP line fetches included
+    spi_master_perf u_perf
+    (
+        .clk(s_axi_aclk),
+        .rstn(s_axi_aresetn),
+        .snapshot_i(perf_snapshot),
+        .clear_i(perf_clear),
+        .state_i(ctrl_state),
+        .eot_i(s_eot),
+        .tx_start_i(ctrl_data_tx_start),
+        .rx_start_i(ctrl_data_rx_start),
+        .data_len_i(ctrl_data_len),
+        .tx_stall_i(ctrl_tx_stall),
+        .rx_stall_i(ctrl_rx_stall),
+        .addr_i(perf_addr),
+        .rdata_o(perf_rdata)
     );
 
     spi_master_fifo
     #(
         .DATA_WIDTH(32),
-        .BUFFER_DEPTH(BUFFER_DEPTH)
+        .BUFFER_DEPTH(TX_BUFFER_DEPTH)
     )
     u_txfifo
     (
@@ -233,7 +444,7 @@ module axi_spi_master
     spi_master_fifo
     #(
         .DATA_WIDTH(32),
-        .BUFFER_DEPTH(BUFFER_DEPTH)
+        .BUFFER_DEPTH(RX_BUFFER_DEPTH)
     )
     u_rxfifo
     (
@@ -247,9 +458,9 @@ module axi_spi_master
         .valid_o(spi_data_rx_valid),
         .ready_i(spi_data_rx_ready),
 
-        .valid_i(spi_ctrl_data_rx_valid),
+        .valid_i(fifo_rx_valid),
         .data_i(spi_ctrl_data_rx),
-        .ready_o(spi_ctrl_data_rx_ready)
+        .ready_o(fifo_rx_ready)
     );
 
     spi_master_controller u_spictrl
@@ -260,19 +471,26 @@ module axi_spi_master
         .spi_clk_div(spi_clk_div),
         .spi_clk_div_valid(spi_clk_div_valid),
         .spi_status(spi_ctrl_status),
-        .spi_addr(spi_addr),
-        .spi_addr_len(spi_addr_len),
-        .spi_cmd(spi_cmd),
-        .spi_cmd_len(spi_cmd_len),
-        .spi_data_len(spi_data_len),
-        .spi_dummy_rd(spi_dummy_rd),
+        .spi_addr(xip_busy ? xip_addr : spi_addr),
+        .spi_addr_len(xip_busy ? 6'd24 : spi_addr_len),
+        .spi_cmd(xip_busy ? xip_cmd : spi_cmd),
+        .spi_cmd_len(xip_busy ? 6'd8 : spi_cmd_len),
+        .spi_data_len(ctrl_data_len),
+        .spi_dummy_rd(xip_busy ? xip_dummy_rd : spi_dummy_rd),
         .spi_dummy_wr(spi_dummy_wr),
-        .spi_swrst(spi_swrst),
-        .spi_rd(spi_rd),
-        .spi_wr(spi_wr),
-        .spi_qrd(spi_qrd),
-        .spi_qwr(spi_qwr),
-        .spi_csreg(spi_csreg),
+        .spi_rd(xip_busy ? xip_rd : host_op[0]),
+        .spi_wr(host_op[1] && !xip_busy),
+        .spi_qrd(xip_busy ? xip_qrd : host_op[2]),
+        .spi_qwr(host_op[3] && !xip_busy),
+        .spi_drd(1'b0),
+        .spi_csreg(xip_busy ? 4'b0001 : spi_csreg),   // XIP flash sits on csn0
+        // register commands: legacy lanes, QPI for qrd/qwr, single otherwise
+        .spi_cmd_lanes(xip_busy ? 2'b01 : 2'b00),
+        .spi_addr_lanes(xip_busy ? xip_addr_lanes : 2'b00),
+        .spi_data_cont(1'b0),
+        .spi_dtr(1'b0),          // register commands and XIP fetches are SDR
+        .spi_mode_bits(8'h00),
+        .spi_mode_bits_en(1'b0),
         .spi_ctrl_data_tx(spi_ctrl_data_tx),
         .spi_ctrl_data_tx_valid(spi_ctrl_data_tx_valid),
         .spi_ctrl_data_tx_ready(spi_ctrl_data_tx_ready),
@@ -292,7 +510,12 @@ module axi_spi_master
         .spi_sdi0(spi_sdi0),
         .spi_sdi1(spi_sdi1),
         .spi_sdi2(spi_sdi2),
-        .spi_sdi3(spi_sdi3)
+        .spi_sdi3(spi_sdi3),
+        .spi_state(ctrl_state),
+        .spi_data_tx_start(ctrl_data_tx_start),
+        .spi_data_rx_start(ctrl_data_rx_start),
+        .spi_tx_stall(ctrl_tx_stall),
+        .spi_rx_stall(ctrl_rx_stall)
     );
 
 endmodule
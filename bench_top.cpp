@@ -0,0 +1,698 @@
+// Throughput / latency benchmark for spi_flash_top.
+//
+// Sweeps prescaler_i, data_mode_i, dummy_cycle_i and the transfer length and
+// reports, per point, system clock cycles from start_i to status_o, cycles
+// per byte, MB/s at the given core frequency, cycles until the first RX word
+// and the cycles spent in each spi_master_controller state.
+//
+//   +core_mhz=<n>       system clock used for MB/s (default 100)
+//   +format=csv|json    output format (default csv)
+//   +out=<file>         write results to a file instead of stdout
+//   +stall              run the FIFO stall sweep instead (CSV only)
+//   +fifo_depth=<n>     FIFO depth the model was built with, for the report
+//   +mem                run the flash store benchmark instead (CSV only)
+//   +multi              run the multi-device program benchmark instead (CSV only)
+//   +prog               run the program / erase benchmark instead (CSV only)
+//   +num_flash=<n>      flashes the model was built with (default 2)
+//
+// Standard read points with dummy cycles use Fast Read (0x0B), dual and quad
+// read points use 0x3B and 0x6B and quad programs 0x32 (the wrapper has no
+// dual write, so there are no dual program points); the model
+// only returns valid data for 8 dummy cycles, the other values are there for
+// timing.
+//
+// The bulk points read a 64 KB image in 256-byte transactions (the old
+// data_count_i limit), in MAX_XFER transactions and as one continuous read,
+// to show the per-transaction command/address/dummy overhead.
+//
+// The read_io / read_dtr points read 256 bytes and 4 KB with the I/O
+// reads, address and data on the data lanes, in SDR (0x0B, 0xBB, 0xEB) and
+// DTR (0x0D, 0xBD, 0xED) at the same prescaler; data_rx shows the DTR data
+// phase at half the cycles. At prescaler 0 the DTR address phase runs at
+// divider 1.
+//
+// The rand_eb / rand_cont points are the XIP access pattern: 64 reads of 4
+// to 32 bytes at pseudo-random word addresses (the same ones for both),
+// with 0xEB on every read and in continuous read (mode bits 0xA0, the
+// opcode only on the first read). bytes is the total of the 64 reads,
+// cycles their sum and first_data_cycles the mean per read.
+//
+// The prog_host / prog_queued points program 4 KB (16 pages) once with a
+// host round trip (start, wait for status, clear status) per WREN, page
+// program and WIP poll and once as a single chain on the command queue;
+// cycles are wall clock for the whole region, including the host's status
+// handling.
+//
+// The stall sweep (make bench_depth builds one model per FIFO depth) runs
+// reads and programs against a host that polls the FIFOs every
+// poll_interval cycles and reports the data phase against its ideal length
+// bytes * 8 / lanes * 2 * (prescaler + 1); the difference is the time the
+// SPI clock was stopped on a full RX or empty TX FIFO.
+//
+// The store benchmark (make bench_mem builds the model with a 128 MB flash)
+// reports wall-clock time for model construction and reset, and cycles and
+// wall-clock time for a sector erase of a full sector, a chip erase and a
+// read of never-written flash, with the number of allocated store pages.
+//
+// The program / erase benchmark (make bench_prog, with the flash's typical
+// busy times, +flash_timing=typ) programs 16 pages and erases a 64 KB sector
+// with WIP polls every poll_interval cycles, from the host and, for the
+// pages, as one queued chain. status_reads and poll_cycles (system clocks
+// spent in the 16-clock status reads) show what the polling costs; a long
+// interval reads less but overshoots the end of the busy time.
+//
+// The multi-device benchmark (make bench_multi builds one model per
+// NUM_FLASH, with a page program busy time) programs 16 pages as one chain,
+// WREN and page program with a WIP poll per page, spread round-robin over 1
+// to num_flash devices. With one device every page waits out the busy time;
+// with more, the next device's page goes out while the others are busy.
+#include "Vspi_flash_top.h"
+#include "verilated.h"
+#include "tb_trace.h"
+#include "flash_driver.h"
+#include "flash_mem.h"
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+vluint64_t sim_time = 0;
+
+struct BenchPoint {
+    const char* op;        // "read" or "program"
+    uint8_t     opcode;
+    int         prescaler;
+    int         data_mode;
+    int         dummy;
+    int         bytes;
+};
+
+struct BenchResult {
+    BenchPoint  pt;
+    uint64_t    cycles;
+    uint64_t    first_rx;
+    PhaseCycles ph;
+};
+
+// Read bytes from addr in transactions of chunk bytes, or as one continuous
+// read when chunk is 0; cycles and phases are summed over all transactions
+BenchResult bulk_read(FlashDriver& drv, const char* name, uint8_t opcode,
+                      int prescaler, int data_mode, uint32_t addr,
+                      std::vector<uint8_t>& buf, size_t chunk) {
+    BenchResult r;
+    r.pt     = {name, opcode, prescaler, data_mode, FlashDriver::FAST_DUMMY,
+                int(buf.size())};
+    r.cycles = 0;
+    r.first_rx = 0;
+
+    FlashCmd c;
+    c.opcode    = opcode;
+    c.data_mode = data_mode;
+    c.read      = true;
+    c.has_addr  = true;
+    c.dummy     = FlashDriver::FAST_DUMMY;
+
+    drv.prescaler = prescaler;
+    drv.phases    = &r.ph;
+    if (chunk == 0) {
+        drv.stream_read(c, addr, buf.data(), buf.size());
+        r.cycles   = drv.last_cycles;
+        r.first_rx = drv.last_first_rx;
+    } else {
+        for (size_t off = 0; off < buf.size(); off += chunk) {
+            size_t n = (buf.size() - off < chunk) ? buf.size() - off : chunk;
+            c.addr = addr + uint32_t(off);
+            drv.transfer(c, nullptr, buf.data() + off, n);
+            if (off == 0) r.first_rx = drv.last_first_rx;
+            r.cycles += drv.last_cycles;
+        }
+    }
+    drv.phases = nullptr;
+    return r;
+}
+
+struct StallResult {
+    const char* op;
+    int         prescaler;
+    int         data_mode;
+    int         poll;
+    int         bytes;
+    uint64_t    data_cycles;
+    uint64_t    ideal;
+};
+
+std::vector<StallResult> stall_sweep(FlashDriver& drv) {
+    const int prescalers[] = {0, 2};
+    const int data_modes[] = {MODE_STD, MODE_QUAD};
+    const int polls[]      = {0, 8, 32, 128, 512};
+    std::vector<uint8_t> buf(2048, 0x3C);
+    std::vector<StallResult> res;
+
+    for (int p : prescalers)
+        for (int m : data_modes)
+            for (int poll : polls)
+                for (int rd = 1; rd >= 0; rd--) {
+                    int lanes = (m == MODE_QUAD) ? 4 : 1;
+                    int n = rd ? 2048 : 256;
+                    FlashCmd c;
+                    c.opcode    = rd ? (m == MODE_QUAD ? OP_QUAD_READ : OP_FAST_READ)
+                                     : (m == MODE_QUAD ? OP_QUAD_PROGRAM : OP_PAGE_PROGRAM);
+                    c.data_mode = m;
+                    c.read      = rd;
+                    c.has_addr  = true;
+                    c.addr      = 0x001000;
+                    c.dummy     = rd ? FlashDriver::FAST_DUMMY : 0;
+
+                    drv.prescaler     = p;
+                    drv.poll_interval = poll;
+                    if (!rd) drv.write_enable();
+
+                    PhaseCycles ph;
+                    drv.phases = &ph;
+                    drv.transfer(c, buf.data(), buf.data(), n);
+                    drv.phases = nullptr;
+                    drv.poll_interval = 0;
+
+                    res.push_back({rd ? "read" : "program", p, m, poll, n,
+                                   rd ? ph.data_rx : ph.data_tx,
+                                   uint64_t(n) * 8 / lanes * 2 * (p + 1)});
+                    drv.tick(5);
+                }
+    return res;
+}
+
+void write_stall_csv(std::ostream& os, const std::vector<StallResult>& res, int depth) {
+    os << "fifo_depth,op,prescaler,data_mode,poll_interval,bytes,"
+          "data_cycles,ideal_cycles,stall_cycles\n";
+    for (const StallResult& r : res)
+        os << depth << "," << r.op << "," << r.prescaler << "," << r.data_mode
+           << "," << r.poll << "," << r.bytes << "," << r.data_cycles
+           << "," << r.ideal << ","
+           << (r.data_cycles > r.ideal ? r.data_cycles - r.ideal : 0) << "\n";
+}
+
+struct MemResult {
+    const char* op;
+    uint64_t    cycles;
+    double      wall_us;
+    size_t      pages;
+};
+
+double us_since(std::chrono::steady_clock::time_point t0) {
+    return std::chrono::duration<double, std::micro>(
+        std::chrono::steady_clock::now() - t0).count();
+}
+
+std::vector<MemResult> mem_bench(FlashDriver& drv, double startup_us) {
+    FlashMem* mem = FlashMem::find();
+    std::vector<MemResult> res;
+    res.push_back({"startup", 0, startup_us, mem->pages()});
+
+    // a full 64 KB sector and a page per MB, written behind the model's back
+    const uint32_t sector = 0x030000;
+    for (uint32_t a = 0; a < 0x10000; a++)
+        mem->write(sector + a, uint8_t(a));
+    for (uint32_t a = 0; a < mem->size(); a += 0x100000)
+        mem->write(a, 0x00);
+
+    std::vector<uint8_t> buf(4096);
+    for (int op = 0; op < 3; op++) {
+        auto     t0 = std::chrono::steady_clock::now();
+        uint64_t c0 = drv.ticks;
+        switch (op) {
+            case 0: drv.erase_sector(sector); break;
+            case 1: drv.erase_chip(); break;
+            case 2: drv.fast_read(0x800000, buf.data(), buf.size()); break;
+        }
+        res.push_back({op == 0 ? "sector_erase" : op == 1 ? "chip_erase" : "read_4k_blank",
+                       drv.ticks - c0, us_since(t0), mem->pages()});
+        drv.tick(5);
+    }
+    return res;
+}
+
+void write_mem_csv(std::ostream& os, const std::vector<MemResult>& res, uint32_t size) {
+    os << "memory_bytes,op,cycles,wall_us,pages\n";
+    for (const MemResult& r : res)
+        os << size << "," << r.op << "," << r.cycles << "," << r.wall_us
+           << "," << r.pages << "\n";
+}
+
+struct ProgResult {
+    const char* op;
+    int         poll;
+    uint64_t    bytes;
+    uint64_t    cycles;
+    uint64_t    status_reads;
+};
+
+std::vector<ProgResult> prog_bench(FlashDriver& drv) {
+    const int intervals[] = {0, 100, 1000, 10000};
+    std::vector<uint8_t> region(16 * FlashDriver::PAGE_SIZE);
+    for (size_t i = 0; i < region.size(); i++)
+        region[i] = uint8_t(i * 7 + 3);
+    FlashCmd pp;
+    pp.opcode   = OP_PAGE_PROGRAM;
+    pp.has_addr = true;
+
+    std::vector<ProgResult> res;
+    uint32_t sector = 0x100000;
+    for (int poll : intervals) {
+        drv.ready_interval = poll;
+
+        uint64_t t0 = drv.ticks;
+        uint64_t r0 = drv.ready_polls;
+        drv.program_cmd(pp, sector, region.data(), region.size());
+        res.push_back({"program_host", poll, region.size(), drv.ticks - t0,
+                       drv.ready_polls - r0});
+        drv.tick(5);
+
+        // the queue's polls are not counted, the engine reads the status itself
+        t0 = drv.ticks;
+        drv.queue_program(pp, sector + 0x8000, region.data(), region.size(), poll);
+        res.push_back({"program_queued", poll, region.size(), drv.ticks - t0, 0});
+        drv.tick(5);
+
+        t0 = drv.ticks;
+        r0 = drv.ready_polls;
+        drv.erase_sector(sector);
+        res.push_back({"sector_erase", poll, FlashDriver::SECTOR_SIZE, drv.ticks - t0,
+                       drv.ready_polls - r0});
+        drv.tick(5);
+        sector += FlashDriver::SECTOR_SIZE;
+    }
+    drv.ready_interval = 0;
+    return res;
+}
+
+void write_prog_csv(std::ostream& os, const std::vector<ProgResult>& res, int prescaler,
+                    double mhz) {
+    os << "op,poll_interval,bytes,cycles,us,kbps,status_reads,poll_cycles\n";
+    for (const ProgResult& r : res)
+        os << r.op << "," << r.poll << "," << r.bytes << "," << r.cycles << ","
+           << r.cycles / mhz << "," << (r.cycles ? r.bytes * mhz * 1000.0 / r.cycles : 0.0)
+           << "," << r.status_reads << ","
+           << r.status_reads * 16 * 2 * (prescaler + 1) << "\n";
+}
+
+struct MultiResult {
+    int      devices;
+    int      pages;
+    uint64_t cycles;
+};
+
+std::vector<MultiResult> multi_bench(FlashDriver& drv, int num_flash) {
+    const int pages = 16;
+    std::vector<uint8_t> region(pages * FlashDriver::PAGE_SIZE);
+    for (size_t i = 0; i < region.size(); i++)
+        region[i] = uint8_t(i * 3 + 1);
+
+    std::vector<MultiResult> res;
+    drv.set_poll(OP_READ_STATUS, FlashDriver::SR_WIP, 0x00, 0, 0);
+    for (int k = 1; k <= num_flash; k++) {
+        std::vector<FlashDesc> chain;
+        for (int i = 0; i < pages; i++) {
+            FlashDesc wren;
+            wren.cmd.opcode    = OP_WRITE_ENABLE;
+            wren.cmd.data_mode = MODE_NONE;
+            wren.cs            = i % k;
+            FlashDesc pp;
+            pp.cmd.opcode   = OP_PAGE_PROGRAM;
+            pp.cmd.has_addr = true;
+            pp.cmd.addr     = 0x010000 * k + (i / k) * FlashDriver::PAGE_SIZE;
+            pp.len          = FlashDriver::PAGE_SIZE;
+            pp.poll         = true;
+            pp.cs           = i % k;
+            chain.push_back(wren);
+            chain.push_back(pp);
+        }
+        uint64_t t0 = drv.ticks;
+        drv.run_chain(chain, region.data(), nullptr);
+        res.push_back({k, pages, drv.ticks - t0});
+        drv.tick(5);
+    }
+    return res;
+}
+
+void write_multi_csv(std::ostream& os, const std::vector<MultiResult>& res, int num_flash,
+                     double mhz) {
+    os << "num_flash,devices,pages,bytes,cycles,cycles_per_page,mbps\n";
+    for (const MultiResult& r : res) {
+        uint64_t bytes = uint64_t(r.pages) * FlashDriver::PAGE_SIZE;
+        os << num_flash << "," << r.devices << "," << r.pages << "," << bytes << ","
+           << r.cycles << "," << double(r.cycles) / r.pages << ","
+           << (r.cycles ? bytes * mhz / r.cycles : 0.0) << "\n";
+    }
+}
+
+// Value of +name=<value>, or def when absent
+std::string plusarg(const char* name, const std::string& def) {
+    std::string key = std::string(name) + "=";
+    const char* arg = Verilated::commandArgsPlusMatch(key.c_str());
+    if (!arg || !arg[0]) return def;
+    return std::string(arg + 1 + key.size());
+}
+
+void write_csv(std::ostream& os, const std::vector<BenchResult>& res, double mhz) {
+    os << "op,opcode,prescaler,data_mode,dummy,bytes,cycles,cycles_per_byte,"
+          "mbps,first_data_cycles,idle,cmd,addr,mode,dummy_cycles,data_tx,"
+          "data_rx,wait_edge\n";
+    for (const BenchResult& r : res) {
+        double cpb = double(r.cycles) / r.pt.bytes;
+        os << r.pt.op << ",0x" << std::hex << int(r.pt.opcode) << std::dec
+           << "," << r.pt.prescaler << "," << r.pt.data_mode
+           << "," << r.pt.dummy << "," << r.pt.bytes
+           << "," << r.cycles << "," << cpb << "," << mhz / cpb
+           << "," << r.first_rx
+           << "," << r.ph.idle << "," << r.ph.cmd << "," << r.ph.addr
+           << "," << r.ph.mode << "," << r.ph.dummy << "," << r.ph.data_tx
+           << "," << r.ph.data_rx << "," << r.ph.wait_edge << "\n";
+    }
+}
+
+void write_json(std::ostream& os, const std::vector<BenchResult>& res, double mhz) {
+    os << "{\n  \"core_mhz\": " << mhz << ",\n  \"results\": [\n";
+    for (size_t i = 0; i < res.size(); i++) {
+        const BenchResult& r = res[i];
+        double cpb = double(r.cycles) / r.pt.bytes;
+        os << "    {\"op\": \"" << r.pt.op << "\", \"opcode\": " << int(r.pt.opcode)
+           << ", \"prescaler\": " << r.pt.prescaler
+           << ", \"data_mode\": " << r.pt.data_mode
+           << ", \"dummy\": " << r.pt.dummy
+           << ", \"bytes\": " << r.pt.bytes
+           << ", \"cycles\": " << r.cycles
+           << ", \"cycles_per_byte\": " << cpb
+           << ", \"mbps\": " << mhz / cpb
+           << ", \"first_data_cycles\": " << r.first_rx
+           << ", \"phases\": {\"idle\": " << r.ph.idle
+           << ", \"cmd\": " << r.ph.cmd << ", \"addr\": " << r.ph.addr
+           << ", \"mode\": " << r.ph.mode << ", \"dummy\": " << r.ph.dummy
+           << ", \"data_tx\": " << r.ph.data_tx
+           << ", \"data_rx\": " << r.ph.data_rx
+           << ", \"wait_edge\": " << r.ph.wait_edge << "}}"
+           << (i + 1 < res.size() ? "," : "") << "\n";
+    }
+    os << "  ]\n}\n";
+}
+
+int main(int argc, char **argv) {
+    Verilated::commandArgs(argc, argv);
+
+    TbTrace* tfp = new TbTrace;
+    tfp->init();
+
+    auto t_start = std::chrono::steady_clock::now();
+    Vspi_flash_top *dut = new Vspi_flash_top;
+    tfp->open(dut, "bench");
+
+    double      mhz    = std::atof(plusarg("core_mhz", "100").c_str());
+    std::string format = plusarg("format", "csv");
+    std::string out    = plusarg("out", "");
+
+    FlashDriver drv(dut, tfp, sim_time);
+
+    // Reset
+    dut->rstn            = 0;
+    dut->start_i         = 0;
+    dut->addr_mode_i     = 0;
+    dut->continuous_i    = 0;
+    dut->stop_i          = 0;
+    dut->clr_status_i    = 0;
+    dut->data_tx_valid_i = 0;
+    dut->data_rx_ready_i = 0;
+    dut->flush_tx_i      = 0;
+    dut->flush_rx_i      = 0;
+    dut->tx_ae_thresh_i  = 0;
+    dut->rx_af_thresh_i  = 0;
+    dut->irq_en_i        = 0;
+    dut->desc_i          = 0;
+    dut->desc_valid_i    = 0;
+    dut->seq_start_i     = 0;
+    dut->poll_start_i    = 0;
+    dut->poll_cmd_i      = 0;
+    dut->poll_mask_i     = 0;
+    dut->poll_match_i    = 0;
+    dut->poll_interval_i = 0;
+    dut->poll_max_i      = 0;
+    dut->dtr_i           = 0;
+    dut->addr_4b_i       = 0;
+    dut->mode_en_i       = 0;
+    dut->mode_bits_i     = 0;
+    dut->no_cmd_i        = 0;
+    dut->cs_i            = 0;
+    dut->desc_cs_i       = 0;
+    drv.tick(10);
+    dut->rstn = 1;
+    drv.tick(10);
+    double startup_us = us_since(t_start);
+
+    if (Verilated::commandArgsPlusMatch("mem")[0]) {
+        std::vector<MemResult> res = mem_bench(drv, startup_us);
+
+        std::ofstream file;
+        if (!out.empty()) file.open(out);
+        write_mem_csv(out.empty() ? std::cout : file, res, FlashMem::find()->size());
+
+        dut->final();
+        tfp->close();
+        delete tfp;
+        delete dut;
+        return (drv.timeouts > 0) ? 1 : 0;
+    }
+
+    if (Verilated::commandArgsPlusMatch("prog")[0]) {
+        drv.busy_timeout = uint64_t(4000000) * uint64_t(mhz);   // 4 s, tSE max 1 s
+        std::vector<ProgResult> res = prog_bench(drv);
+
+        std::ofstream file;
+        if (!out.empty()) file.open(out);
+        write_prog_csv(out.empty() ? std::cout : file, res, drv.prescaler, mhz);
+
+        dut->final();
+        tfp->close();
+        delete tfp;
+        delete dut;
+        return (drv.timeouts > 0) ? 1 : 0;
+    }
+
+    if (Verilated::commandArgsPlusMatch("multi")[0]) {
+        int num_flash = std::atoi(plusarg("num_flash", "2").c_str());
+        std::vector<MultiResult> res = multi_bench(drv, num_flash);
+
+        std::ofstream file;
+        if (!out.empty()) file.open(out);
+        write_multi_csv(out.empty() ? std::cout : file, res, num_flash, mhz);
+
+        dut->final();
+        tfp->close();
+        delete tfp;
+        delete dut;
+        return (drv.timeouts > 0) ? 1 : 0;
+    }
+
+    if (Verilated::commandArgsPlusMatch("stall")[0]) {
+        int depth = std::atoi(plusarg("fifo_depth", "8").c_str());
+        std::vector<StallResult> res = stall_sweep(drv);
+
+        std::ofstream file;
+        if (!out.empty()) file.open(out);
+        write_stall_csv(out.empty() ? std::cout : file, res, depth);
+
+        dut->final();
+        tfp->close();
+        delete tfp;
+        delete dut;
+        return (drv.timeouts > 0) ? 1 : 0;
+    }
+
+    // -------------------------------------------------------------------------
+    // Sweep
+    // -------------------------------------------------------------------------
+    const int prescalers[] = {0, 1, 2, 4, 8};
+    const int data_modes[] = {MODE_STD, MODE_DUAL, MODE_QUAD};
+    const int dummies[]    = {0, 4, 8, 16};
+    const int lengths[]    = {1, 4, 16, 64, 256};
+
+    std::vector<BenchPoint> points;
+    for (int p : prescalers)
+        for (int m : data_modes)
+            for (int n : lengths) {
+                for (int d : dummies) {
+                    uint8_t op = (m == MODE_QUAD) ? OP_QUAD_READ
+                               : (m == MODE_DUAL) ? OP_DUAL_READ
+                               : d                ? OP_FAST_READ
+                               :                    OP_READ;
+                    points.push_back({"read", op, p, m, d, n});
+                }
+                if (m != MODE_DUAL)
+                    points.push_back({"program",
+                                  uint8_t(m == MODE_QUAD ? OP_QUAD_PROGRAM
+                                                         : OP_PAGE_PROGRAM),
+                                  p, m, 0, n});
+            }
+
+    std::vector<uint8_t> buf(FlashDriver::MAX_XFER, 0xA5);
+    std::vector<BenchResult> results;
+
+    for (const BenchPoint& pt : points) {
+        FlashCmd c;
+        c.opcode    = pt.opcode;
+        c.data_mode = pt.data_mode;
+        c.read      = std::strcmp(pt.op, "read") == 0;
+        c.has_addr  = true;
+        c.addr      = 0x001000;
+        c.dummy     = pt.dummy;
+
+        drv.prescaler = pt.prescaler;
+        if (!c.read)
+            drv.write_enable();
+
+        BenchResult r;
+        r.pt = pt;
+        drv.phases = &r.ph;
+        drv.transfer(c, buf.data(), buf.data(), pt.bytes);
+        drv.phases = nullptr;
+        r.cycles   = drv.last_cycles;
+        r.first_rx = drv.last_first_rx;
+        results.push_back(r);
+        drv.tick(5);
+    }
+
+    // -------------------------------------------------------------------------
+    // Bulk reads: per-transaction overhead
+    // -------------------------------------------------------------------------
+    std::vector<uint8_t> image(64 * 1024);
+    for (int p : {0, 4})
+        for (int m : data_modes) {
+            uint8_t op = (m == MODE_QUAD) ? OP_QUAD_READ
+                       : (m == MODE_DUAL) ? OP_DUAL_READ
+                       :                    OP_FAST_READ;
+            results.push_back(bulk_read(drv, "bulk_256", op, p, m, 0, image, 256));
+            drv.tick(5);
+            results.push_back(bulk_read(drv, "bulk_max", op, p, m, 0, image,
+                                        FlashDriver::MAX_XFER));
+            drv.tick(5);
+            results.push_back(bulk_read(drv, "bulk_stream", op, p, m, 0, image, 0));
+            drv.tick(5);
+        }
+
+    // -------------------------------------------------------------------------
+    // DTR against SDR I/O reads at the same SPI clock
+    // -------------------------------------------------------------------------
+    for (int p : {0, 1, 4})
+        for (int m : data_modes)
+            for (int n : {256, 4096})
+                for (int dtr = 0; dtr < 2; dtr++) {
+                    FlashCmd c;
+                    c.data_mode = m;
+                    c.addr_mode = m;
+                    c.read      = true;
+                    c.has_addr  = true;
+                    c.addr      = 0x001000;
+                    c.dtr       = dtr;
+                    if (m == MODE_QUAD) {
+                        c.opcode = dtr ? OP_DTR_QUAD_IO_READ : OP_QUAD_IO_READ;
+                        c.dummy  = dtr ? FlashDriver::DTR_QUAD_IO_DUMMY
+                                       : FlashDriver::QUAD_IO_DUMMY;
+                    } else {
+                        c.opcode = (m == MODE_DUAL) ? (dtr ? OP_DTR_DUAL_IO_READ : OP_DUAL_IO_READ)
+                                                    : (dtr ? OP_DTR_READ : OP_FAST_READ);
+                        c.dummy  = dtr ? FlashDriver::DTR_DUMMY : FlashDriver::FAST_DUMMY;
+                    }
+                    drv.prescaler = p;
+
+                    BenchResult r;
+                    r.pt = {dtr ? "read_dtr" : "read_io", c.opcode, p, m, c.dummy, n};
+                    drv.phases = &r.ph;
+                    drv.transfer(c, nullptr, buf.data(), n);
+                    drv.phases = nullptr;
+                    r.cycles   = drv.last_cycles;
+                    r.first_rx = drv.last_first_rx;
+                    results.push_back(r);
+                    drv.tick(5);
+                }
+
+    // -------------------------------------------------------------------------
+    // Small random reads: 0xEB on every read against continuous read
+    // -------------------------------------------------------------------------
+    const int rand_reads = 64;
+    for (int p : {0, 1, 4})
+        for (int n : {4, 8, 16, 32})
+            for (int cont = 0; cont < 2; cont++) {
+                BenchResult r;
+                r.pt       = {cont ? "rand_cont" : "rand_eb", OP_QUAD_IO_READ, p, MODE_QUAD,
+                              FlashDriver::QUAD_IO_DUMMY, n * rand_reads};
+                r.cycles   = 0;
+                r.first_rx = 0;
+                drv.prescaler = p;
+                drv.phases = &r.ph;
+                uint32_t seed = 0x1D872B41;
+                for (int i = 0; i < rand_reads; i++) {
+                    seed = seed * 1664525u + 1013904223u;
+                    uint32_t addr = (seed >> 8) & 0x0FFFFC;   // first 1 MB, word aligned
+                    if (cont)   // the last read leaves continuous read
+                        drv.quad_io_read_cont(addr, buf.data(), n, i + 1 < rand_reads);
+                    else
+                        drv.quad_io_read(addr, buf.data(), n);
+                    r.cycles   += drv.last_cycles;
+                    r.first_rx += drv.last_first_rx;
+                }
+                drv.phases = nullptr;
+                r.first_rx /= rand_reads;
+                results.push_back(r);
+                drv.tick(5);
+            }
+
+    // -------------------------------------------------------------------------
+    // Multi-page programs: host-driven WREN/PP/status round trips against one
+    // chain on the command queue
+    // -------------------------------------------------------------------------
+    std::vector<uint8_t> region(4096, 0x5A);
+    for (int p : {0, 4})
+        for (int m : {MODE_STD, MODE_QUAD}) {
+            FlashCmd c;
+            c.opcode    = (m == MODE_QUAD) ? OP_QUAD_PROGRAM : OP_PAGE_PROGRAM;
+            c.data_mode = m;
+            c.has_addr  = true;
+            drv.prescaler = p;
+
+            for (int queued = 0; queued < 2; queued++) {
+                BenchResult r;
+                r.pt       = {queued ? "prog_queued" : "prog_host", c.opcode, p, m, 0,
+                              int(region.size())};
+                r.first_rx = 0;
+                drv.phases = &r.ph;
+                uint64_t t0 = drv.ticks;
+                if (queued)
+                    drv.queue_program(c, 0x010000, region.data(), region.size());
+                else
+                    drv.program_cmd(c, 0x010000, region.data(), region.size());
+                r.cycles   = drv.ticks - t0;
+                drv.phases = nullptr;
+                results.push_back(r);
+                drv.tick(5);
+            }
+        }
+
+    // -------------------------------------------------------------------------
+    // Report
+    // -------------------------------------------------------------------------
+    std::ofstream file;
+    if (!out.empty()) file.open(out);
+    std::ostream& os = out.empty() ? std::cout : file;
+
+    if (format == "json")
+        write_json(os, results, mhz);
+    else
+        write_csv(os, results, mhz);
+
+    dut->final();
+    tfp->close();
+    delete tfp;
+    delete dut;
+    return (drv.timeouts > 0) ? 1 : 0;
+}
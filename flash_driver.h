@@ -0,0 +1,979 @@
+// Transaction-level driver for Vspi_flash_top.
+//
+// Wraps the user interface of spi_flash_wrapper (command_i, data_mode_i,
+// start_i, status_o, TX/RX FIFO handshakes) into flash operations. Data is
+// streamed through the TX/RX FIFOs while the transfer runs, so transfers
+// are only limited by the wrapper's data_count_i field, not by the FIFO
+// depths (TX_FIFO_DEPTH/RX_FIFO_DEPTH of spi_flash_top).
+// stream_read() uses the wrapper's continuous mode and has no length limit.
+// run_chain() hands a list of commands to the wrapper's command queue
+// (spi_master_seq) and only waits once, for the end of the whole chain.
+// poll() and wait_ready() use the wrapper's status auto-poll instead of
+// reading the status register from here. quad_io_read_cont() keeps the flash
+// in continuous read, later reads skip the opcode. Programs and erases wait
+// for WIP to clear before they return, as the flash ignores other commands
+// while it is busy.
+//
+// cs selects the flash (spi_csn<cs>) of every command the driver issues;
+// a FlashDesc may name another one. Use one driver per device, on the same
+// dut, so addr_4b and cont_read follow each device's own state.
+//
+// Byte order on the FIFO ports: the first byte on the wire is bits [31:24]
+// of a word. A trailing partial RX word holds its bytes in the low bits,
+// a trailing partial TX word must hold them in the high bits.
+#pragma once
+
+#include "Vspi_flash_top.h"
+#include "tb_trace.h"
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <utility>
+#include <vector>
+
+// Flash opcodes understood by qspi_nor_sim_model
+enum FlashOpcode : uint8_t {
+    OP_WRITE_DISABLE = 0x04,
+    OP_WRITE_ENABLE  = 0x06,
+    OP_READ_STATUS   = 0x05,
+    OP_READ_FLAG     = 0x70,
+    OP_READ_JEDEC    = 0x9F,
+    OP_READ          = 0x03,
+    OP_FAST_READ     = 0x0B,
+    OP_DUAL_READ     = 0x3B,   // 1-1-2
+    OP_DUAL_IO_READ  = 0xBB,   // 1-2-2
+    OP_QUAD_READ     = 0x6B,   // 1-1-4
+    OP_QUAD_IO_READ  = 0xEB,   // 1-4-4
+    OP_DTR_READ      = 0x0D,   // 1-1D-1D
+    OP_DTR_DUAL_IO_READ = 0xBD,   // 1-2D-2D
+    OP_DTR_QUAD_IO_READ = 0xED,   // 1-4D-4D
+    OP_PAGE_PROGRAM  = 0x02,
+    OP_QUAD_PROGRAM  = 0x32,   // 1-1-4
+    OP_SECTOR_ERASE  = 0xD8,
+    OP_READ_4B       = 0x13,   // 4-byte address opcodes
+    OP_FAST_READ_4B  = 0x0C,
+    OP_QUAD_IO_READ_4B = 0xEC,
+    OP_PAGE_PROGRAM_4B = 0x12,
+    OP_SECTOR_ERASE_4B = 0xDC,
+    OP_ENTER_4B_MODE = 0xB7,
+    OP_EXIT_4B_MODE  = 0xE9,
+    OP_CHIP_ERASE    = 0xC7,
+    OP_RESET_ENABLE  = 0x66,
+    OP_RESET         = 0x99,
+    OP_MODE_RESET    = 0xFF    // ends continuous read, see exit_cont_read()
+};
+
+// data_mode_i encoding of spi_flash_wrapper
+enum FlashDataMode : uint8_t {
+    MODE_NONE = 0,
+    MODE_STD  = 1,
+    MODE_DUAL = 2,
+    MODE_QUAD = 3
+};
+
+// One command as seen by spi_flash_wrapper
+struct FlashCmd {
+    uint8_t  opcode    = 0;
+    uint8_t  data_mode = MODE_STD;  // lanes of the data phase
+    uint8_t  addr_mode = MODE_STD;  // lanes of the address phase
+    bool     read      = false;     // rd_wr_i
+    bool     has_addr  = false;
+    uint32_t addr      = 0;
+    uint8_t  dummy     = 0;         // dummy_cycle_i
+    bool     dtr       = false;     // dtr_i: address and data on both edges
+    bool     addr_4b   = false;     // addr_4b_i: 32-bit address phase
+    bool     mode_en   = false;     // mode_en_i: mode_bits after the address
+    uint8_t  mode_bits = 0;
+    bool     no_cmd    = false;     // no_cmd_i: no opcode, flash in continuous read
+};
+
+// One entry of a command chain: the command and its data length in bytes
+struct FlashDesc {
+    FlashCmd cmd;
+    size_t   len  = 0;
+    bool     poll = false;   // DESC_POLL: auto-poll (set_poll()) after the command
+    int      cs   = -1;      // desc_cs_i; -1: the driver's cs
+};
+
+// Cycles spent in each spi_master_controller state, from ctrl_status_o
+struct PhaseCycles {
+    uint64_t idle = 0, cmd = 0, addr = 0, mode = 0, dummy = 0;
+    uint64_t data_tx = 0, data_rx = 0, wait_edge = 0;
+
+    void sample(uint8_t st) {
+        if      (st & 0x80) wait_edge++;
+        else if (st & 0x40) data_rx++;
+        else if (st & 0x20) data_tx++;
+        else if (st & 0x10) dummy++;
+        else if (st & 0x08) mode++;
+        else if (st & 0x04) addr++;
+        else if (st & 0x02) cmd++;
+        else                idle++;
+    }
+};
+
+class FlashDriver {
+public:
+    static const uint32_t PAGE_SIZE   = 256;
+    static const uint32_t SECTOR_SIZE = 64 * 1024;
+    // data_count_i allows 8191 bytes; keep split transfers word aligned
+    static const uint32_t MAX_XFER    = 8188;
+    static const int      FAST_DUMMY  = 8;
+    static const int      QUAD_IO_DUMMY = 10;
+    static const int      DTR_DUMMY   = 6;      // 0x0D, 0xBD
+    static const int      DTR_QUAD_IO_DUMMY = 8;
+    static const int      QUAD_IO_MODE_CLOCKS = 2;  // first 2 of QUAD_IO_DUMMY
+    static const int      DTR_QUAD_IO_MODE_CLOCKS = 1;  // first of DTR_QUAD_IO_DUMMY
+    static const uint8_t  MODE_BITS_CONT = 0xA0;    // M5..M4 = 10: stay in continuous read
+    static const uint8_t  SR_WIP      = 0x01;   // status register 1, write in progress
+
+    FlashDriver(Vspi_flash_top* dut, TbTrace* tfp, vluint64_t& time)
+        : dut(dut), tfp(tfp), time(time) {}
+
+    // -------------------------------------------------------------------------
+    // Clocking
+    // -------------------------------------------------------------------------
+    void tick(int n = 1) {
+        for (int i = 0; i < n; i++) {
+            dut->clk = 0;
+            dut->eval();
+            tfp->dump(time++);
+            if (phases) phases->sample(dut->ctrl_status_o);
+            dut->clk = 1;
+            dut->eval();
+            tfp->dump(time++);
+            ticks++;
+        }
+    }
+
+    // -------------------------------------------------------------------------
+    // Flash operations
+    // -------------------------------------------------------------------------
+    bool command(uint8_t opcode) {
+        FlashCmd c;
+        c.opcode    = opcode;
+        c.data_mode = MODE_NONE;
+        return transfer(c, nullptr, nullptr, 0);
+    }
+
+    bool write_enable()  { return command(OP_WRITE_ENABLE); }
+    bool write_disable() { return command(OP_WRITE_DISABLE); }
+
+    uint8_t read_status() { return read_reg(OP_READ_STATUS); }
+    uint8_t read_flag_status() { return read_reg(OP_READ_FLAG); }
+
+    // Manufacturer ID in [23:16], device ID in [15:0]
+    uint32_t read_jedec() {
+        uint8_t id[3] = {0, 0, 0};
+        FlashCmd c;
+        c.opcode = OP_READ_JEDEC;
+        c.read   = true;
+        transfer(c, nullptr, id, sizeof(id));
+        return (uint32_t(id[0]) << 16) | (uint32_t(id[1]) << 8) | id[2];
+    }
+
+    bool read(uint32_t addr, uint8_t* data, size_t len) {
+        FlashCmd c;
+        c.opcode   = OP_READ;
+        c.read     = true;
+        c.has_addr = true;
+        return read_cmd(c, addr, data, len);
+    }
+
+    bool fast_read(uint32_t addr, uint8_t* data, size_t len) {
+        FlashCmd c;
+        c.opcode   = OP_FAST_READ;
+        c.read     = true;
+        c.has_addr = true;
+        c.dummy    = FAST_DUMMY;
+        return read_cmd(c, addr, data, len);
+    }
+
+    // Dual Output Fast Read: address on IO0, data on IO0-1
+    bool dual_read(uint32_t addr, uint8_t* data, size_t len) {
+        FlashCmd c;
+        c.opcode    = OP_DUAL_READ;
+        c.data_mode = MODE_DUAL;
+        c.read      = true;
+        c.has_addr  = true;
+        c.dummy     = FAST_DUMMY;
+        return read_cmd(c, addr, data, len);
+    }
+
+    // Dual I/O Fast Read: address and data on IO0-1
+    bool dual_io_read(uint32_t addr, uint8_t* data, size_t len) {
+        FlashCmd c;
+        c.opcode    = OP_DUAL_IO_READ;
+        c.data_mode = MODE_DUAL;
+        c.addr_mode = MODE_DUAL;
+        c.read      = true;
+        c.has_addr  = true;
+        c.dummy     = FAST_DUMMY;
+        return read_cmd(c, addr, data, len);
+    }
+
+    // Quad Output Fast Read: address on IO0, data on IO0-3
+    bool quad_read(uint32_t addr, uint8_t* data, size_t len) {
+        FlashCmd c;
+        c.opcode    = OP_QUAD_READ;
+        c.data_mode = MODE_QUAD;
+        c.read      = true;
+        c.has_addr  = true;
+        c.dummy     = FAST_DUMMY;
+        return read_cmd(c, addr, data, len);
+    }
+
+    // Quad I/O Fast Read: address and data on IO0-3
+    bool quad_io_read(uint32_t addr, uint8_t* data, size_t len) {
+        FlashCmd c;
+        c.opcode    = OP_QUAD_IO_READ;
+        c.data_mode = MODE_QUAD;
+        c.addr_mode = MODE_QUAD;
+        c.read      = true;
+        c.has_addr  = true;
+        c.dummy     = QUAD_IO_DUMMY;
+        return read_cmd(c, addr, data, len);
+    }
+
+    // Quad I/O Fast Read in continuous read: mode bits 0xA0 after the
+    // address keep the flash in it, so every read after the first sends no
+    // opcode. stay = false sends mode bits 0x00 instead, the flash leaves
+    // continuous read after this read. Any other command needs
+    // exit_cont_read() first.
+    bool quad_io_read_cont(uint32_t addr, uint8_t* data, size_t len, bool stay = true) {
+        FlashCmd c;
+        c.opcode    = OP_QUAD_IO_READ;
+        c.data_mode = MODE_QUAD;
+        c.addr_mode = MODE_QUAD;
+        c.read      = true;
+        c.has_addr  = true;
+        c.dummy     = QUAD_IO_DUMMY - QUAD_IO_MODE_CLOCKS;
+        return read_cont(c, addr, data, len, stay);
+    }
+
+    // Same with DTR Quad I/O Fast Read (0xED): the mode bits go on both
+    // edges of one clock
+    bool dtr_quad_io_read_cont(uint32_t addr, uint8_t* data, size_t len, bool stay = true) {
+        FlashCmd c;
+        c.opcode    = OP_DTR_QUAD_IO_READ;
+        c.data_mode = MODE_QUAD;
+        c.addr_mode = MODE_QUAD;
+        c.read      = true;
+        c.has_addr  = true;
+        c.dummy     = DTR_QUAD_IO_DUMMY - DTR_QUAD_IO_MODE_CLOCKS;
+        c.dtr       = true;
+        return read_cont(c, addr, data, len, stay);
+    }
+
+    // Mode bit reset: opcode 0xFF and an all-ones address on IO0, at least
+    // 32 clocks of IO0 high, end continuous read whatever the read command
+    // was. Outside continuous read the flash ignores opcode 0xFF.
+    bool exit_cont_read() {
+        FlashCmd c;
+        c.opcode    = OP_MODE_RESET;
+        c.data_mode = MODE_NONE;
+        c.has_addr  = true;
+        c.addr      = 0xFFFFFFFF;
+        bool ok = transfer(c, nullptr, nullptr, 0);
+        if (ok) cont_read = false;
+        return ok;
+    }
+
+    // DTR Fast Read: address and data on IO0, both clock edges
+    bool dtr_read(uint32_t addr, uint8_t* data, size_t len) {
+        FlashCmd c;
+        c.opcode   = OP_DTR_READ;
+        c.read     = true;
+        c.has_addr = true;
+        c.dummy    = DTR_DUMMY;
+        c.dtr      = true;
+        return read_cmd(c, addr, data, len);
+    }
+
+    // DTR Dual I/O Fast Read: address and data on IO0-1, both clock edges
+    bool dtr_dual_io_read(uint32_t addr, uint8_t* data, size_t len) {
+        FlashCmd c;
+        c.opcode    = OP_DTR_DUAL_IO_READ;
+        c.data_mode = MODE_DUAL;
+        c.addr_mode = MODE_DUAL;
+        c.read      = true;
+        c.has_addr  = true;
+        c.dummy     = DTR_DUMMY;
+        c.dtr       = true;
+        return read_cmd(c, addr, data, len);
+    }
+
+    // DTR Quad I/O Fast Read: address and data on IO0-3, both clock edges
+    bool dtr_quad_io_read(uint32_t addr, uint8_t* data, size_t len) {
+        FlashCmd c;
+        c.opcode    = OP_DTR_QUAD_IO_READ;
+        c.data_mode = MODE_QUAD;
+        c.addr_mode = MODE_QUAD;
+        c.read      = true;
+        c.has_addr  = true;
+        c.dummy     = DTR_QUAD_IO_DUMMY;
+        c.dtr       = true;
+        return read_cmd(c, addr, data, len);
+    }
+
+    // Page program with WREN before every page; splits at page boundaries
+    bool program(uint32_t addr, const uint8_t* data, size_t len) {
+        FlashCmd c;
+        c.opcode   = OP_PAGE_PROGRAM;
+        c.has_addr = true;
+        return program_cmd(c, addr, data, len);
+    }
+
+    // Quad Input Fast Program, same page handling as program()
+    bool quad_program(uint32_t addr, const uint8_t* data, size_t len) {
+        FlashCmd c;
+        c.opcode    = OP_QUAD_PROGRAM;
+        c.data_mode = MODE_QUAD;
+        c.has_addr  = true;
+        return program_cmd(c, addr, data, len);
+    }
+
+    bool erase_sector(uint32_t addr) {
+        FlashCmd c;
+        c.opcode    = OP_SECTOR_ERASE;
+        c.data_mode = MODE_NONE;
+        c.has_addr  = true;
+        c.addr      = addr;
+        return write_enable() && transfer(c, nullptr, nullptr, 0) && wait_ready();
+    }
+
+    // 4-byte address mode: every command with an address sends 32 bits
+    // until exit_4b_mode(), and so does this driver
+    bool enter_4b_mode() {
+        bool ok = command(OP_ENTER_4B_MODE);
+        addr_4b = ok;
+        return ok;
+    }
+
+    bool exit_4b_mode() {
+        bool ok = command(OP_EXIT_4B_MODE);
+        if (ok) addr_4b = false;
+        return ok;
+    }
+
+    // Dedicated 4-byte address opcodes, independent of the mode
+    bool read_4b(uint32_t addr, uint8_t* data, size_t len) {
+        FlashCmd c;
+        c.opcode   = OP_READ_4B;
+        c.read     = true;
+        c.has_addr = true;
+        c.addr_4b  = true;
+        return read_cmd(c, addr, data, len);
+    }
+
+    bool fast_read_4b(uint32_t addr, uint8_t* data, size_t len) {
+        FlashCmd c;
+        c.opcode   = OP_FAST_READ_4B;
+        c.read     = true;
+        c.has_addr = true;
+        c.addr_4b  = true;
+        c.dummy    = FAST_DUMMY;
+        return read_cmd(c, addr, data, len);
+    }
+
+    bool quad_io_read_4b(uint32_t addr, uint8_t* data, size_t len) {
+        FlashCmd c;
+        c.opcode    = OP_QUAD_IO_READ_4B;
+        c.data_mode = MODE_QUAD;
+        c.addr_mode = MODE_QUAD;
+        c.read      = true;
+        c.has_addr  = true;
+        c.addr_4b   = true;
+        c.dummy     = QUAD_IO_DUMMY;
+        return read_cmd(c, addr, data, len);
+    }
+
+    bool program_4b(uint32_t addr, const uint8_t* data, size_t len) {
+        FlashCmd c;
+        c.opcode   = OP_PAGE_PROGRAM_4B;
+        c.has_addr = true;
+        c.addr_4b  = true;
+        return program_cmd(c, addr, data, len);
+    }
+
+    bool erase_sector_4b(uint32_t addr) {
+        FlashCmd c;
+        c.opcode    = OP_SECTOR_ERASE_4B;
+        c.data_mode = MODE_NONE;
+        c.has_addr  = true;
+        c.addr_4b   = true;
+        c.addr      = addr;
+        return write_enable() && transfer(c, nullptr, nullptr, 0) && wait_ready();
+    }
+
+    bool erase_chip() {
+        return write_enable() && command(OP_CHIP_ERASE) && wait_ready();
+    }
+
+    std::vector<uint8_t> read(uint32_t addr, size_t len) {
+        std::vector<uint8_t> v(len);
+        read(addr, v.data(), len);
+        return v;
+    }
+
+    std::vector<uint8_t> fast_read(uint32_t addr, size_t len) {
+        std::vector<uint8_t> v(len);
+        fast_read(addr, v.data(), len);
+        return v;
+    }
+
+    bool program(uint32_t addr, const std::vector<uint8_t>& v) {
+        return program(addr, v.data(), v.size());
+    }
+
+    // Any read command, split into MAX_XFER transactions
+    bool read_cmd(FlashCmd c, uint32_t addr, uint8_t* data, size_t len) {
+        bool ok = true;
+        while (len > 0) {
+            size_t n = (len > MAX_XFER) ? MAX_XFER : len;
+            c.addr = addr;
+            ok &= transfer(c, nullptr, data, n);
+            addr += n;
+            data += n;
+            len  -= n;
+        }
+        return ok;
+    }
+
+    // An I/O read command with mode bits, split into MAX_XFER transactions;
+    // only the last one sends 0x00 when !stay
+    bool read_cont(FlashCmd c, uint32_t addr, uint8_t* data, size_t len, bool stay) {
+        bool ok = true;
+        c.mode_en = true;
+        while (len > 0) {
+            size_t n = (len > MAX_XFER) ? MAX_XFER : len;
+            c.addr      = addr;
+            c.no_cmd    = cont_read;
+            c.mode_bits = (stay || len > n) ? MODE_BITS_CONT : 0x00;
+            ok &= transfer(c, nullptr, data, n);
+            cont_read = c.mode_bits == MODE_BITS_CONT;
+            addr += n;
+            data += n;
+            len  -= n;
+        }
+        return ok;
+    }
+
+    // Any program command, split at page boundaries, WREN before each page
+    bool program_cmd(FlashCmd c, uint32_t addr, const uint8_t* data, size_t len) {
+        bool ok = true;
+        while (len > 0) {
+            size_t room = PAGE_SIZE - (addr % PAGE_SIZE);
+            size_t n = (len > room) ? room : len;
+            if (n > MAX_XFER) n = MAX_XFER;
+            c.addr = addr;
+            c.read = false;
+            ok &= write_enable();
+            ok &= transfer(c, data, nullptr, n);
+            ok &= wait_ready();
+            addr += n;
+            data += n;
+            len  -= n;
+        }
+        return ok;
+    }
+
+    // One continuous read (continuous_i) of any length: words are drained
+    // until len bytes are in, then stop_i ends the transfer after the word in
+    // flight. The flash has been clocked for a few words more than asked for;
+    // those are read out of the RX FIFO and dropped.
+    bool stream_read(FlashCmd c, uint32_t addr, uint8_t* data, size_t len,
+                     int64_t timeout = 0) {
+        size_t words    = (len + 3) / 4;
+        size_t rx_words = 0;
+
+        c.addr = addr;
+        c.read = true;
+        setup(c, 4);
+        if (timeout <= 0) timeout = int64_t(xfer_timeout(len));
+
+        bool started = false;
+        bool stopped = false;
+        bool done    = false;
+        uint64_t cycle = 0;
+        last_first_rx = 0;
+        while (timeout-- > 0) {
+            dut->start_i      = !started;
+            dut->continuous_i = !started;
+            dut->stop_i       = started && !stopped && rx_words >= words;
+            stopped          |= dut->stop_i;
+
+            bool pop = dut->data_rx_valid_o;
+            uint32_t rd = dut->data_rx_o;
+            dut->data_rx_ready_i = pop;
+
+            tick();
+            started = true;
+            cycle++;
+
+            if (pop) {
+                if (rx_words == 0) last_first_rx = cycle;
+                if (rx_words < words) {
+                    // every word is full, the tail is cut on the byte side
+                    uint8_t w[4];
+                    for (int b = 0; b < 4; b++)
+                        w[b] = (rd >> (24 - 8 * b)) & 0xFF;
+                    for (size_t b = 0; b < 4 && rx_words * 4 + b < len; b++)
+                        data[rx_words * 4 + b] = w[b];
+                }
+                rx_words++;
+            }
+
+            if (dut->status_o && !dut->data_rx_valid_o) {
+                done = stopped;
+                break;
+            }
+        }
+        last_cycles = cycle;
+
+        dut->start_i         = 0;
+        dut->continuous_i    = 0;
+        dut->stop_i          = 0;
+        dut->data_rx_ready_i = 0;
+
+        if (!done) {
+            std::cout << "  [TIMEOUT] stream cmd 0x" << std::hex << int(c.opcode)
+                      << " status=" << int(dut->status_o) << std::dec
+                      << " rx " << rx_words << "/" << words << " words\n";
+            timed_out();
+        }
+
+        clear_status();
+        return done;
+    }
+
+    // -------------------------------------------------------------------------
+    // Status auto-poll
+    // -------------------------------------------------------------------------
+
+    // Poll configuration used by poll() and by DESC_POLL commands
+    void set_poll(uint8_t cmd, uint8_t mask, uint8_t match, int interval, int max_reads) {
+        dut->poll_cmd_i      = cmd;
+        dut->poll_mask_i     = mask;
+        dut->poll_match_i    = match;
+        dut->poll_interval_i = interval;
+        dut->poll_max_i      = max_reads;
+    }
+
+    // Poll until (status & mask) == match; false on timeout. The number of
+    // status reads is left in last_poll_count.
+    bool poll(uint8_t cmd, uint8_t mask, uint8_t match, int interval = 0,
+              int max_reads = 0, int64_t timeout = 0) {
+        set_poll(cmd, mask, match, interval, max_reads);
+        if (timeout <= 0)
+            timeout = 200000 + int64_t(max_reads ? max_reads : 1000) * (interval + 40 * (prescaler + 1));
+
+        dut->cs_i         = cs;
+        dut->poll_start_i = 1;
+        tick();
+        dut->poll_start_i = 0;
+        bool done = false;
+        while (timeout-- > 0) {
+            if (dut->status_o) {
+                done = true;
+                break;
+            }
+            tick();
+        }
+        last_poll_count = dut->poll_count_o;
+        bool matched = done && !dut->poll_timeout_o;
+
+        if (!done) {
+            std::cout << "  [TIMEOUT] poll 0x" << std::hex << int(cmd) << std::dec
+                      << " after " << last_poll_count << " reads\n";
+            timed_out();
+        }
+        clear_status();
+        return matched;
+    }
+
+    // Wait for WIP to clear, reading the status every interval cycles; allows
+    // busy_timeout cycles on top of the usual poll timeout
+    bool wait_ready(int interval = -1) {
+        if (interval < 0) interval = ready_interval;
+        int64_t timeout = 200000 + 1000 * int64_t(interval + 40 * (prescaler + 1)) +
+                          int64_t(busy_timeout);
+        bool ok = poll(OP_READ_STATUS, SR_WIP, 0x00, interval, 0, timeout);
+        ready_polls += last_poll_count;
+        return ok;
+    }
+
+    // Program through the command queue: WREN and one program command per
+    // page, all in one chain; each program is followed by a WIP auto-poll
+    bool queue_program(FlashCmd c, uint32_t addr, const uint8_t* data, size_t len,
+                       int interval = 0) {
+        std::vector<FlashDesc> chain;
+        FlashDesc wren;
+        wren.cmd.opcode    = OP_WRITE_ENABLE;
+        wren.cmd.data_mode = MODE_NONE;
+        while (len > 0) {
+            size_t room = PAGE_SIZE - (addr % PAGE_SIZE);
+            size_t n = (len > room) ? room : len;
+            FlashDesc pp;
+            pp.cmd      = c;
+            pp.cmd.addr = addr;
+            pp.cmd.read = false;
+            pp.len      = n;
+            pp.poll     = true;
+            chain.push_back(wren);
+            chain.push_back(pp);
+            addr += n;
+            len  -= n;
+        }
+        set_poll(OP_READ_STATUS, SR_WIP, 0x00, interval, 0);
+        return run_chain(chain, data, nullptr);
+    }
+
+    // -------------------------------------------------------------------------
+    // Run a chain of commands on the command queue. tx holds the data of the
+    // write commands back to back, rx receives the data of the read commands
+    // back to back; each command's data starts on a new FIFO word. Returns
+    // once status_o is set and all RX words are in, then clears status.
+    // -------------------------------------------------------------------------
+    bool run_chain(const std::vector<FlashDesc>& chain, const uint8_t* tx, uint8_t* rx,
+                   int64_t timeout = 0) {
+        std::vector<uint32_t> tx_fifo;
+        std::vector<std::pair<uint8_t*, size_t>> rx_seg;
+        size_t total = 0;
+        size_t rx_total_words = 0;
+        size_t polls = 0;
+        for (const FlashDesc& d : chain) {
+            total += d.len;
+            polls += d.poll;
+            if (d.len == 0) continue;
+            if (d.cmd.read) {
+                rx_seg.push_back({rx, d.len});
+                rx += d.len;
+                rx_total_words += (d.len + 3) / 4;
+            } else {
+                for (size_t i = 0; i < (d.len + 3) / 4; i++)
+                    tx_fifo.push_back(pack(tx, d.len, i));
+                tx += d.len;
+            }
+        }
+        if (timeout <= 0)
+            timeout = int64_t(xfer_timeout(total)) + 1000 * int64_t(chain.size()) +
+                      int64_t(polls * busy_timeout);
+
+        dut->start_i         = 0;
+        dut->data_tx_valid_i = 0;
+        dut->data_rx_ready_i = 0;
+        dut->prescaler_i     = prescaler;
+
+        size_t descs    = 0;
+        size_t tx_words = 0;
+        size_t rx_words = 0;
+        size_t seg = 0, seg_word = 0;
+
+        bool started = false;
+        bool done    = false;
+        uint64_t cycle = 0;
+        last_cs_high  = 0;
+        last_first_rx = 0;
+        while (timeout-- > 0) {
+            bool push_desc = descs < chain.size() && dut->desc_ready_o;
+            dut->desc_i       = push_desc ? encode(chain[descs], descs + 1 == chain.size(), addr_4b)
+                                          : 0;
+            dut->desc_cs_i    = push_desc && chain[descs].cs >= 0 ? chain[descs].cs : cs;
+            dut->desc_valid_i = push_desc;
+
+            // start once the queue holds the whole chain or is full
+            dut->seq_start_i  = !started && !push_desc;
+
+            bool push = tx_words < tx_fifo.size() && dut->data_tx_ready_o;
+            dut->data_tx_i       = push ? tx_fifo[tx_words] : 0;
+            dut->data_tx_valid_i = push;
+
+            bool pop = rx_words < rx_total_words && dut->data_rx_valid_o;
+            uint32_t rd = dut->data_rx_o;
+            dut->data_rx_ready_i = pop;
+
+            bool cs_high = dut->seq_busy_o && !dut->busy_o;
+
+            tick();
+            cycle++;
+            started |= dut->seq_start_i;
+            if (started && cs_high) last_cs_high++;
+            if (push_desc) descs++;
+            if (push) tx_words++;
+            if (pop) {
+                if (rx_words == 0) last_first_rx = cycle;
+                unpack(rx_seg[seg].first, rx_seg[seg].second, seg_word++, rd);
+                rx_words++;
+                if (seg_word * 4 >= rx_seg[seg].second) {
+                    seg++;
+                    seg_word = 0;
+                }
+            }
+
+            if (started && dut->status_o && rx_words == rx_total_words) {
+                done = (descs == chain.size());
+                break;
+            }
+        }
+        last_cycles = cycle;
+
+        dut->desc_valid_i    = 0;
+        dut->seq_start_i     = 0;
+        dut->data_tx_valid_i = 0;
+        dut->data_rx_ready_i = 0;
+
+        if (!done) {
+            std::cout << "  [TIMEOUT] chain of " << chain.size() << " commands, "
+                      << descs << " queued, rx " << rx_words << "/" << rx_total_words
+                      << " words\n";
+            timed_out();
+        }
+
+        clear_status();
+        return done;
+    }
+
+    // -------------------------------------------------------------------------
+    // One CS-low transaction of up to MAX_XFER data bytes. TX data is pushed
+    // and RX data drained every cycle while the controller runs; returns once
+    // status_o is set and all RX words are collected, then clears status.
+    // -------------------------------------------------------------------------
+    bool transfer(const FlashCmd& c, const uint8_t* tx, uint8_t* rx, size_t len,
+                  int64_t timeout = 0) {
+        size_t words    = (len + 3) / 4;
+        size_t tx_words = 0;
+        size_t rx_words = 0;
+
+        setup(c, len);
+        if (timeout <= 0) timeout = int64_t(xfer_timeout(len));
+
+        // Preload so the data phase does not start on an empty TX FIFO
+        if (!c.read) {
+            while (tx_words < words && dut->data_tx_ready_o) {
+                dut->data_tx_i       = pack(tx, len, tx_words);
+                dut->data_tx_valid_i = 1;
+                tick();
+                tx_words++;
+            }
+            dut->data_tx_valid_i = 0;
+        }
+
+        bool started = false;
+        bool done    = false;
+        int  away    = 0;
+        uint64_t cycle = 0;
+        last_first_rx = 0;
+        while (timeout-- > 0) {
+            dut->start_i = !started;
+
+            bool serve = (away == 0);
+            bool push = serve && !c.read && tx_words < words && dut->data_tx_ready_o;
+            dut->data_tx_i       = push ? pack(tx, len, tx_words) : 0;
+            dut->data_tx_valid_i = push;
+
+            bool pop = serve && c.read && rx_words < words && dut->data_rx_valid_o;
+            uint32_t rd = dut->data_rx_o;
+            dut->data_rx_ready_i = pop;
+
+            tick();
+            started = true;
+            cycle++;
+
+            if (away > 0)
+                away--;
+            else if (!push && !pop)
+                away = poll_interval;
+
+            if (push) tx_words++;
+            if (pop) {
+                if (rx_words == 0) last_first_rx = cycle;
+                unpack(rx, len, rx_words++, rd);
+            }
+
+            if (dut->status_o && (!c.read || rx_words == words)) {
+                done = true;
+                break;
+            }
+        }
+        last_cycles = cycle;
+
+        dut->start_i         = 0;
+        dut->data_tx_valid_i = 0;
+        dut->data_rx_ready_i = 0;
+
+        if (!done) {
+            std::cout << "  [TIMEOUT] cmd 0x" << std::hex << int(c.opcode)
+                      << " status=" << int(dut->status_o) << std::dec
+                      << " rx " << rx_words << "/" << words << " words\n";
+            timed_out();
+        }
+
+        clear_status();
+        return done;
+    }
+
+    void clear_status() {
+        dut->clr_status_i = 1;
+        tick();
+        dut->clr_status_i = 0;
+        tick(2);
+    }
+
+    int timeouts = 0;
+    int prescaler = 4;
+
+    // Chip select of the flash this driver talks to (cs_i, 0..NUM_FLASH-1)
+    int cs = 0;
+
+    // Host model for transfer(): after a cycle in which it found nothing to
+    // push or pop, the host is away for poll_interval cycles (a busy bus
+    // master polling the FIFOs). 0 serves the FIFOs every cycle.
+    int poll_interval = 0;
+
+    // Per-transfer timing in system clock cycles, counted from the start
+    // pulse: until status_o and all RX words are in, and until the first RX
+    // word left the FIFO (0 for writes)
+    uint64_t last_cycles   = 0;
+    uint64_t last_first_rx = 0;
+
+    // Status reads issued by the last poll()
+    uint64_t last_poll_count = 0;
+
+    // wait_ready(): poll interval of the programs and erases, extra timeout
+    // (e.g. the flash's tBE in cycles) and status reads since construction
+    int      ready_interval = 0;
+    uint64_t busy_timeout   = 0;
+    uint64_t ready_polls    = 0;
+
+    // Cycles run_chain() spent with CS high between the commands of a chain
+    uint64_t last_cs_high  = 0;
+
+    // Clock cycles run by tick() since construction
+    uint64_t ticks = 0;
+
+    // The flash is in 4-byte address mode (enter_4b_mode())
+    bool addr_4b = false;
+
+    // The flash is in continuous read (quad_io_read_cont())
+    bool cont_read = false;
+
+    // When set, every tick() is attributed to the controller state
+    PhaseCycles* phases = nullptr;
+
+    // Checkpoints (tb_top +save / +restore): settings, counters and the flash
+    // state above, through the same streams as FlashMem::save()
+    template <class Os>
+    void save(Os& os) {
+        state([&](void* p, size_t n) { os.write(p, n); });
+    }
+
+    template <class Is>
+    void restore(Is& is) {
+        state([&](void* p, size_t n) { is.read(p, n); });
+    }
+
+private:
+    template <class F>
+    void state(F io) {
+        io(&timeouts, sizeof(timeouts));
+        io(&prescaler, sizeof(prescaler));
+        io(&cs, sizeof(cs));
+        io(&poll_interval, sizeof(poll_interval));
+        io(&ticks, sizeof(ticks));
+        io(&addr_4b, sizeof(addr_4b));
+        io(&cont_read, sizeof(cont_read));
+        io(&ready_interval, sizeof(ready_interval));
+        io(&busy_timeout, sizeof(busy_timeout));
+        io(&ready_polls, sizeof(ready_polls));
+    }
+
+    // Twice the single-lane SPI time of len bytes, plus room for the phases
+    uint64_t xfer_timeout(size_t len) const {
+        return 200000 + uint64_t(len) * 32 * (uint64_t(prescaler) + 1);
+    }
+
+    uint8_t read_reg(uint8_t opcode) {
+        uint8_t v = 0;
+        FlashCmd c;
+        c.opcode = opcode;
+        c.read   = true;
+        transfer(c, nullptr, &v, 1);
+        return v;
+    }
+
+    void setup(const FlashCmd& c, size_t len) {
+        dut->cs_i            = cs;
+        dut->command_i       = c.opcode;
+        dut->data_mode_i     = len ? c.data_mode : MODE_NONE;
+        dut->addr_mode_i     = c.addr_mode;
+        dut->rd_wr_i         = c.read;
+        dut->dummy_cycle_i   = c.dummy;
+        dut->dtr_i           = c.dtr;
+        dut->data_count_i    = len ? len - 1 : 0;
+        dut->continuous_i    = 0;
+        dut->stop_i          = 0;
+        dut->seq_start_i     = 0;
+        dut->desc_valid_i    = 0;
+        dut->poll_start_i    = 0;
+        dut->has_addr_i      = c.has_addr;
+        dut->addr_4b_i       = c.addr_4b || addr_4b;
+        dut->mode_en_i       = c.mode_en;
+        dut->mode_bits_i     = c.mode_bits;
+        dut->no_cmd_i        = c.no_cmd;
+        dut->addr_i          = c.addr;
+        dut->prescaler_i     = prescaler;
+        dut->clr_status_i    = 0;
+        dut->start_i         = 0;
+        dut->data_tx_valid_i = 0;
+        dut->data_rx_ready_i = 0;
+    }
+
+    // spi_master_seq descriptor, see the layout there; 4-byte addresses
+    // reach the first 256 MB
+    static uint64_t encode(const FlashDesc& desc, bool last, bool addr_4b) {
+        const FlashCmd& c = desc.cmd;
+        size_t len = desc.len;
+        uint64_t d = c.opcode;
+        d |= uint64_t(c.addr & 0xFFFFFF) << 8;
+        d |= uint64_t(len ? len - 1 : 0) << 32;
+        d |= uint64_t(len ? c.data_mode : MODE_NONE) << 45;
+        d |= uint64_t(c.addr_mode & 3) << 47;
+        d |= uint64_t(c.read) << 49;
+        d |= uint64_t(c.has_addr) << 50;
+        d |= uint64_t(c.dummy & 0x1F) << 51;
+        d |= uint64_t(last) << 56;
+        d |= uint64_t(desc.poll) << 57;
+        d |= uint64_t(c.dtr) << 58;
+        d |= uint64_t(c.addr_4b || addr_4b) << 59;
+        d |= uint64_t((c.addr >> 24) & 0xF) << 60;
+        return d;
+    }
+
+    // Counted in timeouts; with +trace_ring the last cycles go to a file
+    void timed_out() {
+        timeouts++;
+        tfp->capture("driver timeout");
+    }
+
+    // Word i of a byte stream, first byte in the MSBs
+    static uint32_t pack(const uint8_t* p, size_t len, size_t i) {
+        uint32_t w = 0;
+        for (size_t b = 0; b < 4; b++) {
+            size_t k = i * 4 + b;
+            w |= uint32_t(k < len ? p[k] : 0) << (24 - 8 * b);
+        }
+        return w;
+    }
+
+    static void unpack(uint8_t* p, size_t len, size_t i, uint32_t w) {
+        size_t n = len - i * 4;
+        if (n > 4) n = 4;
+        for (size_t b = 0; b < n; b++)
+            p[i * 4 + b] = (w >> (8 * (n - 1 - b))) & 0xFF;
+    }
+
+    Vspi_flash_top* dut;
+    TbTrace*        tfp;
+    vluint64_t&     time;
+};
@@ -0,0 +1,38 @@
+// DPI-C side of flash_mem.h, imported by qspi_nor_sim_model.
+//
+// Linked into every model that contains the flash (see Makefile, DPI_SRC).
+// The chandle the model holds is the handle of its instance's FlashMem
+// (FlashMem::from_handle()), which stays valid across a checkpoint restore.
+#include "flash_mem.h"
+
+extern "C" {
+
+void* flash_mem_open(const char* path, unsigned int size) {
+    return FlashMem::instance(path, size)->dpi_handle();
+}
+
+unsigned char flash_mem_read(void* h, unsigned int addr) {
+    return FlashMem::from_handle(h)->read(addr);
+}
+
+void flash_mem_write(void* h, unsigned int addr, unsigned char data) {
+    FlashMem::from_handle(h)->write(addr, data);
+}
+
+void flash_mem_erase(void* h, unsigned int addr, unsigned int len) {
+    FlashMem::from_handle(h)->erase(addr, len);
+}
+
+void flash_mem_erase_all(void* h) {
+    FlashMem::from_handle(h)->erase_all();
+}
+
+int flash_mem_load(void* h, const char* path, unsigned int addr) {
+    return int(FlashMem::from_handle(h)->map_image(path, addr));
+}
+
+int flash_mem_dump(void* h, const char* path, int diff) {
+    return FlashMem::from_handle(h)->dump(path, diff != 0) ? 0 : -1;
+}
+
+}
@@ -0,0 +1,396 @@
+// Sparse backing store for qspi_nor_sim_model, shared with the testbenches.
+//
+// The model keeps no memory array of its own; it reads, writes and erases
+// through the DPI-C functions in flash_mem.cpp, which operate on one FlashMem
+// per model instance. Pages are allocated on first write, so creating a model
+// costs the same for 256 KB and 256 MB. An erased or never-written byte reads
+// 0xFF.
+//
+// Sector erase drops the pages of the sector. Chip erase only bumps an epoch
+// counter: pages written under an older epoch read as erased and are wiped
+// when next written, so it is O(1) whatever the size and the number of pages.
+//
+// An image file can be mapped under the store (map_image(), +flash_image in
+// the model): it is mmap'ed read-only and not copied, a page is only copied
+// out of it when it is first written or erased. dump() writes the flash to a
+// file, either whole or as a diff against the image with only the pages that
+// changed:
+//
+//   "FLDIFF01", then per page: u32 addr, u32 len, len bytes (little-endian)
+//
+// Testbenches get at a model's store with FlashMem::find(), e.g. to preload
+// or dump an image without going through the SPI bus. save_all() and
+// restore_all() carry every store through a simulation checkpoint.
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <unordered_map>
+#include <vector>
+
+class FlashMem {
+public:
+    static constexpr uint32_t PAGE_SIZE = 4096;
+
+    explicit FlashMem(uint32_t size) : mem_size(size) {}
+
+    ~FlashMem() { unmap_image(); }
+
+    uint32_t size() const { return mem_size; }
+
+    // Pages currently holding data, for reporting
+    size_t pages() const {
+        size_t n = 0;
+        for (const auto& p : page_map)
+            n += (p.second->epoch == epoch);
+        return n;
+    }
+
+    uint8_t read(uint32_t addr) const {
+        if (addr >= mem_size) return 0xFF;
+        auto it = page_map.find(addr / PAGE_SIZE);
+        if (it != page_map.end() && it->second->epoch == epoch)
+            return it->second->data[addr % PAGE_SIZE];
+        return image_visible() ? image_byte(addr) : 0xFF;
+    }
+
+    void write(uint32_t addr, uint8_t data) {
+        if (addr >= mem_size) return;
+        touch(addr / PAGE_SIZE)->data[addr % PAGE_SIZE] = data;
+    }
+
+    // Erase [addr, addr + len). Whole pages outside the image are dropped,
+    // others are filled with 0xFF.
+    void erase(uint32_t addr, uint32_t len) {
+        if (addr >= mem_size) return;
+        uint32_t end = (len > mem_size - addr) ? mem_size : addr + len;
+        while (addr < end) {
+            uint32_t pg  = addr / PAGE_SIZE;
+            uint32_t off = addr % PAGE_SIZE;
+            uint32_t n   = std::min(PAGE_SIZE - off, end - addr);
+            bool     img = image_visible() && image_overlaps(pg);
+            auto it = page_map.find(pg);
+            if (n == PAGE_SIZE && !img) {
+                if (it != page_map.end())
+                    page_map.erase(it);
+            } else if (img || (it != page_map.end() && it->second->epoch == epoch)) {
+                std::memset(touch(pg)->data + off, 0xFF, n);
+            }
+            addr += n;
+        }
+    }
+
+    void erase_all() { epoch++; }
+
+    // Copy what is still read from the image into pages and let go of the
+    // file, e.g. before it is removed; the content does not change, later
+    // diff dumps and checkpoints no longer refer to the image.
+    void detach_image() {
+        if (image_visible())
+            for (uint32_t pg = img_addr / PAGE_SIZE; pg <= (img_addr + img_len - 1) / PAGE_SIZE; pg++)
+                if (!page_map.count(pg) || page_map[pg]->epoch != epoch) touch(pg);
+        unmap_image();
+        img_path.clear();
+    }
+
+    // -------------------------------------------------------------------------
+    // Image file and dumps
+    // -------------------------------------------------------------------------
+
+    // Map path at addr; bytes past the end of the flash are ignored. Returns
+    // the number of bytes mapped, or -1 when the file cannot be mapped.
+    long map_image(const std::string& path, uint32_t addr) {
+        unmap_image();
+        if (addr >= mem_size) return -1;
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) return -1;
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size == 0) {
+            close(fd);
+            return -1;
+        }
+        void* p = mmap(nullptr, size_t(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (p == MAP_FAILED) return -1;
+
+        img_map   = static_cast<const uint8_t*>(p);
+        img_path  = path;
+        img_size  = size_t(st.st_size);
+        img_addr  = addr;
+        img_len   = uint32_t(std::min<uint64_t>(img_size, mem_size - addr));
+        img_epoch = epoch;
+
+        // the image is the content at time zero: drop what it covers
+        for (uint32_t pg = img_addr / PAGE_SIZE; pg <= (img_addr + img_len - 1) / PAGE_SIZE; pg++)
+            page_map.erase(pg);
+        return long(img_len);
+    }
+
+    // Whole flash up to the last byte that may be programmed (trailing
+    // erased pages are left out), or only the pages that differ from the
+    // image (from 0xFF without one). Returns false on a write error.
+    bool dump(const std::string& path, bool diff) const {
+        FILE* f = std::fopen(path.c_str(), "wb");
+        if (!f) return false;
+        uint8_t cur[PAGE_SIZE], orig[PAGE_SIZE];
+        bool ok = true;
+
+        if (!diff) {
+            uint32_t end = image_visible() ? img_addr + img_len : 0;
+            for (const auto& p : page_map)
+                if (p.second->epoch == epoch)
+                    end = uint32_t(std::max<uint64_t>(end, std::min<uint64_t>(
+                              uint64_t(p.first + 1) * PAGE_SIZE, mem_size)));
+            for (uint32_t a = 0; a < end && ok; a += PAGE_SIZE) {
+                uint32_t n = std::min(uint32_t(PAGE_SIZE), end - a);
+                read_page(a / PAGE_SIZE, cur);
+                ok = std::fwrite(cur, 1, n, f) == n;
+            }
+            return (std::fclose(f) == 0) && ok;
+        }
+
+        // pages that can differ: written ones, and the image once erased
+        std::set<uint32_t> cand;
+        for (const auto& p : page_map)
+            if (p.second->epoch == epoch)
+                cand.insert(p.first);
+        if (img_map && !image_visible())
+            for (uint32_t pg = img_addr / PAGE_SIZE; pg <= (img_addr + img_len - 1) / PAGE_SIZE; pg++)
+                cand.insert(pg);
+
+        ok = std::fwrite("FLDIFF01", 1, 8, f) == 8;
+        for (uint32_t pg : cand) {
+            if (!ok) break;
+            read_page(pg, cur);
+            image_page(pg, orig);
+            if (std::memcmp(cur, orig, PAGE_SIZE) == 0)
+                continue;
+            uint32_t a   = pg * PAGE_SIZE;
+            uint32_t len = std::min(uint32_t(PAGE_SIZE), mem_size - a);
+            uint8_t  hdr[8];
+            for (int i = 0; i < 4; i++) {
+                hdr[i]     = uint8_t(a >> (8 * i));
+                hdr[4 + i] = uint8_t(len >> (8 * i));
+            }
+            ok = std::fwrite(hdr, 1, 8, f) == 8 && std::fwrite(cur, 1, len, f) == len;
+        }
+        return (std::fclose(f) == 0) && ok;
+    }
+
+    // -------------------------------------------------------------------------
+    // Checkpoints, through any stream with write(const void*, size_t) and
+    // read(void*, size_t), e.g. VerilatedSave / VerilatedRestore. The current
+    // pages are saved, the image only by name: it is mapped again on restore
+    // and must not have changed.
+    // -------------------------------------------------------------------------
+    template <class Os>
+    void save(Os& os) const {
+        uint8_t  mapped = img_map != nullptr;
+        uint32_t len    = uint32_t(img_path.size());
+        os.write(&epoch, sizeof(epoch));
+        os.write(&mapped, sizeof(mapped));
+        os.write(&len, sizeof(len));
+        os.write(img_path.data(), len);
+        os.write(&img_addr, sizeof(img_addr));
+        os.write(&img_epoch, sizeof(img_epoch));
+
+        uint32_t n = uint32_t(pages());
+        os.write(&n, sizeof(n));
+        for (const auto& p : page_map) {
+            if (p.second->epoch != epoch) continue;
+            os.write(&p.first, sizeof(p.first));
+            os.write(p.second->data, PAGE_SIZE);
+        }
+    }
+
+    // false when the image cannot be mapped again
+    template <class Is>
+    bool restore(Is& is) {
+        uint8_t  mapped = 0;
+        uint32_t len    = 0;
+        uint32_t e      = 0;
+        is.read(&e, sizeof(e));
+        is.read(&mapped, sizeof(mapped));
+        is.read(&len, sizeof(len));
+        std::string path(len, '\0');
+        is.read(&path[0], len);
+        uint32_t addr = 0, ie = 0;
+        is.read(&addr, sizeof(addr));
+        is.read(&ie, sizeof(ie));
+
+        page_map.clear();
+        unmap_image();
+        bool ok = !mapped || map_image(path, addr) >= 0;
+        epoch     = e;
+        img_epoch = ie;
+
+        uint32_t n = 0;
+        is.read(&n, sizeof(n));
+        for (uint32_t i = 0; i < n; i++) {
+            uint32_t pg = 0;
+            is.read(&pg, sizeof(pg));
+            std::unique_ptr<Page>& p = page_map[pg];
+            p.reset(new Page);
+            p->epoch = epoch;
+            is.read(p->data, PAGE_SIZE);
+        }
+        return ok;
+    }
+
+    // -------------------------------------------------------------------------
+    // Instances, by hierarchical path of the model ($sformatf("%m"))
+    // -------------------------------------------------------------------------
+    static std::map<std::string, std::unique_ptr<FlashMem>>& instances() {
+        static std::map<std::string, std::unique_ptr<FlashMem>> inst;
+        return inst;
+    }
+
+    // The model holds a handle, not the pointer: handles count up in the
+    // order the stores are opened, so a restored model, whose initial blocks
+    // do not run again, still finds its stores
+    static std::vector<FlashMem*>& handles() {
+        static std::vector<FlashMem*> h;
+        return h;
+    }
+
+    static FlashMem* instance(const std::string& path, uint32_t size) {
+        std::unique_ptr<FlashMem>& m = instances()[path];
+        if (!m) {
+            m.reset(new FlashMem(size));
+            m->path = path;
+            handles().push_back(m.get());
+            m->handle = handles().size();
+        }
+        return m.get();
+    }
+
+    static FlashMem* from_handle(void* h) {
+        return handles()[reinterpret_cast<uintptr_t>(h) - 1];
+    }
+
+    void* dpi_handle() const { return reinterpret_cast<void*>(handle); }
+
+    // Every store, in handle order
+    template <class Os>
+    static void save_all(Os& os) {
+        uint32_t n = uint32_t(handles().size());
+        os.write(&n, sizeof(n));
+        for (const FlashMem* m : handles()) {
+            uint32_t len = uint32_t(m->path.size());
+            os.write(&len, sizeof(len));
+            os.write(m->path.data(), len);
+            os.write(&m->mem_size, sizeof(m->mem_size));
+            m->save(os);
+        }
+    }
+
+    // Into a process whose model has not opened any store yet
+    template <class Is>
+    static bool restore_all(Is& is) {
+        uint32_t n = 0;
+        bool ok = true;
+        is.read(&n, sizeof(n));
+        for (uint32_t i = 0; i < n; i++) {
+            uint32_t len = 0, size = 0;
+            is.read(&len, sizeof(len));
+            std::string path(len, '\0');
+            is.read(&path[0], len);
+            is.read(&size, sizeof(size));
+            FlashMem* m = instance(path, size);
+            ok &= (m->handle == i + 1) && m->restore(is);
+        }
+        return ok;
+    }
+
+    // First store whose model path ends in suffix ("" for the first one)
+    static FlashMem* find(const std::string& suffix = "") {
+        for (auto& i : instances()) {
+            const std::string& path = i.first;
+            if (path.size() >= suffix.size() &&
+                path.compare(path.size() - suffix.size(), suffix.size(), suffix) == 0)
+                return i.second.get();
+        }
+        return nullptr;
+    }
+
+private:
+    struct Page {
+        uint32_t epoch = 0;
+        uint8_t  data[PAGE_SIZE];
+    };
+
+    // Current copy of page pg, taken from the image or 0xFF when missing
+    Page* touch(uint32_t pg) {
+        std::unique_ptr<Page>& p = page_map[pg];
+        if (!p) p.reset(new Page);
+        if (p->epoch != epoch) {
+            if (image_visible())
+                image_page(pg, p->data);
+            else
+                std::memset(p->data, 0xFF, PAGE_SIZE);
+            p->epoch = epoch;
+        }
+        return p.get();
+    }
+
+    void read_page(uint32_t pg, uint8_t* out) const {
+        auto it = page_map.find(pg);
+        if (it != page_map.end() && it->second->epoch == epoch)
+            std::memcpy(out, it->second->data, PAGE_SIZE);
+        else if (image_visible())
+            image_page(pg, out);
+        else
+            std::memset(out, 0xFF, PAGE_SIZE);
+    }
+
+    // Image content of page pg, 0xFF outside the image
+    void image_page(uint32_t pg, uint8_t* out) const {
+        std::memset(out, 0xFF, PAGE_SIZE);
+        if (!image_overlaps(pg)) return;
+        uint32_t a  = pg * PAGE_SIZE;
+        uint32_t lo = std::max(a, img_addr);
+        uint32_t hi = uint32_t(std::min<uint64_t>(uint64_t(a) + PAGE_SIZE,
+                                                  uint64_t(img_addr) + img_len));
+        std::memcpy(out + (lo - a), img_map + (lo - img_addr), hi - lo);
+    }
+
+    uint8_t image_byte(uint32_t addr) const {
+        return (addr >= img_addr && addr - img_addr < img_len) ? img_map[addr - img_addr] : 0xFF;
+    }
+
+    bool image_overlaps(uint32_t pg) const {
+        return img_map && uint64_t(pg + 1) * PAGE_SIZE > img_addr &&
+               uint64_t(pg) * PAGE_SIZE < uint64_t(img_addr) + img_len;
+    }
+
+    // a chip erase hides the image for good
+    bool image_visible() const { return img_map && img_epoch == epoch; }
+
+    void unmap_image() {
+        if (img_map) munmap(const_cast<uint8_t*>(img_map), img_size);
+        img_map = nullptr;
+    }
+
+    uint32_t mem_size;
+    std::string path;
+    uintptr_t   handle = 0;
+    uint32_t epoch = 1;   // new pages start stale and are filled on first write
+    std::unordered_map<uint32_t, std::unique_ptr<Page>> page_map;
+
+    const uint8_t* img_map   = nullptr;
+    std::string    img_path;
+    size_t         img_size  = 0;
+    uint32_t       img_addr  = 0;
+    uint32_t       img_len   = 0;
+    uint32_t       img_epoch = 0;
+};
@@ -0,0 +1,66 @@
+// Reference model of the flash contents for scoreboarding spi_flash_top.
+//
+// Plain NOR semantics, independent of qspi_nor_sim_model: a page program
+// only clears bits (new = old & data) and wraps at the end of its 256-byte
+// page, erases set bytes to 0xFF, and both need the write enable latch, which
+// they clear again. Reads wrap at the end of the flash. Only the contents and
+// WEL are modelled, not timing.
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class FlashRef {
+public:
+    static const uint32_t PAGE_SIZE   = 256;
+    static const uint32_t SECTOR_SIZE = 64 * 1024;
+
+    explicit FlashRef(uint32_t size) : mem(size, 0xFF) {}
+
+    uint32_t size() const { return uint32_t(mem.size()); }
+
+    void write_enable()  { wel = true; }
+    void write_disable() { wel = false; }
+    void reset()         { wel = false; }
+
+    // Page program of len > 0 bytes starting at addr
+    void program(uint32_t addr, const uint8_t* data, size_t len) {
+        if (wel) {
+            uint32_t page = addr & ~(PAGE_SIZE - 1);
+            for (size_t i = 0; i < len; i++) {
+                uint32_t a = page | ((addr + uint32_t(i)) & (PAGE_SIZE - 1));
+                if (a < mem.size())
+                    mem[a] &= data[i];
+            }
+        }
+        wel = false;
+    }
+
+    void erase_sector(uint32_t addr) {
+        if (!wel) return;
+        uint32_t base = addr & ~(SECTOR_SIZE - 1);
+        for (uint32_t a = base; a < base + SECTOR_SIZE && a < mem.size(); a++)
+            mem[a] = 0xFF;
+        wel = false;
+    }
+
+    void erase_chip() {
+        if (!wel) return;
+        std::fill(mem.begin(), mem.end(), 0xFF);
+        wel = false;
+    }
+
+    uint8_t read(uint32_t addr) const { return mem[addr % mem.size()]; }
+
+    void read(uint32_t addr, uint8_t* out, size_t len) const {
+        for (size_t i = 0; i < len; i++)
+            out[i] = read(addr + uint32_t(i));
+    }
+
+    bool wel = false;
+
+private:
+    std::vector<uint8_t> mem;
+};
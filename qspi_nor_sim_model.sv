@@ -1,16 +1,92 @@
+// Flash contents live in a sparse C++ page store (flash_mem.h / flash_mem.cpp,
+// DPI-C), so MEMORY_SIZE does not cost anything until pages are written and
+// erases do not loop over the array.
+//
+//   +flash_image=<file>        map a binary image into the flash at time zero
+//   +flash_image_addr=<hex>    where the image starts (default 0)
+//   +flash_dump=<file>         write the flash contents at final()
+//   +flash_dump_diff           ... only the pages that differ from the image
+//
+// Addresses are 3 bytes, or 4 bytes for the dedicated 4-byte opcodes
+// (0x13, 0x0C, 0x3C, 0xBC, 0x6C, 0xEC, 0x12, 0x34, 0xDC) and for every
+// command between Enter (0xB7) and Exit (0xE9) 4-byte address mode; flag
+// status bit 0 shows the mode.
+//
+// DTR reads (0x0D, 0xBD, 0xED) take the address and return data on both
+// clock edges, starting on the rising edge after the opcode; dummy cycles
+// are whole clocks.
+//
+// The I/O reads (0xBB, 0xEB, 0xBC, 0xEC) take mode bits M7..M0 on the
+// address lanes in the first dummy clocks (2 for quad, 4 for dual); the DTR
+// ones (0xBD, 0xED) on both edges of the first 1 (quad) or 2 (dual). With
+// M5..M4 = 10 (e.g. 0xA0) the flash stays in continuous read: the next
+// transactions start with the address of the same command, no opcode. Any
+// other mode bits leave it after the current read. The mode bit reset does
+// that without knowing the command: IO0 high, the other lines low, through
+// the address and mode clocks (at most 20, FlashDriver sends 32). Outside
+// continuous read the same bits are opcode 0xFF, ignored.
+//
+// Programs and erases start when CS rises, an erase only right after its
+// opcode or address (more clocks cancel it). They keep the device busy for
+// tPP, tSE or tBE, counted in clk_i cycles: PP_BUSY_CYCLES, SE_BUSY_CYCLES
+// and CE_BUSY_CYCLES (0: done when CS rises), or set for every instance at
+// run time:
+//
+//   +flash_clk_mhz=<n>         clk_i frequency for the _us plusargs (default 100)
+//   +flash_tpp_us=<n>          page program time
+//   +flash_tse_us=<n>          64 KB sector erase time
+//   +flash_tbe_us=<n>          chip (bulk) erase time
+//   +flash_timing=typ          MT25Q typical times: tPP 120 us, tSE 150 ms,
+//                              tBE 153 s; the _us plusargs override them
+//
+// While busy, status register 1 bit 0 (WIP) is set and flag status bit 7
+// (ready) is clear. Only Read Status (0x05) and Read Flag Status (0x70) are
+// accepted then; any other command is ignored up to CS high.
+//
+// IMAGE_EN = 0 leaves +flash_image and +flash_dump to another instance, for
+// boards with several devices.
+//
+// Logs through spi_log.svh with tag FLASH: erases at info, commands and
+// addresses at debug, every programmed byte at trace (+spi_log_flash=5).
+`include "spi_log.svh"
+
+`ifndef SPI_LOG_MAX_FLASH
+`define SPI_LOG_MAX_FLASH `SPI_LOG_MAX
+`endif
+
+import "DPI-C" function chandle flash_mem_open(input string path, input int unsigned size);
+import "DPI-C" function byte unsigned flash_mem_read(input chandle h, input int unsigned addr);
+import "DPI-C" function void flash_mem_write(input chandle h, input int unsigned addr,
+                                            input byte unsigned data);
+import "DPI-C" function void flash_mem_erase(input chandle h, input int unsigned addr,
+                                            input int unsigned len);
+import "DPI-C" function void flash_mem_erase_all(input chandle h);
+import "DPI-C" function int flash_mem_load(input chandle h, input string path,
+                                           input int unsigned addr);
+import "DPI-C" function int flash_mem_dump(input chandle h, input string path, input int diff);
+
 module qspi_nor_sim_model #(
-    parameter MEMORY_SIZE = 1024 * 256, // reduce for sim, 256KB
+    parameter MEMORY_SIZE = 1024 * 256, // bytes, only written pages are allocated
     parameter SECTOR_SIZE = 64,         // 64KB sectors
     parameter MFR_ID      = 8'h20,
-    parameter DEVICE_ID   = 16'hBA19
+    parameter DEVICE_ID   = 16'hBA19,
+    parameter PP_BUSY_CYCLES = 0,       // clk_i cycles of WIP after a page program
+    parameter SE_BUSY_CYCLES = 0,       // ... a sector erase
+    parameter CE_BUSY_CYCLES = 0,       // ... a chip erase
+    parameter IMAGE_EN    = 1           // takes +flash_image / +flash_dump
 ) (
-    input  logic sclk,
-    input  logic cs_n,
-    input  logic dq0_mosi_i,
-    output logic dq1_miso_o
+    input  logic       clk_i,    // time base of the busy timers
+    input  logic       sclk,
+    input  logic       cs_n,
+    input  logic [3:0] dq_i,     // IO3..IO0 as seen on the bus
+    output logic [3:0] dq_o,
+    output logic [3:0] dq_oe_o   // flash drives IOn when dq_oe_o[n] is set
 );
 
-    logic [7:0] memory [0:MEMORY_SIZE-1];
+    chandle      mem;
+    string       image_file;
+    string       dump_file;
+    int unsigned image_addr;
 
     typedef enum logic [2:0] {
         STATE_IDLE,
@@ -18,7 +94,8 @@ module qspi_nor_sim_model #(
         STATE_ADDR,
         STATE_DUMMY,
         STATE_DATA_IN,
-        STATE_DATA_OUT
+        STATE_DATA_OUT,
+        STATE_IGNORE        // command rejected while busy, wait for CS high
     } state_t;
 
     state_t      current_state;
@@ -26,11 +103,22 @@ module qspi_nor_sim_model #(
     logic [31:0] address;
     logic [7:0]  shift_in;
     logic [7:0]  shift_out;   // drives MISO, MSB first
-    logic [7:0]  byte_counter;
+    logic [31:0] byte_counter;  // sequential reads run past page/sector ends
     logic [31:0] address_shift_in;
     logic [7:0]  bit_counter;
     logic [7:0]  device_info [0:19];
     logic [7:0]  dummy_cycles_target;
+    logic [2:0]  addr_lanes;    // IO lines per clock in the address phase: 1/2/4
+    logic [2:0]  data_lanes;    // IO lines per clock in the data phase: 1/2/4
+    logic        dtr;           // address and data phases on both edges
+    logic [5:0]  addr_bits;     // 24, or 32 for 4-byte opcodes and mode
+    logic        addr_4byte;    // 4-byte address mode (0xB7 / 0xE9)
+    logic        dtr_hold;      // DTR data out: the fall after the last dummy clock
+    logic        dtr_fall;
+    logic        cont_read;     // continuous read: no opcode until mode bits say so
+    logic [7:0]  mode_shift;
+    logic        io_read;       // mode bits after the address
+    logic [7:0]  mode_clocks;   // clocks of the mode bits, at the start of DUMMY
 
     logic [7:0]  status_reg_1;
     logic [7:0]  flag_status_reg;
@@ -38,13 +126,64 @@ module qspi_nor_sim_model #(
     logic [15:0] nonvolatile_config;
     logic        write_in_progress;
     logic        write_enable_latch;
+    logic        erase_pend;    // erase decoded, applied when CS rises
+    logic        erase_chip;
+    logic [31:0] erase_base;
+
+    // busy timer: the SPI side toggles busy_req with busy_len set, the
+    // clk_i side loads the count
+    longint unsigned t_pp;      // clk_i cycles
+    longint unsigned t_se;
+    longint unsigned t_be;
+    logic [63:0] busy_len;
+    logic        busy_req;
+    logic        busy_ack;
+    logic [63:0] busy_cnt;
+    logic        busy;
+    logic [7:0]  status_out;
+    logic [7:0]  flag_status_out;
+
+    `SPI_LOG_DECL("FLASH", `SPI_LOG_MAX_FLASH)
 
     // -------------------------------------------------------------------------
     // Init
     // -------------------------------------------------------------------------
     initial begin
-        for (int i = 0; i < MEMORY_SIZE; i++)
-            memory[i] = 8'hFF;  // erased state = 0xFF
+        mem = flash_mem_open($sformatf("%m"), MEMORY_SIZE);  // all 0xFF
+        if (IMAGE_EN && $value$plusargs("flash_image=%s", image_file)) begin
+            automatic int n;
+            if (!$value$plusargs("flash_image_addr=%h", image_addr))
+                image_addr = 0;
+            n = flash_mem_load(mem, image_file, image_addr);
+            if (n < 0)
+                `SPI_LOG(`SPI_LOG_ERROR, ("Cannot map image %s", image_file))
+            else
+                `SPI_LOG(`SPI_LOG_INFO, ("Image %s: %0d bytes at 0x%06h", image_file, n, image_addr))
+        end
+
+        begin
+            automatic int unsigned clk_mhz = 100;
+            automatic longint unsigned us;
+            automatic string timing;
+            t_pp = PP_BUSY_CYCLES;
+            t_se = SE_BUSY_CYCLES;
+            t_be = CE_BUSY_CYCLES;
+            void'($value$plusargs("flash_clk_mhz=%d", clk_mhz));
+            if ($value$plusargs("flash_timing=%s", timing)) begin
+                if (timing == "typ") begin
+                    t_pp = 64'd120 * clk_mhz;
+                    t_se = 64'd150_000 * clk_mhz;
+                    t_be = 64'd153_000_000 * clk_mhz;
+                end else
+                    `SPI_LOG(`SPI_LOG_ERROR, ("Unknown +flash_timing=%s", timing))
+            end
+            if ($value$plusargs("flash_tpp_us=%d", us)) t_pp = us * clk_mhz;
+            if ($value$plusargs("flash_tse_us=%d", us)) t_se = us * clk_mhz;
+            if ($value$plusargs("flash_tbe_us=%d", us)) t_be = us * clk_mhz;
+            if (t_pp != 0 || t_se != 0 || t_be != 0)
+                `SPI_LOG(`SPI_LOG_INFO, ("Busy times: tPP %0d, tSE %0d, tBE %0d clk_i cycles",
+                                         t_pp, t_se, t_be))
+        end
 
         device_info[0] = MFR_ID;
         device_info[1] = DEVICE_ID[15:8];
@@ -61,57 +200,156 @@ module qspi_nor_sim_model #(
         nonvolatile_config = 16'hFFFF;
         write_in_progress  = 1'b0;
         write_enable_latch = 1'b0;
+        erase_pend         = 1'b0;
+        erase_chip         = 1'b0;
+        erase_base         = 32'h0;
+        busy_len           = 0;
+        busy_req           = 1'b0;
+        busy_ack           = 1'b0;
+        busy_cnt           = 0;
         current_state      = STATE_IDLE;
         command            = 8'h00;
         address            = 32'h0;
         bit_counter        = 0;
         byte_counter       = 0;
         dummy_cycles_target= 0;
+        addr_lanes         = 1;
+        data_lanes         = 1;
+        dtr                = 1'b0;
+        dtr_hold           = 1'b0;
+        addr_bits          = 24;
+        addr_4byte         = 1'b0;
+        cont_read          = 1'b0;
+        mode_shift         = 8'h00;
         shift_out          = 8'h00;
         shift_in           = 8'h00;
-        dq1_miso_o         = 1'b0;
+    end
+
+    final begin
+        if (IMAGE_EN && $value$plusargs("flash_dump=%s", dump_file)) begin
+            if (flash_mem_dump(mem, dump_file, int'($test$plusargs("flash_dump_diff"))) != 0)
+                `SPI_LOG(`SPI_LOG_ERROR, ("Cannot write dump %s", dump_file))
+        end
     end
 
     // -------------------------------------------------------------------------
-    // Main FSM — posedge sclk, async reset on cs_n high
+    // Busy timer
     // -------------------------------------------------------------------------
-    always @(posedge sclk or posedge cs_n) begin
+    always @(posedge clk_i) begin
+        if (busy_req != busy_ack) begin
+            busy_ack <= busy_req;
+            busy_cnt <= busy_len;
+        end else if (busy_cnt != 0) begin
+            busy_cnt <= busy_cnt - 1;
+        end
+    end
+
+    assign busy            = (busy_req != busy_ack) || (busy_cnt != 0);
+    assign status_out      = {status_reg_1[7:1], busy};
+    assign flag_status_out = {!busy, flag_status_reg[6:0]};
+
+    // -------------------------------------------------------------------------
+    // Main FSM — posedge sclk, async reset on cs_n high. Falling edges only
+    // shift in the DTR address, mode bits and data phases; the first fall of
+    // each still belongs to the phase before (the opcode, the last dummy clock).
+    // -------------------------------------------------------------------------
+    assign dtr_fall = dtr && ((current_state == STATE_ADDR && bit_counter != 0) ||
+                              (current_state == STATE_DUMMY && io_read && bit_counter != 0 &&
+                               bit_counter <= mode_clocks) ||
+                              (current_state == STATE_DATA_OUT && !dtr_hold));
+
+    assign io_read     = command == 8'hBB || command == 8'hEB || command == 8'hBC ||
+                         command == 8'hEC || command == 8'hBD || command == 8'hED;
+    assign mode_clocks = dtr ? ((addr_lanes == 4) ? 8'd1 : 8'd2)
+                             : ((addr_lanes == 4) ? 8'd2 : 8'd4);
+
+    always @(posedge sclk or negedge sclk or posedge cs_n) begin
         if (cs_n) begin
             // CS deasserted — complete any pending writes
             if (current_state == STATE_DATA_IN) begin
                 if (command == 8'h02 || command == 8'h12 ||
                     command == 8'h32 || command == 8'h34) begin
+                    if (write_enable_latch && t_pp != 0) begin
+                        busy_len <= t_pp;
+                        busy_req <= !busy_req;
+                    end
                     write_in_progress <= 1'b0;
                     write_enable_latch <= 1'b0;
                 end
             end
+            // erases, like programs, only start when CS rises right after
+            // the opcode or address: a cut-short transaction erases nothing
+            if (erase_pend) begin
+                if (erase_chip) begin
+                    flash_mem_erase_all(mem);
+                    if (t_be != 0) begin
+                        busy_len <= t_be;
+                        busy_req <= !busy_req;
+                    end
+                    `SPI_LOG(`SPI_LOG_INFO, ("Chip erase"))
+                    `SPI_LOG_REC(`SPI_EV_ERASE, MEMORY_SIZE, 0)
+                end else begin
+                    flash_mem_erase(mem, erase_base, SECTOR_SIZE * 1024);
+                    if (t_se != 0) begin
+                        busy_len <= t_se;
+                        busy_req <= !busy_req;
+                    end
+                    `SPI_LOG(`SPI_LOG_INFO, ("Erased sector at 0x%06h", erase_base))
+                    `SPI_LOG_REC(`SPI_EV_ERASE, SECTOR_SIZE * 1024, erase_base)
+                end
+                write_enable_latch <= 1'b0;
+                erase_pend         <= 1'b0;
+            end
             current_state <= STATE_IDLE;
             bit_counter   <= 0;
             byte_counter  <= 0;
 
+        end else if (!sclk && !dtr_fall) begin
+            dtr_hold <= 1'b0;
+
         end else begin
             case (current_state)
 
                 // -----------------------------------------------------------------
                 STATE_IDLE: begin
-                    // Capture first bit immediately, go to CMD
-                    shift_in      <= {7'b0, dq0_mosi_i};
-                    bit_counter   <= 1;
-                    current_state <= STATE_CMD;
+                    if (cont_read) begin
+                        // continuous read: command, lanes and width are kept,
+                        // the first clock already carries address bits
+                        address_shift_in <= (addr_lanes == 4) ? {28'b0, dq_i}
+                                          : {30'b0, dq_i[1:0]};
+                        bit_counter      <= 8'(addr_lanes);
+                        current_state    <= STATE_ADDR;
+                        `SPI_LOG(`SPI_LOG_DEBUG, ("Continuous read, CMD 0x%02h", command))
+                    end else begin
+                        // Capture first bit immediately, go to CMD; clocks
+                        // after an erase command cancel it
+                        erase_pend    <= 1'b0;
+                        shift_in      <= {7'b0, dq_i[0]};
+                        bit_counter   <= 1;
+                        addr_lanes    <= 1;
+                        data_lanes    <= 1;
+                        dtr           <= 1'b0;
+                        addr_bits     <= addr_4byte ? 6'd32 : 6'd24;
+                        current_state <= STATE_CMD;
+                    end
                 end
 
                 // -----------------------------------------------------------------
                 STATE_CMD: begin
-                    shift_in <= {shift_in[6:0], dq0_mosi_i};
+                    shift_in <= {shift_in[6:0], dq_i[0]};
 
                     if (bit_counter == 7) begin
                         automatic logic [7:0] cmd;
-                        cmd     = {shift_in[6:0], dq0_mosi_i};
+                        cmd     = {shift_in[6:0], dq_i[0]};
                         command <= cmd;
                         bit_counter <= 0;
-                        $display("[FLASH] CMD: 0x%02h", cmd);
+                        `SPI_LOG(`SPI_LOG_DEBUG, ("CMD: 0x%02h", cmd))
+                        `SPI_LOG_REC(`SPI_EV_CMD, cmd, 0)
 
-                        case (cmd)
+                        if (busy && cmd != 8'h05 && cmd != 8'h70) begin
+                            current_state <= STATE_IGNORE;
+                            `SPI_LOG(`SPI_LOG_WARN, ("CMD 0x%02h ignored, program/erase in progress", cmd))
+                        end else case (cmd)
                             // --- 3-byte address read commands ---
                             8'h03: begin  // Read
                                 current_state       <= STATE_ADDR;
@@ -121,17 +359,125 @@ module qspi_nor_sim_model #(
                                 current_state       <= STATE_ADDR;
                                 dummy_cycles_target <= 8;
                             end
+                            8'h3B: begin  // Dual Output Fast Read (1-1-2)
+                                current_state       <= STATE_ADDR;
+                                dummy_cycles_target <= 8;
+                                data_lanes          <= 2;
+                            end
+                            8'hBB: begin  // Dual I/O Fast Read (1-2-2)
+                                current_state       <= STATE_ADDR;
+                                dummy_cycles_target <= 8;
+                                addr_lanes          <= 2;
+                                data_lanes          <= 2;
+                            end
+                            8'h6B: begin  // Quad Output Fast Read (1-1-4)
+                                current_state       <= STATE_ADDR;
+                                dummy_cycles_target <= 8;
+                                data_lanes          <= 4;
+                            end
+                            8'hEB: begin  // Quad I/O Fast Read (1-4-4)
+                                current_state       <= STATE_ADDR;
+                                dummy_cycles_target <= 10;
+                                addr_lanes          <= 4;
+                                data_lanes          <= 4;
+                            end
+
+                            // --- DTR reads: address and data on both edges ---
+                            8'h0D: begin  // DTR Fast Read (1-1D-1D)
+                                current_state       <= STATE_ADDR;
+                                dummy_cycles_target <= 6;
+                                dtr                 <= 1'b1;
+                            end
+                            8'hBD: begin  // DTR Dual I/O Fast Read (1-2D-2D)
+                                current_state       <= STATE_ADDR;
+                                dummy_cycles_target <= 6;
+                                addr_lanes          <= 2;
+                                data_lanes          <= 2;
+                                dtr                 <= 1'b1;
+                            end
+                            8'hED: begin  // DTR Quad I/O Fast Read (1-4D-4D)
+                                current_state       <= STATE_ADDR;
+                                dummy_cycles_target <= 8;
+                                addr_lanes          <= 4;
+                                data_lanes          <= 4;
+                                dtr                 <= 1'b1;
+                            end
+
+                            // --- 4-byte address reads ---
+                            8'h13: begin  // Read
+                                current_state       <= STATE_ADDR;
+                                dummy_cycles_target <= 0;
+                                addr_bits           <= 32;
+                            end
+                            8'h0C: begin  // Fast Read
+                                current_state       <= STATE_ADDR;
+                                dummy_cycles_target <= 8;
+                                addr_bits           <= 32;
+                            end
+                            8'h3C: begin  // Dual Output Fast Read (1-1-2)
+                                current_state       <= STATE_ADDR;
+                                dummy_cycles_target <= 8;
+                                data_lanes          <= 2;
+                                addr_bits           <= 32;
+                            end
+                            8'hBC: begin  // Dual I/O Fast Read (1-2-2)
+                                current_state       <= STATE_ADDR;
+                                dummy_cycles_target <= 8;
+                                addr_lanes          <= 2;
+                                data_lanes          <= 2;
+                                addr_bits           <= 32;
+                            end
+                            8'h6C: begin  // Quad Output Fast Read (1-1-4)
+                                current_state       <= STATE_ADDR;
+                                dummy_cycles_target <= 8;
+                                data_lanes          <= 4;
+                                addr_bits           <= 32;
+                            end
+                            8'hEC: begin  // Quad I/O Fast Read (1-4-4)
+                                current_state       <= STATE_ADDR;
+                                dummy_cycles_target <= 10;
+                                addr_lanes          <= 4;
+                                data_lanes          <= 4;
+                                addr_bits           <= 32;
+                            end
 
                             // --- 3-byte address write commands ---
                             8'h02: begin  // Page Program
                                 current_state      <= STATE_ADDR;
                                 write_in_progress  <= 1'b1;
                             end
+                            8'h32: begin  // Quad Input Fast Program (1-1-4)
+                                current_state      <= STATE_ADDR;
+                                write_in_progress  <= 1'b1;
+                                data_lanes         <= 4;
+                            end
 
-                            // --- Sector erase ---
+                            // --- 4-byte address write commands ---
+                            8'h12: begin  // Page Program
+                                current_state      <= STATE_ADDR;
+                                write_in_progress  <= 1'b1;
+                                addr_bits          <= 32;
+                            end
+                            8'h34: begin  // Quad Input Fast Program (1-1-4)
+                                current_state      <= STATE_ADDR;
+                                write_in_progress  <= 1'b1;
+                                data_lanes         <= 4;
+                                addr_bits          <= 32;
+                            end
+
+                            // --- Sector / chip erase ---
                             8'hD8: begin  // 64KB Sector Erase (3-byte addr)
                                 current_state <= STATE_ADDR;
                             end
+                            8'hDC: begin  // 64KB Sector Erase (4-byte addr)
+                                current_state <= STATE_ADDR;
+                                addr_bits     <= 32;
+                            end
+                            8'hC7, 8'h60: begin  // Chip Erase, at CS high
+                                erase_pend    <= write_enable_latch;
+                                erase_chip    <= 1'b1;
+                                current_state <= STATE_IDLE;
+                            end
 
                             // --- Register reads (no address) ---
                             8'h9F: begin  // Read JEDEC ID
@@ -144,34 +490,47 @@ module qspi_nor_sim_model #(
                                 current_state <= STATE_DATA_OUT;
                                 byte_counter  <= 0;
                                 bit_counter   <= 0;
-                                shift_out     <= status_reg_1;
+                                shift_out     <= status_out;
                             end
                             8'h70: begin  // Read Flag Status
                                 current_state <= STATE_DATA_OUT;
                                 byte_counter  <= 0;
                                 bit_counter   <= 0;
-                                shift_out     <= flag_status_reg;
+                                shift_out     <= flag_status_out;
                             end
 
                             // --- Single-byte commands ---
                             8'h06: begin  // Write Enable
                                 write_enable_latch <= 1'b1;
                                 current_state      <= STATE_IDLE;
-                                $display("[FLASH] Write Enable");
+                                `SPI_LOG(`SPI_LOG_DEBUG, ("Write Enable"))
                             end
                             8'h04: begin  // Write Disable
                                 write_enable_latch <= 1'b0;
                                 current_state      <= STATE_IDLE;
                             end
+                            8'hB7: begin  // Enter 4-byte address mode
+                                addr_4byte         <= 1'b1;
+                                flag_status_reg[0] <= 1'b1;
+                                current_state      <= STATE_IDLE;
+                            end
+                            8'hE9: begin  // Exit 4-byte address mode
+                                addr_4byte         <= 1'b0;
+                                flag_status_reg[0] <= 1'b0;
+                                current_state      <= STATE_IDLE;
+                            end
                             8'h66: current_state <= STATE_IDLE; // Reset Enable
+                            8'hFF: current_state <= STATE_IDLE; // Mode bit reset, not in continuous read
                             8'h99: begin  // Reset Execute
                                 write_enable_latch <= 1'b0;
                                 write_in_progress  <= 1'b0;
+                                addr_4byte         <= 1'b0;
+                                flag_status_reg[0] <= 1'b0;
                                 current_state      <= STATE_IDLE;
                             end
 
                             default: begin
-                                $display("[FLASH] Unhandled CMD: 0x%02h", cmd);
+                                `SPI_LOG(`SPI_LOG_WARN, ("Unhandled CMD: 0x%02h", cmd))
                                 current_state <= STATE_IDLE;
                             end
                         endcase
@@ -182,40 +541,43 @@ module qspi_nor_sim_model #(
 
                 // -----------------------------------------------------------------
                 STATE_ADDR: begin
-                    address_shift_in <= {address_shift_in[30:0], dq0_mosi_i};
-                    bit_counter      <= bit_counter + 1;
+                    automatic logic [31:0] addr_next;
+                    addr_next = (addr_lanes == 4) ? {address_shift_in[27:0], dq_i}
+                              : (addr_lanes == 2) ? {address_shift_in[29:0], dq_i[1:0]}
+                              :                     {address_shift_in[30:0], dq_i[0]};
+                    address_shift_in <= addr_next;
+                    bit_counter      <= bit_counter + 8'(addr_lanes);
 
-                    if (bit_counter == 23) begin  // 24-bit address
-                        automatic logic [23:0] addr24;
-                        addr24  = {address_shift_in[22:0], dq0_mosi_i};
-                        address <= {8'b0, addr24};
+                    if (bit_counter + 8'(addr_lanes) == 8'(addr_bits)) begin
+                        automatic logic [31:0] addr;
+                        addr    = (addr_bits == 32) ? addr_next : {8'b0, addr_next[23:0]};
+                        address <= addr;
                         bit_counter <= 0;
-                        $display("[FLASH] ADDR: 0x%06h", addr24);
+                        if (addr_bits == 32)
+                            `SPI_LOG(`SPI_LOG_DEBUG, ("ADDR: 0x%08h", addr))
+                        else
+                            `SPI_LOG(`SPI_LOG_DEBUG, ("ADDR: 0x%06h", addr[23:0]))
+                        `SPI_LOG_REC(`SPI_EV_ADDR, addr, 0)
 
                         case (command)
-                            8'h03: begin  // Read — no dummy
+                            8'h03, 8'h13: begin  // Read — no dummy
                                 current_state <= STATE_DATA_OUT;
                                 byte_counter  <= 0;
-                                shift_out     <= memory[{8'b0, addr24}];
+                                shift_out     <= flash_mem_read(mem, addr % MEMORY_SIZE);
                             end
-                            8'h0B: begin  // Fast Read — dummy cycles
+                            8'h0B, 8'h3B, 8'hBB, 8'h6B, 8'hEB,
+                            8'h0C, 8'h3C, 8'hBC, 8'h6C, 8'hEC,
+                            8'h0D, 8'hBD, 8'hED: begin  // Fast Reads — dummy cycles
                                 current_state <= STATE_DUMMY;
                             end
-                            8'h02: begin  // Page Program
+                            8'h02, 8'h32, 8'h12, 8'h34: begin  // Page Program
                                 current_state <= STATE_DATA_IN;
                                 byte_counter  <= 0;
                             end
-                            8'hD8: begin  // 64KB Sector Erase
-                                if (write_enable_latch) begin
-                                    automatic logic [23:0] base;
-                                    base = addr24 & ~(24'(SECTOR_SIZE * 1024 - 1));
-                                    for (int i = 0; i < SECTOR_SIZE * 1024; i++) begin
-                                        if (base + i < MEMORY_SIZE)
-                                            memory[base + i] <= 8'hFF;
-                                    end
-                                    write_enable_latch <= 1'b0;
-                                    $display("[FLASH] Erased sector at 0x%06h", base);
-                                end
+                            8'hD8, 8'hDC: begin  // 64KB Sector Erase, at CS high
+                                erase_pend    <= write_enable_latch;
+                                erase_chip    <= 1'b0;
+                                erase_base    <= addr & ~(32'(SECTOR_SIZE * 1024 - 1));
                                 current_state <= STATE_IDLE;
                             end
                             default: current_state <= STATE_IDLE;
@@ -225,12 +587,30 @@ module qspi_nor_sim_model #(
 
                 // -----------------------------------------------------------------
                 STATE_DUMMY: begin
-                    bit_counter <= bit_counter + 1;
-                    if (bit_counter == dummy_cycles_target - 1) begin
+                    // I/O reads: mode bits on the address lanes first; DTR
+                    // takes the second half of each mode clock on the fall
+                    automatic logic [7:0] mode_next;
+                    automatic logic       mode_last;
+                    mode_next = (addr_lanes == 4) ? {mode_shift[3:0], dq_i}
+                                                  : {mode_shift[5:0], dq_i[1:0]};
+                    mode_last = io_read && (dtr ? (!sclk && bit_counter == mode_clocks)
+                                                : bit_counter == mode_clocks - 1);
+                    if (io_read && (!sclk || bit_counter < mode_clocks))
+                        mode_shift <= mode_next;
+                    if (mode_last) begin
+                        cont_read <= (mode_next[5:4] == 2'b10);
+                        if ((mode_next[5:4] == 2'b10) != cont_read)
+                            `SPI_LOG(`SPI_LOG_DEBUG, ("Mode bits 0x%02h, continuous read %s",
+                                     mode_next, (mode_next[5:4] == 2'b10) ? "on" : "off"))
+                    end
+                    if (sclk)
+                        bit_counter <= bit_counter + 1;
+                    if (sclk && bit_counter == dummy_cycles_target - 1) begin
                         current_state <= STATE_DATA_OUT;
                         byte_counter  <= 0;
                         bit_counter   <= 0;
-                        shift_out     <= memory[address % MEMORY_SIZE];
+                        dtr_hold      <= 1'b1;
+                        shift_out     <= flash_mem_read(mem, address % MEMORY_SIZE);
                     end
                 end
 
@@ -238,7 +618,7 @@ module qspi_nor_sim_model #(
                 STATE_DATA_OUT: begin
                     // MISO block already presented shift_out[7] on negedge
                     // Now on posedge: shift for next negedge presentation
-                    if (bit_counter == 7) begin
+                    if (bit_counter + 8'(data_lanes) == 8) begin
                         bit_counter  <= 0;
                         byte_counter <= byte_counter + 1;
                         // preload next byte — will be presented starting next negedge
@@ -247,41 +627,52 @@ module qspi_nor_sim_model #(
                                 shift_out <= (byte_counter < 8'd19)
                                         ? device_info[byte_counter + 1]
                                         : 8'hFF;
-                            8'h03, 8'h0B:
-                                shift_out <= memory[(address + byte_counter + 1) % MEMORY_SIZE];
+                            8'h03, 8'h0B, 8'h3B, 8'hBB, 8'h6B, 8'hEB,
+                            8'h13, 8'h0C, 8'h3C, 8'hBC, 8'h6C, 8'hEC,
+                            8'h0D, 8'hBD, 8'hED:
+                                shift_out <= flash_mem_read(mem, (address + byte_counter + 1) % MEMORY_SIZE);
                             8'h05:
-                                shift_out <= status_reg_1;
+                                shift_out <= status_out;
+                            8'h70:
+                                shift_out <= flag_status_out;
                             default:
                                 shift_out <= 8'hFF;
                         endcase
                     end else begin
-                        shift_out   <= {shift_out[6:0], 1'b0};  // shift next bit to [7]
-                        bit_counter <= bit_counter + 1;
+                        // shift next bit (nibble) to the top
+                        shift_out   <= (data_lanes == 4) ? {shift_out[3:0], 4'b0}
+                                     : (data_lanes == 2) ? {shift_out[5:0], 2'b0}
+                                     :                     {shift_out[6:0], 1'b0};
+                        bit_counter <= bit_counter + 8'(data_lanes);
                     end
                 end
 
                 // -----------------------------------------------------------------
                 STATE_DATA_IN: begin
-                    shift_in    <= {shift_in[6:0], dq0_mosi_i};
-                    bit_counter <= bit_counter + 1;
+                    automatic logic [7:0] din;
+                    din = (data_lanes == 4) ? {shift_in[3:0], dq_i}
+                        : (data_lanes == 2) ? {shift_in[5:0], dq_i[1:0]}
+                        :                     {shift_in[6:0], dq_i[0]};
+                    shift_in    <= din;
+                    bit_counter <= bit_counter + 8'(data_lanes);
 
-                    if (bit_counter == 7) begin
+                    if (bit_counter + 8'(data_lanes) == 8) begin
                         bit_counter <= 0;
                         case (command)
-                            8'h02: begin
+                            8'h02, 8'h32, 8'h12, 8'h34: begin
                                 if (write_enable_latch) begin
-                                    automatic logic [23:0] waddr;
-                                    waddr = (address[23:0] & 24'hFFFF00) 
-                                          | ((address[7:0] + byte_counter) & 8'hFF); // page wrap
-                                    memory[waddr] <= {shift_in[6:0], dq0_mosi_i};
-                                    $display("[FLASH] Write [0x%06h] = 0x%02h", 
-                                             waddr, {shift_in[6:0], dq0_mosi_i});
+                                    automatic logic [31:0] waddr;
+                                    waddr = {address[31:8], address[7:0] + byte_counter[7:0]}; // page wrap
+                                    // NOR: programming only clears bits
+                                    flash_mem_write(mem, waddr, flash_mem_read(mem, waddr) & din);
+                                    `SPI_LOG(`SPI_LOG_TRACE, ("Write [0x%06h] = 0x%02h", waddr, din))
+                                    `SPI_LOG_REC(`SPI_EV_PROG, din, waddr)
                                 end
                                 byte_counter <= byte_counter + 1;
                             end
                             8'h01: begin  // Write Status Reg
                                 if (write_enable_latch)
-                                    status_reg_1 <= {shift_in[6:0], dq0_mosi_i};
+                                    status_reg_1 <= din;
                                 write_enable_latch <= 1'b0;
                                 current_state <= STATE_IDLE;
                             end
@@ -290,6 +681,8 @@ module qspi_nor_sim_model #(
                     end
                 end
 
+                STATE_IGNORE: ;
+
                 default: current_state <= STATE_IDLE;
 
             endcase
@@ -297,10 +690,21 @@ module qspi_nor_sim_model #(
     end
 
     // -------------------------------------------------------------------------
-    // MISO output — present bit on negedge so master samples on posedge
+    // IO outputs — shift_out[7] (single, on IO1), shift_out[7:6] (dual, IO1
+    // first) or shift_out[7:4] (quad, IO3 first) is presented after posedge so
+    // the master samples on posedge (DTR: after each edge, sampled on the next)
     // -------------------------------------------------------------------------
-    assign dq1_miso_o = (!cs_n && current_state == STATE_DATA_OUT) 
-                    ? shift_out[7] 
-                    : 1'b0;
+    logic data_out;
+    assign data_out = !cs_n && current_state == STATE_DATA_OUT;
+
+    assign dq_oe_o = !data_out         ? 4'b0000
+                   : (data_lanes == 4) ? 4'b1111
+                   : (data_lanes == 2) ? 4'b0011
+                   :                     4'b0010;
+
+    assign dq_o    = !data_out         ? 4'b0000
+                   : (data_lanes == 4) ? shift_out[7:4]
+                   : (data_lanes == 2) ? {2'b00, shift_out[7:6]}
+                   :                     {2'b00, shift_out[7], 1'b0};
 
 endmodule
\ No newline at end of file
@@ -0,0 +1,150 @@
+#!/usr/bin/env python3
+"""Parallel regression runner for the tb_top.cpp test table.
+
+Runs every test (or the ones given with --tests) as its own simulator
+process, one per core by default. Each test runs in its own directory under
+--logdir, with its output in <logdir>/<name>/run.log, so files written by a
+test (waveforms, image dumps) never collide. Prints one line per test and a
+total; --junit and --json write summaries for CI.
+
+    make build_model_fast
+    ./run_tests.py -j 8 --junit regress.xml
+    ./run_tests.py --tests quad_io,dual_io --bin obj_dir/Vspi_flash_top +trace
+
+Arguments starting with '+' are passed to every test; relative file names in
+them are relative to the test's directory. The exit status is 1 when any
+test failed or timed out.
+"""
+import argparse
+import json
+import os
+import re
+import subprocess
+import sys
+import time
+from concurrent.futures import ThreadPoolExecutor
+from xml.sax.saxutils import escape, quoteattr
+
+RESULT_RE = re.compile(r"=== Results: (\d+) passed, (\d+) failed ===")
+
+
+def list_tests(binary):
+    out = subprocess.run([binary, "+list"], capture_output=True, text=True, check=True)
+    tests = []
+    for line in out.stdout.splitlines():
+        num, name = line.split()
+        tests.append((int(num), name))
+    return tests
+
+
+def run_test(binary, name, logdir, plusargs, timeout):
+    cwd = os.path.join(logdir, name)
+    os.makedirs(cwd, exist_ok=True)
+    log = os.path.join(cwd, "run.log")
+    cmd = [os.path.abspath(binary), "+test=" + name] + plusargs
+    if not any(a.startswith("+trace") for a in plusargs):
+        cmd.append("+trace=none")
+
+    start = time.monotonic()
+    status = "error"
+    code = None
+    with open(log, "w") as f:
+        try:
+            code = subprocess.run(cmd, cwd=cwd, stdout=f, stderr=subprocess.STDOUT,
+                                  timeout=timeout).returncode
+        except subprocess.TimeoutExpired:
+            status = "timeout"
+    secs = time.monotonic() - start
+
+    passed = failed = 0
+    with open(log, errors="replace") as f:
+        m = RESULT_RE.search(f.read())
+    if m:
+        passed, failed = int(m.group(1)), int(m.group(2))
+    if status != "timeout":
+        status = "pass" if code == 0 and m and failed == 0 else "fail"
+    return {"name": name, "status": status, "checks_passed": passed,
+            "checks_failed": failed, "exit_code": code, "seconds": round(secs, 3),
+            "log": log}
+
+
+def write_junit(path, results, total_secs):
+    fails = sum(r["status"] == "fail" for r in results)
+    errors = sum(r["status"] in ("timeout", "error") for r in results)
+    with open(path, "w") as f:
+        f.write('<?xml version="1.0" encoding="UTF-8"?>\n')
+        f.write('<testsuite name="tb_top" tests="%d" failures="%d" errors="%d" time="%.3f">\n'
+                % (len(results), fails, errors, total_secs))
+        for r in results:
+            f.write('  <testcase classname="tb_top" name=%s time="%.3f">\n'
+                    % (quoteattr(r["name"]), r["seconds"]))
+            if r["status"] != "pass":
+                tag = "failure" if r["status"] == "fail" else "error"
+                with open(r["log"], errors="replace") as lf:
+                    tail = "".join(lf.readlines()[-40:])
+                f.write('    <%s message=%s>%s</%s>\n'
+                        % (tag, quoteattr("%s, %d failed checks, see %s"
+                                          % (r["status"], r["checks_failed"], r["log"])),
+                           escape(tail), tag))
+            f.write("  </testcase>\n")
+        f.write("</testsuite>\n")
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.split("\n")[0])
+    ap.add_argument("--bin", default="obj_dir_fast/Vspi_flash_top",
+                    help="simulator built from tb_top.cpp (default: %(default)s)")
+    ap.add_argument("-j", "--jobs", type=int, default=os.cpu_count() or 1,
+                    help="tests run in parallel (default: cores)")
+    ap.add_argument("--tests", default="",
+                    help="comma-separated names or numbers (default: all)")
+    ap.add_argument("--logdir", default="regress_logs")
+    ap.add_argument("--timeout", type=float, default=600, help="seconds per test")
+    ap.add_argument("--junit", help="write a JUnit XML summary")
+    ap.add_argument("--json", help="write a JSON summary")
+    args, plusargs = ap.parse_known_args()
+    bad = [a for a in plusargs if not a.startswith("+")]
+    if bad:
+        ap.error("unknown arguments: " + " ".join(bad))
+
+    table = list_tests(args.bin)
+    if args.tests:
+        by_key = {str(n): name for n, name in table}
+        by_key.update({name: name for _, name in table})
+        try:
+            names = [by_key[t] for t in args.tests.split(",") if t]
+        except KeyError as e:
+            ap.error("unknown test %s" % e)
+    else:
+        names = [name for _, name in table]
+
+    start = time.monotonic()
+    with ThreadPoolExecutor(max_workers=max(1, args.jobs)) as pool:
+        futures = [pool.submit(run_test, args.bin, n, args.logdir, plusargs, args.timeout)
+                   for n in names]
+        results = []
+        for fut in futures:
+            r = fut.result()
+            results.append(r)
+            line = "%-7s %-20s %4d checks %7.2f s" % (
+                r["status"].upper(), r["name"], r["checks_passed"] + r["checks_failed"],
+                r["seconds"])
+            print(line + ("  " + r["log"] if r["status"] != "pass" else ""))
+            sys.stdout.flush()
+    total = time.monotonic() - start
+
+    npass = sum(r["status"] == "pass" for r in results)
+    print("\n%d/%d tests passed in %.1f s with %d jobs"
+          % (npass, len(results), total, args.jobs))
+
+    if args.junit:
+        write_junit(args.junit, results, total)
+    if args.json:
+        with open(args.json, "w") as f:
+            json.dump({"jobs": args.jobs, "seconds": round(total, 3), "passed": npass,
+                       "total": len(results), "tests": results}, f, indent=2)
+    return 0 if npass == len(results) else 1
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -1,23 +1,61 @@
+// spi_flash_wrapper with NUM_FLASH qspi_nor_sim_model devices on
+// spi_csn0..NUM_FLASH-1. Device n reports DEVICE_ID + n in its JEDEC ID and
+// takes the n-th PP/SE/CE_BUSY_CYCLES (32 bits each, device 0 in the low
+// bits); only device 0 loads +flash_image and writes +flash_dump.
 module spi_flash_top #(
-    parameter MEMORY_SIZE = 1024 * 256,
+    parameter MEMORY_SIZE = 64 * 1024 * 1024,   // sparse, see flash_mem.h
     parameter SECTOR_SIZE = 64,
     parameter MFR_ID      = 8'h20,
-    parameter DEVICE_ID   = 16'hBA19
+    parameter DEVICE_ID   = 16'hBA19,
+    parameter NUM_FLASH   = 2,                  // 1..4
+    parameter logic [127:0] PP_BUSY_CYCLES = 128'h0, // clk cycles, per device
+    parameter logic [127:0] SE_BUSY_CYCLES = 128'h0,
+    parameter logic [127:0] CE_BUSY_CYCLES = 128'h0,
+    parameter TX_FIFO_DEPTH = 8,
+    parameter RX_FIFO_DEPTH = 8,
+    parameter DESC_DEPTH    = 8
 ) (
     input  logic        clk,
     input  logic        rstn,
 
     // User interface — same as spi_flash_wrapper
+    input  logic [1:0]  cs_i,
     input  logic [7:0]  command_i,
     input  logic [1:0]  data_mode_i,
+    input  logic [1:0]  addr_mode_i,
     input  logic        rd_wr_i,
     input  logic [4:0]  dummy_cycle_i,
-    input  logic [7:0]  data_count_i,
+    input  logic        dtr_i,
+    input  logic [12:0] data_count_i,
+    input  logic        continuous_i,
+    input  logic        stop_i,
     input  logic        has_addr_i,
+    input  logic        addr_4b_i,
+    input  logic        mode_en_i,
+    input  logic [7:0]  mode_bits_i,
+    input  logic        no_cmd_i,
     input  logic [5:0]  prescaler_i,
     input  logic        clr_status_i,
     input  logic        start_i,
-    input  logic [23:0] addr_i,
+    input  logic [31:0] addr_i,
+
+    input  logic [63:0] desc_i,
+    input  logic [1:0]  desc_cs_i,
+    input  logic        desc_valid_i,
+    output logic        desc_ready_o,
+    input  logic        seq_start_i,
+    output logic        seq_busy_o,
+
+    input  logic        poll_start_i,
+    input  logic [7:0]  poll_cmd_i,
+    input  logic [7:0]  poll_mask_i,
+    input  logic [7:0]  poll_match_i,
+    input  logic [15:0] poll_interval_i,
+    input  logic [15:0] poll_max_i,
+    output logic        poll_timeout_o,
+    output logic [15:0] poll_count_o,
+    output logic [7:0]  poll_value_o,
+    output logic [3:0]  dev_busy_o,
 
     input  logic [31:0] data_tx_i,
     input  logic        data_tx_valid_i,
@@ -29,11 +67,19 @@ module spi_flash_top #(
 
     output logic        status_o,
     output logic        busy_o,
+    output logic        len_err_o,
     output logic        rx_fifo_full_o,
     output logic        rx_fifo_empty_o,
     output logic        tx_fifo_full_o,
     output logic        tx_fifo_empty_o,
+    input  logic [15:0] tx_ae_thresh_i,
+    input  logic [15:0] rx_af_thresh_i,
+    output logic        tx_almost_empty_o,
+    output logic        rx_almost_full_o,
+    input  logic [2:0]  irq_en_i,
+    output logic        irq_o,
     output logic [3:0]  err_msg_o,
+    output logic [7:0]  ctrl_status_o,
     input  logic        flush_tx_i,
     input  logic        flush_rx_i
 );
@@ -42,28 +88,60 @@ module spi_flash_top #(
     // Internal SPI bus — wires between wrapper and flash model
     // -------------------------------------------------------------------------
     logic spi_clk;
-    logic spi_csn;
+    logic [3:0] spi_csn;
     logic spi_sdo0, spi_sdo1, spi_sdo2, spi_sdo3;
     logic spi_sdi0, spi_sdi1, spi_sdi2, spi_sdi3;
 
     // -------------------------------------------------------------------------
     // SPI Flash Wrapper (master)
     // -------------------------------------------------------------------------
-    spi_flash_wrapper u_wrapper (
+    spi_flash_wrapper #(
+        .TX_FIFO_DEPTH(TX_FIFO_DEPTH),
+        .RX_FIFO_DEPTH(RX_FIFO_DEPTH),
+        .DESC_DEPTH   (DESC_DEPTH),
+        .NUM_CS       (NUM_FLASH)
+    ) u_wrapper (
         .clk            (clk),
         .rstn           (rstn),
 
+        .cs_i           (cs_i),
         .command_i      (command_i),
         .data_mode_i    (data_mode_i),
+        .addr_mode_i    (addr_mode_i),
         .rd_wr_i        (rd_wr_i),
         .dummy_cycle_i  (dummy_cycle_i),
+        .dtr_i          (dtr_i),
         .data_count_i   (data_count_i),
+        .continuous_i   (continuous_i),
+        .stop_i         (stop_i),
         .has_addr_i     (has_addr_i),
+        .addr_4b_i      (addr_4b_i),
+        .mode_en_i      (mode_en_i),
+        .mode_bits_i    (mode_bits_i),
+        .no_cmd_i       (no_cmd_i),
         .prescaler_i    (prescaler_i),
         .clr_status_i   (clr_status_i),
         .start_i        (start_i),
         .addr_i         (addr_i),
 
+        .desc_i         (desc_i),
+        .desc_cs_i      (desc_cs_i),
+        .desc_valid_i   (desc_valid_i),
+        .desc_ready_o   (desc_ready_o),
+        .seq_start_i    (seq_start_i),
+        .seq_busy_o     (seq_busy_o),
+
+        .poll_start_i   (poll_start_i),
+        .poll_cmd_i     (poll_cmd_i),
+        .poll_mask_i    (poll_mask_i),
+        .poll_match_i   (poll_match_i),
+        .poll_interval_i(poll_interval_i),
+        .poll_max_i     (poll_max_i),
+        .poll_timeout_o (poll_timeout_o),
+        .poll_count_o   (poll_count_o),
+        .poll_value_o   (poll_value_o),
+        .dev_busy_o     (dev_busy_o),
+
         .data_tx_i      (data_tx_i),
         .data_tx_valid_i(data_tx_valid_i),
         .data_tx_ready_o(data_tx_ready_o),
@@ -74,17 +152,28 @@ module spi_flash_top #(
 
         .status_o       (status_o),
         .busy_o         (busy_o),
+        .len_err_o      (len_err_o),
         .rx_fifo_full_o (rx_fifo_full_o),
         .rx_fifo_empty_o(rx_fifo_empty_o),
         .tx_fifo_full_o (tx_fifo_full_o),
         .tx_fifo_empty_o(tx_fifo_empty_o),
+        .tx_ae_thresh_i (tx_ae_thresh_i),
+        .rx_af_thresh_i (rx_af_thresh_i),
+        .tx_almost_empty_o(tx_almost_empty_o),
+        .rx_almost_full_o (rx_almost_full_o),
+        .irq_en_i       (irq_en_i),
+        .irq_o          (irq_o),
         .err_msg_o      (err_msg_o),
+        .ctrl_status_o  (ctrl_status_o),
         .flush_tx_i     (flush_tx_i),
         .flush_rx_i     (flush_rx_i),
 
         // SPI bus
         .spi_clk        (spi_clk),
-        .spi_csn        (spi_csn),
+        .spi_csn0       (spi_csn[0]),
+        .spi_csn1       (spi_csn[1]),
+        .spi_csn2       (spi_csn[2]),
+        .spi_csn3       (spi_csn[3]),
         .spi_sdo0       (spi_sdo0),
         .spi_sdo1       (spi_sdo1),
         .spi_sdo2       (spi_sdo2),
@@ -96,34 +185,50 @@ module spi_flash_top #(
     );
 
     // -------------------------------------------------------------------------
-    // NOR Flash simulation model (slave)
-    // only sdo0→dq0 (MOSI) and dq1→sdi0 (MISO) used in standard SPI mode
-    // sdo1/2/3 wired in for quad mode future use
+    // NOR Flash simulation models (slaves), one per chip select
+    // IO0..IO3 are resolved here: a flash drives a line while its output
+    // enable is set, otherwise the line carries the master's sdo. The master
+    // has no output enables, so its sdo during flash output is ignored. Only
+    // the selected device ever drives.
     // -------------------------------------------------------------------------
-    qspi_nor_sim_model #(
-        .MEMORY_SIZE(MEMORY_SIZE),
-        .SECTOR_SIZE(SECTOR_SIZE),
-        .MFR_ID     (MFR_ID),
-        .DEVICE_ID  (DEVICE_ID)
-    ) u_flash (
-        .sclk       (spi_clk),
-        .cs_n       (spi_csn),
-
-        // MOSI: master out → flash in (dq0)
-        .dq0_mosi_i (spi_sdo0),
-
-        // MISO: flash out → master in (dq1)
-        .dq1_miso_o (spi_sdi0)
-
-        // quad lines — not connected until quad mode is added
-        // .dq1_io     (spi_sdo1 / spi_sdi1)  // future
-        // .dq2_io     (spi_sdo2 / spi_sdi2)  // future
-        // .dq3_io     (spi_sdo3 / spi_sdi3)  // future
-    );
-
-    // unused SDI lines tied off
-    assign spi_sdi1 = 1'b0;
-    assign spi_sdi2 = 1'b0;
-    assign spi_sdi3 = 1'b0;
-
-endmodule
\ No newline at end of file
+    logic [3:0] flash_dq_o  [NUM_FLASH];
+    logic [3:0] flash_dq_oe [NUM_FLASH];
+    logic [3:0] dq_o;
+    logic [3:0] dq_oe;
+
+    for (genvar n = 0; n < NUM_FLASH; n++) begin : g_flash
+        qspi_nor_sim_model #(
+            .MEMORY_SIZE   (MEMORY_SIZE),
+            .SECTOR_SIZE   (SECTOR_SIZE),
+            .MFR_ID        (MFR_ID),
+            .DEVICE_ID     (16'(DEVICE_ID + n)),
+            .PP_BUSY_CYCLES(PP_BUSY_CYCLES[32*n +: 32]),
+            .SE_BUSY_CYCLES(SE_BUSY_CYCLES[32*n +: 32]),
+            .CE_BUSY_CYCLES(CE_BUSY_CYCLES[32*n +: 32]),
+            .IMAGE_EN      (n == 0)
+        ) u_flash (
+            .clk_i      (clk),
+            .sclk       (spi_clk),
+            .cs_n       (spi_csn[n]),
+
+            .dq_i       ({spi_sdo3, spi_sdo2, spi_sdo1, spi_sdo0}),
+            .dq_o       (flash_dq_o[n]),
+            .dq_oe_o    (flash_dq_oe[n])
+        );
+    end
+
+    always_comb begin
+        dq_o  = 4'b0000;
+        dq_oe = 4'b0000;
+        for (int n = 0; n < NUM_FLASH; n++) begin
+            dq_o  = dq_o  | (flash_dq_o[n] & flash_dq_oe[n]);
+            dq_oe = dq_oe | flash_dq_oe[n];
+        end
+    end
+
+    assign spi_sdi0 = dq_oe[0] ? dq_o[0] : spi_sdo0;
+    assign spi_sdi1 = dq_oe[1] ? dq_o[1] : spi_sdo1;
+    assign spi_sdi2 = dq_oe[2] ? dq_o[2] : spi_sdo2;
+    assign spi_sdi3 = dq_oe[3] ? dq_o[3] : spi_sdo3;
+
+endmodule
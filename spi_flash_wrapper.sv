@@ -1,18 +1,62 @@
-module spi_flash_wrapper (
+module spi_flash_wrapper #(
+    parameter TX_FIFO_DEPTH = 8,        // 32-bit words
+    parameter RX_FIFO_DEPTH = 8,
+    parameter DESC_DEPTH    = 8,        // command descriptors, see spi_master_seq
+    parameter NUM_CS        = 4         // devices on spi_csn0..3, see spi_master_sched
+) (
     input  logic        clk,
     input  logic        rstn,
 
+    input  logic [1:0]  cs_i,            // device of direct commands and polls
     input  logic [7:0]  command_i,
     input  logic [1:0]  data_mode_i,    // 00=no data, 01=std SPI, 10=dual, 11=quad
+    input  logic [1:0]  addr_mode_i,    // address lanes: 00/01=1, 10=2, 11=4
     input  logic        rd_wr_i,         // 1=read, 0=write
     input  logic [4:0]  dummy_cycle_i,
-    input  logic [7:0]  data_count_i,   // bytes-1: 0=1byte, 1=2bytes, ...
+    input  logic        dtr_i,           // address and data on both SPI clock edges
+    input  logic [12:0] data_count_i,   // bytes-1: 0=1byte, 1=2bytes, ... max 8190, see len_err_o
+    input  logic        continuous_i,    // read until stop_i, data_count_i ignored
+    input  logic        stop_i,          // end a continuous read after the current word
     input  logic        has_addr_i,
+    input  logic        addr_4b_i,       // 32-bit address phase (4-byte opcodes / mode)
+    input  logic        mode_en_i,       // reads: mode_bits_i after the address, on its lanes
+    input  logic [7:0]  mode_bits_i,     // e.g. 0xA0 keeps the flash in continuous read
+    input  logic        no_cmd_i,        // skip the opcode (flash in continuous read)
     input  logic [5:0]  prescaler_i,
     input  logic        clr_status_i,
-    input  logic        start_i,         // pulse 1 cycle to start
-
-    input  logic [23:0] addr_i,          // 24-bit flash address
+    input  logic        start_i,         // pulse 1 cycle to start; waits while the queue
+                                         // runs or cs_i is polled, hold the fields until status_o
+
+    input  logic [31:0] addr_i,          // flash address, [23:0] unless addr_4b_i
+
+    // Command queue: descriptors replace the fields above while seq_busy_o.
+    // status_o is then only set once the whole chain has finished, right
+    // away for seq_start_i with an empty queue.
+    input  logic [63:0] desc_i,
+    input  logic [1:0]  desc_cs_i,       // device of desc_i
+    input  logic        desc_valid_i,
+    output logic        desc_ready_o,
+    input  logic        seq_start_i,     // pulse 1 cycle to run the queue
+    output logic        seq_busy_o,
+
+    // Status auto-poll (spi_master_poll): poll_start_i, or a DESC_POLL
+    // command in the queue, reads poll_cmd_i every poll_interval_i cycles
+    // until (value & poll_mask_i) == poll_match_i or poll_max_i reads (0: no
+    // limit). status_o is set on match or timeout; poll_timeout_o tells which
+    // and stays set until clr_status_i. Each device has its own engine, a
+    // device is busy (dev_busy_o) while it is polled; the queue and direct
+    // commands go to the other devices meanwhile, between the status reads
+    // (a direct command sets status_o with its own end of transfer).
+    input  logic        poll_start_i,
+    input  logic [7:0]  poll_cmd_i,
+    input  logic [7:0]  poll_mask_i,
+    input  logic [7:0]  poll_match_i,
+    input  logic [15:0] poll_interval_i,
+    input  logic [15:0] poll_max_i,
+    output logic        poll_timeout_o,
+    output logic [15:0] poll_count_o,    // reads issued by the last poll
+    output logic [7:0]  poll_value_o,    // last status byte read
+    output logic [3:0]  dev_busy_o,
 
     // TX port
     input  logic [31:0] data_tx_i,
@@ -24,22 +68,40 @@ module spi_flash_wrapper (
     output logic        data_rx_valid_o,
     input  logic        data_rx_ready_i,
 
-    output logic        status_o,        // latches high on eot, cleared by clr_status_i
-    output logic        busy_o,          // high while CS asserted
+    output logic        status_o,        // latches high on eot (queue: chain end), cleared by clr_status_i
+    output logic        busy_o,          // high while a CS is asserted
+    output logic        len_err_o,       // a data_count of 8191 was refused, cleared by clr_status_i
 
     output logic        rx_fifo_full_o,
     output logic        rx_fifo_empty_o,
     output logic        tx_fifo_full_o,
     output logic        tx_fifo_empty_o,
 
+    // FIFO watermarks — levels in words, compared every cycle
+    input  logic [15:0] tx_ae_thresh_i,  // tx_almost_empty_o while level <= thresh
+    input  logic [15:0] rx_af_thresh_i,  // rx_almost_full_o  while level >= thresh (0: off)
+    output logic        tx_almost_empty_o,
+    output logic        rx_almost_full_o,
+
+    // level interrupt: [0] rx almost full [1] tx almost empty [2] status_o
+    input  logic [2:0]  irq_en_i,
+    output logic        irq_o,
+
     output logic [3:0]  err_msg_o,       // reserved
 
+    // controller phase, one-hot: [0] IDLE [1] CMD [2] ADDR [3] MODE [4] DUMMY
+    // [5] DATA_TX [6] DATA_RX [7] WAIT_EDGE
+    output logic [7:0]  ctrl_status_o,
+
     input  logic        flush_tx_i,
     input  logic        flush_rx_i,
 
     // SPI pins
     output logic        spi_clk,
-    output logic        spi_csn,
+    output logic        spi_csn0,
+    output logic        spi_csn1,
+    output logic        spi_csn2,
+    output logic        spi_csn3,
     output logic        spi_sdo0,
     output logic        spi_sdo1,
     output logic        spi_sdo2,
@@ -64,39 +126,150 @@ module spi_flash_wrapper (
     logic [31:0] ctrl_data_rx;
     logic        ctrl_data_rx_valid;
     logic        ctrl_data_rx_ready;
+    logic        fifo_rx_ready;
 
-    logic [3:0]  elements_tx;
-    logic [3:0]  elements_rx;
+    // same as `log2 in spi_master_fifo, elements_o is [LOG:0]
+    localparam TX_LOG_DEPTH = $clog2(TX_FIFO_DEPTH + 1);
+    localparam RX_LOG_DEPTH = $clog2(RX_FIFO_DEPTH + 1);
+
+    logic [TX_LOG_DEPTH:0] elements_tx;
+    logic [RX_LOG_DEPTH:0] elements_rx;
 
     logic        raw_sdo0, raw_sdo1, raw_sdo2, raw_sdo3;
 
+    logic        cont_q;
+    logic        host_cont;         // continuous_i of the host start, also while it waits
+    logic        host_cont_q;
+
+    // Command fields: direct inputs, or the sequencer's head descriptor
+    logic        seq_req;
+    logic        seq_grant;
+    logic        seq_eot;
+    logic [1:0]  seq_cs;
+    logic        seq_done;
+    logic [7:0]  seq_command;
+    logic [31:0] seq_addr;
+    logic        seq_addr_4b;
+    logic [12:0] seq_data_count;
+    logic [1:0]  seq_data_mode;
+    logic [1:0]  seq_addr_mode;
+    logic        seq_rd_wr;
+    logic        seq_has_addr;
+    logic [4:0]  seq_dummy_cycle;
+    logic        seq_dtr;
+    logic        seq_poll_start;
+
+    logic        poll_busy;         // any device
+    logic        poll_xfer;
+    logic        poll_done;
+    logic        poll_timeout;
+    logic        poll_rx_ready;
+
+    logic        start;
+    logic [1:0]  owner;
+    logic [1:0]  cs;
+    logic [7:0]  command;
+    logic [31:0] addr;
+    logic        addr_4b;
+    logic [12:0] data_count_in;
+    logic [1:0]  data_mode;
+    logic [1:0]  addr_mode;
+    logic        rd_wr;
+    logic        has_addr;
+    logic [4:0]  dummy_cycle;
+    logic        dtr;
+    logic        mode_en;
+    logic        no_cmd;
+
+    // the owner of the transfer (spi_master_sched owner_o): a poll engine,
+    // the queue or the host
+    localparam logic [1:0] OWN_HOST = 2'd0;
+    localparam logic [1:0] OWN_SEQ  = 2'd1;
+    localparam logic [1:0] OWN_POLL = 2'd2;
+
+    always_comb begin
+        if (owner == OWN_POLL) begin
+            command       = poll_cmd_i;
+            addr          = 32'h0;
+            addr_4b       = 1'b0;
+            data_count_in = 13'd0;      // one status byte
+            data_mode     = 2'b01;
+            addr_mode     = 2'b01;
+            rd_wr         = 1'b1;
+            has_addr      = 1'b0;
+            dummy_cycle   = 5'd0;
+            dtr           = 1'b0;
+            mode_en       = 1'b0;
+            no_cmd        = 1'b0;
+        end else if (owner == OWN_SEQ) begin
+            command       = seq_command;
+            addr          = seq_addr;
+            addr_4b       = seq_addr_4b;
+            data_count_in = seq_data_count;
+            data_mode     = seq_data_mode;
+            addr_mode     = seq_addr_mode;
+            rd_wr         = seq_rd_wr;
+            has_addr      = seq_has_addr;
+            dummy_cycle   = seq_dummy_cycle;
+            dtr           = seq_dtr;
+            mode_en       = 1'b0;       // no descriptor bits left
+            no_cmd        = 1'b0;
+        end else begin
+            command       = command_i;
+            addr          = addr_i;
+            addr_4b       = addr_4b_i;
+            data_count_in = data_count_i;
+            data_mode     = data_mode_i;
+            addr_mode     = addr_mode_i;
+            rd_wr         = rd_wr_i;
+            has_addr      = has_addr_i;
+            dummy_cycle   = dummy_cycle_i;
+            dtr           = dtr_i;
+            mode_en       = mode_en_i;
+            no_cmd        = no_cmd_i;
+        end
+    end
+
     // -------------------------------------------------------------------------
     // Derived signals
     // -------------------------------------------------------------------------
 
     // data_len in bits: (data_count_i + 1) * 8
-    // data_count_i is 8-bit, +1 max = 256, *8 = 2048 fits in 16 bits fine
+    // spi_data_len is 16-bit, so the longest transfer is 8191 bytes
+    // (data_count_i = 8190); 8191 would wrap to 0. Such a command is not
+    // started: a direct one sets status_o and len_err_o right away, a queued
+    // one sets len_err_o and ends the chain, the descriptor stays queued.
+    // A continuous read reloads one 32-bit word at a time until stopped;
+    // only host transfers are continuous, continuous_i is ignored while the
+    // queue or a poll owns the controller.
     logic [15:0] spi_data_len;
-    assign spi_data_len = (data_mode_i == 2'b00)
-                        ? 16'd0
-                        : {6'd0, data_count_i + 1'b1, 3'd0};
+    logic        host_start;
+    logic        host_len_err;
+    logic        seq_len_err;
+    assign host_start   = start && owner == OWN_HOST;
+    assign host_len_err = start_i && data_mode_i != 2'b00 && data_count_i == 13'h1FFF
+                       && !(continuous_i && rd_wr_i);
+    assign seq_len_err  = seq_req && seq_data_mode != 2'b00 && seq_data_count == 13'h1FFF;
+    assign spi_data_len = (data_mode == 2'b00) ? 16'd0
+                        : (owner == OWN_HOST && (cont_q || (host_start && host_cont && rd_wr_i))) ? 16'd32
+                        : {data_count_in + 13'd1, 3'd0};
 
     logic [5:0] spi_addr_len;
-    assign spi_addr_len = has_addr_i ? 6'd24 : 6'd0;
+    assign spi_addr_len = !has_addr ? 6'd0 : addr_4b ? 6'd32 : 6'd24;
 
-    // Start trigger — only pass start_i to the correct mode signal
+    // Start trigger — only pass start to the correct mode signal
     always_comb begin
         spi_rd  = 1'b0;
         spi_wr  = 1'b0;
         spi_qrd = 1'b0;
         spi_qwr = 1'b0;
         spi_drd = 1'b0;
-        if (start_i) begin
-            case (data_mode_i)
-                2'b00:  begin spi_wr = !rd_wr_i; spi_rd = rd_wr_i; end
-                2'b01:  begin spi_wr = !rd_wr_i; spi_rd = rd_wr_i; end
-                2'b10:  begin spi_drd = rd_wr_i;  spi_wr  = !rd_wr_i; end
-                2'b11:  begin spi_qwr = !rd_wr_i; spi_qrd = rd_wr_i; end
+        if (start) begin
+            case (data_mode)
+                2'b00:  begin spi_wr = !rd_wr; spi_rd = rd_wr; end
+                2'b01:  begin spi_wr = !rd_wr; spi_rd = rd_wr; end
+                2'b10:  begin spi_drd = rd_wr;  spi_wr  = !rd_wr; end
+                2'b11:  begin spi_qwr = !rd_wr; spi_qrd = rd_wr; end
                 default: ;
             endcase
         end
@@ -110,19 +283,67 @@ module spi_flash_wrapper (
             status_o <= 1'b0;
         else if (clr_status_i)
             status_o <= 1'b0;
-        else if (eot)
+        else if (seq_done || host_len_err || (!seq_busy_o && (poll_done || (eot && owner == OWN_HOST))))
             status_o <= 1'b1;
     end
 
-    assign busy_o = ~spi_csn;  // CS low = transfer in progress
+    always_ff @(posedge clk or negedge rstn) begin
+        if (!rstn)
+            len_err_o <= 1'b0;
+        else if (clr_status_i)
+            len_err_o <= 1'b0;
+        else if (host_len_err || seq_len_err)
+            len_err_o <= 1'b1;
+    end
+
+    always_ff @(posedge clk or negedge rstn) begin
+        if (!rstn)
+            poll_timeout_o <= 1'b0;
+        else if (clr_status_i)
+            poll_timeout_o <= 1'b0;
+        else if (poll_done && poll_timeout)
+            poll_timeout_o <= 1'b1;
+    end
+
+    assign busy_o = ~(spi_csn0 & spi_csn1 & spi_csn2 & spi_csn3);  // CS low = transfer in progress
+
+    // -------------------------------------------------------------------------
+    // Continuous read — set by start_i with continuous_i, cleared by stop_i;
+    // the controller finishes the word in flight and ends the transfer. A
+    // start_i that waits for the scheduler keeps its continuous_i.
+    // -------------------------------------------------------------------------
+    assign host_cont = start_i ? continuous_i : host_cont_q;
+
+    always_ff @(posedge clk or negedge rstn) begin
+        if (!rstn)
+            host_cont_q <= 1'b0;
+        else if (start_i)
+            host_cont_q <= continuous_i;
+    end
+
+    always_ff @(posedge clk or negedge rstn) begin
+        if (!rstn)
+            cont_q <= 1'b0;
+        else if (host_start)
+            cont_q <= host_cont && rd_wr_i && (data_mode_i != 2'b00);
+        else if (stop_i || eot)
+            cont_q <= 1'b0;
+    end
 
     // -------------------------------------------------------------------------
     // FIFO status
     // -------------------------------------------------------------------------
-    assign tx_fifo_full_o  = (elements_tx == 4'd8);
-    assign tx_fifo_empty_o = (elements_tx == 4'd0);
-    assign rx_fifo_full_o  = (elements_rx == 4'd8);
-    assign rx_fifo_empty_o = (elements_rx == 4'd0);
+    assign tx_fifo_full_o  = (32'(elements_tx) == TX_FIFO_DEPTH);
+    assign tx_fifo_empty_o = (elements_tx == 0);
+    assign rx_fifo_full_o  = (32'(elements_rx) == RX_FIFO_DEPTH);
+    assign rx_fifo_empty_o = (elements_rx == 0);
+
+    assign tx_almost_empty_o = (16'(elements_tx) <= tx_ae_thresh_i);
+    assign rx_almost_full_o  = (rx_af_thresh_i != 16'd0) && (16'(elements_rx) >= rx_af_thresh_i);
+
+    assign irq_o = (irq_en_i[0] & rx_almost_full_o)
+                 | (irq_en_i[1] & tx_almost_empty_o)
+                 | (irq_en_i[2] & status_o);
 
     // -------------------------------------------------------------------------
     // SDO masking — tie unused lines low in standard SPI mode
@@ -132,15 +353,111 @@ module spi_flash_wrapper (
     assign spi_sdo2 = (spi_mode != 2'b00) ? raw_sdo2 : 1'b0;
     assign spi_sdo3 = (spi_mode != 2'b00) ? raw_sdo3 : 1'b0;
 
+    // SDI pins are the flash IO0..IO3. In standard SPI the flash answers on
+    // IO1 (MISO), the controller samples sdi0 in that mode.
+    logic ctrl_sdi0;
+    assign ctrl_sdi0 = (spi_mode == 2'b00) ? spi_sdi1 : spi_sdi0;
+
     // err_msg not implemented yet
     assign err_msg_o = 4'b0000;
 
+    // -------------------------------------------------------------------------
+    // Command sequencer
+    // -------------------------------------------------------------------------
+    spi_master_seq #(
+        .DESC_DEPTH(DESC_DEPTH)
+    ) u_seq (
+        .clk              (clk),
+        .rstn             (rstn),
+
+        .desc_i           (desc_i),
+        .desc_cs_i        (desc_cs_i),
+        .desc_valid_i     (desc_valid_i),
+        .desc_ready_o     (desc_ready_o),
+        .flush_i          (flush_tx_i),   // flush_tx_i also drops queued descriptors
+
+        .start_i          (seq_start_i),
+        .busy_o           (seq_busy_o),
+        .done_o           (seq_done),
+
+        .req_o            (seq_req),
+        .grant_i          (seq_grant),
+        /* verilator lint_off PINCONNECTEMPTY */
+        .req_start_o      (),
+        /* verilator lint_on PINCONNECTEMPTY */
+        .req_cs_o         (seq_cs),
+        .req_command_o    (seq_command),
+        .req_addr_o       (seq_addr),
+        .req_addr_4b_o    (seq_addr_4b),
+        .req_data_count_o (seq_data_count),
+        .req_data_mode_o  (seq_data_mode),
+        .req_addr_mode_o  (seq_addr_mode),
+        .req_rd_wr_o      (seq_rd_wr),
+        .req_has_addr_o   (seq_has_addr),
+        .req_dummy_cycle_o(seq_dummy_cycle),
+        .req_dtr_o        (seq_dtr),
+
+        .poll_start_o     (seq_poll_start),
+        .dev_busy_i       (dev_busy_o[seq_cs]),
+        .polls_busy_i     (poll_busy),
+        .abort_i          ((poll_done && poll_timeout) || seq_len_err),
+
+        .eot_i            (seq_eot)
+    );
+
+    // -------------------------------------------------------------------------
+    // Chip select scheduler and status auto-poll, one engine per device
+    // -------------------------------------------------------------------------
+    spi_master_sched #(
+        .NUM_CS(NUM_CS)
+    ) u_sched (
+        .clk            (clk),
+        .rstn           (rstn),
+
+        .poll_cmd_i     (poll_cmd_i),
+        .poll_mask_i    (poll_mask_i),
+        .poll_match_i   (poll_match_i),
+        .poll_interval_i(poll_interval_i),
+        .poll_max_i     (poll_max_i),
+
+        .host_start_i   (start_i && !host_len_err),
+        .host_poll_i    (poll_start_i),
+        .host_cs_i      (cs_i),
+
+        .seq_busy_i     (seq_busy_o),
+        .seq_req_i      (seq_req && !seq_len_err),
+        .seq_grant_o    (seq_grant),
+        .seq_cs_i       (seq_cs),
+        .seq_poll_i     (seq_poll_start),
+
+        .start_o        (start),
+        .owner_o        (owner),
+        .cs_o           (cs),
+        .eot_i          (eot),
+        .seq_eot_o      (seq_eot),
+
+        .rx_data_i      (ctrl_data_rx),
+        .rx_valid_i     (ctrl_data_rx_valid),
+        .rx_ready_o     (poll_rx_ready),
+        .poll_xfer_o    (poll_xfer),
+
+        .dev_busy_o     (dev_busy_o),
+        .polls_busy_o   (poll_busy),
+        .poll_done_o    (poll_done),
+        .poll_timeout_o (poll_timeout),
+        .poll_count_o   (poll_count_o),
+        .poll_value_o   (poll_value_o)
+    );
+
+    // status bytes of the poll engine bypass the RX FIFO
+    assign ctrl_data_rx_ready = poll_xfer ? poll_rx_ready : fifo_rx_ready;
+
     // -------------------------------------------------------------------------
     // TX FIFO  (user → controller)
     // -------------------------------------------------------------------------
     spi_master_fifo #(
         .DATA_WIDTH  (32),
-        .BUFFER_DEPTH(8)
+        .BUFFER_DEPTH(TX_FIFO_DEPTH)
     ) u_txfifo (
         .clk_i  (clk),
         .rst_ni (rstn),
@@ -162,7 +479,7 @@ module spi_flash_wrapper (
     // -------------------------------------------------------------------------
     spi_master_fifo #(
         .DATA_WIDTH  (32),
-        .BUFFER_DEPTH(8)
+        .BUFFER_DEPTH(RX_FIFO_DEPTH)
     ) u_rxfifo (
         .clk_i  (clk),
         .rst_ni (rstn),
@@ -174,9 +491,9 @@ module spi_flash_wrapper (
         .valid_o(data_rx_valid_o),
         .ready_i(data_rx_ready_i),
 
-        .valid_i(ctrl_data_rx_valid),
+        .valid_i(ctrl_data_rx_valid && !poll_xfer),
         .data_i (ctrl_data_rx),
-        .ready_o(ctrl_data_rx_ready)
+        .ready_o(fifo_rx_ready)
     );
 
     // -------------------------------------------------------------------------
@@ -188,25 +505,34 @@ module spi_flash_wrapper (
         .eot  (eot),
 
         .spi_clk_div      ({2'b00, prescaler_i}),
-        .spi_clk_div_valid(start_i),  // only update divider when starting
+        .spi_clk_div_valid(start),  // only update divider when starting
 
-        /* verilator lint_off PINCONNECTEMPTY */
-        .spi_status(),
+        .spi_status(ctrl_status_o),
 
-        // CMD: 8 bits, left-aligned in 32-bit field
-        .spi_cmd    ({command_i, 24'b0}),
-        .spi_cmd_len(6'd8),
+        // CMD: 8 bits, left-aligned in 32-bit field; none in continuous read
+        .spi_cmd    ({command, 24'b0}),
+        .spi_cmd_len(no_cmd ? 6'd0 : 6'd8),
 
-        // ADDR: 24 bits, left-aligned in 32-bit field
-        .spi_addr    ({addr_i, 8'b0}),
+        // ADDR: 24 or 32 bits, left-aligned in 32-bit field
+        .spi_addr    (addr_4b ? addr : {addr[23:0], 8'b0}),
         .spi_addr_len(spi_addr_len),
 
         .spi_data_len(spi_data_len),
+        .spi_data_cont(cont_q && !stop_i),
+        .spi_dtr      (dtr),
+
+        // MODE: 8 bits after the address, counted apart from dummy_cycle
+        .spi_mode_bits   (mode_bits_i),
+        .spi_mode_bits_en(mode_en),
 
-        .spi_dummy_rd({11'b0, dummy_cycle_i}),
+        .spi_dummy_rd({11'b0, dummy_cycle}),
         .spi_dummy_wr(16'b0),
 
-        .spi_csreg(4'b0001),
+        .spi_csreg(4'b0001 << cs),
+
+        // opcode always on one lane; address on one, two or four (01/10/11)
+        .spi_cmd_lanes (2'b01),
+        .spi_addr_lanes((addr_mode == 2'b00) ? 2'b01 : addr_mode),
 
         .spi_rd (spi_rd),
         .spi_wr (spi_wr),
@@ -223,11 +549,10 @@ module spi_flash_wrapper (
         .spi_ctrl_data_rx_ready(ctrl_data_rx_ready),
 
         .spi_clk (spi_clk),
-        .spi_csn0(spi_csn),
-        /* verilator lint_off PINCONNECTEMPTY */
-        .spi_csn1(),
-        .spi_csn2(),
-        .spi_csn3(),
+        .spi_csn0(spi_csn0),
+        .spi_csn1(spi_csn1),
+        .spi_csn2(spi_csn2),
+        .spi_csn3(spi_csn3),
 
         .spi_mode(spi_mode),
 
@@ -236,10 +561,18 @@ module spi_flash_wrapper (
         .spi_sdo2(raw_sdo2),
         .spi_sdo3(raw_sdo3),
 
-        .spi_sdi0(spi_sdi0),
+        .spi_sdi0(ctrl_sdi0),
         .spi_sdi1(spi_sdi1),
         .spi_sdi2(spi_sdi2),
-        .spi_sdi3(spi_sdi3)
+        .spi_sdi3(spi_sdi3),
+
+        /* verilator lint_off PINCONNECTEMPTY */
+        .spi_state(),
+        .spi_data_tx_start(),
+        .spi_data_rx_start(),
+        .spi_tx_stall(),
+        .spi_rx_stall()
+        /* verilator lint_on PINCONNECTEMPTY */
     );
 
 endmodule
\ No newline at end of file
@@ -0,0 +1,93 @@
+// DPI-C side of spi_log.svh: runtime log levels and the binary log.
+//
+// Linked into every model that contains a logging module (see Makefile,
+// DPI_SRC). Levels are read from the plusargs once per module instance, at
+// time zero; the binary log is opened by the first instance that asks for a
+// source id and written through a large stdio buffer.
+#include "spi_log.h"
+#include "verilated.h"
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+// every testbench keeps its time here (tick() loops)
+extern vluint64_t sim_time;
+
+namespace {
+
+const int DEFAULT_LEVEL = 3;   // info
+
+struct BinLog {
+    FILE* f       = nullptr;
+    bool  checked = false;
+    int   sources = 0;
+
+    ~BinLog() {
+        if (f) std::fclose(f);
+    }
+};
+
+BinLog bin_log;
+
+// Value of +<name>=<value>, or nullptr when absent
+const char* plusarg_value(const std::string& name) {
+    std::string key = name + "=";
+    const char* arg = Verilated::commandArgsPlusMatch(key.c_str());
+    if (!arg || !arg[0]) return nullptr;
+    return arg + 1 + key.size();
+}
+
+}
+
+extern "C" {
+
+int spi_log_level(const char* tag) {
+    std::string name = "spi_log_";
+    for (const char* p = tag; *p; p++)
+        name += char(std::tolower(static_cast<unsigned char>(*p)));
+    const char* v = plusarg_value(name);
+    if (!v) v = plusarg_value("spi_log");
+    return v ? std::atoi(v) : DEFAULT_LEVEL;
+}
+
+int spi_log_source(const char* tag, const char* path) {
+    if (!bin_log.checked) {
+        bin_log.checked = true;
+        if (const char* file = plusarg_value("spi_log_bin")) {
+            bin_log.f = std::fopen(file, "wb");
+            if (!bin_log.f) {
+                std::printf("[LOG] Cannot open binary log %s\n", file);
+            } else {
+                std::setvbuf(bin_log.f, nullptr, _IOFBF, 1 << 20);
+                std::fwrite(SPI_LOG_MAGIC, 1, sizeof(SPI_LOG_MAGIC), bin_log.f);
+            }
+        }
+    }
+    if (!bin_log.f) return -1;
+
+    std::string name = std::string(tag) + " " + path;
+    SpiLogRecord r = {};
+    r.time = sim_time;
+    r.src  = uint16_t(bin_log.sources);
+    r.ev   = SPI_EV_SOURCE;
+    r.aux  = uint32_t(name.size());
+    std::fwrite(&r, sizeof(r), 1, bin_log.f);
+    std::fwrite(name.data(), 1, name.size(), bin_log.f);
+    return bin_log.sources++;
+}
+
+void spi_log_record(int src, int ev, unsigned long long data, unsigned int aux) {
+    if (!bin_log.f) return;   // source ids restored from a checkpoint
+    SpiLogRecord r;
+    r.time = sim_time;
+    r.data = data;
+    r.aux  = aux;
+    r.src  = uint16_t(src);
+    r.ev   = uint8_t(ev);
+    r.rsvd = 0;
+    std::fwrite(&r, sizeof(r), 1, bin_log.f);
+}
+
+}
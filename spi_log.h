@@ -0,0 +1,34 @@
+// Binary transaction log of the RTL models (`SPI_LOG_REC in spi_log.svh).
+//
+// Written by spi_log.cpp when a model runs with +spi_log_bin=<file>, read by
+// spi_log_decode. The file is "SPILOG01" followed by SpiLogRecord entries,
+// little-endian. A SPI_EV_SOURCE record names a logging module instance:
+// src is its id, aux the length of the name that follows the record
+// ("<TAG> <hierarchical path>"). Times are the testbench's sim_time (half
+// clock cycles of the tick() loops).
+#pragma once
+
+#include <cstdint>
+
+enum SpiLogEvent : uint8_t {
+    SPI_EV_SOURCE = 0,
+    SPI_EV_CMD    = 1,   // data: opcode
+    SPI_EV_ADDR   = 2,   // data: address
+    SPI_EV_PROG   = 3,   // data: byte, aux: address
+    SPI_EV_ERASE  = 4,   // data: length, aux: address
+    SPI_EV_PUSH   = 5,   // data: word, aux: elements after the push
+    SPI_EV_POP    = 6    // data: word, aux: elements after the pop
+};
+
+struct SpiLogRecord {
+    uint64_t time;
+    uint64_t data;
+    uint32_t aux;
+    uint16_t src;
+    uint8_t  ev;
+    uint8_t  rsvd;
+};
+
+static_assert(sizeof(SpiLogRecord) == 24, "SpiLogRecord layout");
+
+static const char SPI_LOG_MAGIC[8] = {'S', 'P', 'I', 'L', 'O', 'G', '0', '1'};
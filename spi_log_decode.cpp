@@ -0,0 +1,144 @@
+// Offline decoder for the binary transaction log (+spi_log_bin, spi_log.h).
+//
+//   spi_log_decode <file> [--src <tag|path suffix>] [--stats]
+//
+// Prints one line per record, "<time> <TAG> <event> ...", in the wording of
+// the text log. --src keeps the records of the matching sources only,
+// --stats prints a count per source and event instead.
+#include "spi_log.h"
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace {
+
+const char* const ev_names[] = {"SOURCE", "CMD", "ADDR", "PROG", "ERASE", "PUSH",
+                                "POP"};
+const unsigned NUM_EVENTS = sizeof(ev_names) / sizeof(ev_names[0]);
+
+struct Source {
+    std::string tag;
+    std::string path;
+    bool        shown = true;
+};
+
+bool ends_with(const std::string& s, const std::string& suffix) {
+    return s.size() >= suffix.size() &&
+           s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+void print_record(const SpiLogRecord& r, const Source& s) {
+    std::printf("%12llu %-6s ", (unsigned long long)r.time, s.tag.c_str());
+    switch (r.ev) {
+        case SPI_EV_CMD:
+            std::printf("CMD: 0x%02llx\n", (unsigned long long)r.data);
+            break;
+        case SPI_EV_ADDR:
+            std::printf("ADDR: 0x%06llx\n", (unsigned long long)r.data);
+            break;
+        case SPI_EV_PROG:
+            std::printf("Write [0x%06x] = 0x%02llx\n", r.aux, (unsigned long long)r.data);
+            break;
+        case SPI_EV_ERASE:
+            std::printf("Erase 0x%06x, %llu bytes\n", r.aux, (unsigned long long)r.data);
+            break;
+        case SPI_EV_PUSH:
+            std::printf("wrote 0x%08llx elements=%u  %s\n", (unsigned long long)r.data,
+                        r.aux, s.path.c_str());
+            break;
+        case SPI_EV_POP:
+            std::printf("read  0x%08llx elements=%u  %s\n", (unsigned long long)r.data,
+                        r.aux, s.path.c_str());
+            break;
+        default:
+            std::printf("event %u data=0x%llx aux=0x%x\n", r.ev,
+                        (unsigned long long)r.data, r.aux);
+            break;
+    }
+}
+
+}
+
+int main(int argc, char** argv) {
+    const char* file = nullptr;
+    std::string src_filter;
+    bool stats = false;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--src") == 0 && i + 1 < argc)
+            src_filter = argv[++i];
+        else if (std::strcmp(argv[i], "--stats") == 0)
+            stats = true;
+        else if (argv[i][0] != '-' && !file)
+            file = argv[i];
+        else {
+            std::fprintf(stderr, "usage: %s <file> [--src <tag|path suffix>] [--stats]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (!file) {
+        std::fprintf(stderr, "usage: %s <file> [--src <tag|path suffix>] [--stats]\n", argv[0]);
+        return 2;
+    }
+
+    FILE* f = std::fopen(file, "rb");
+    if (!f) {
+        std::fprintf(stderr, "cannot open %s\n", file);
+        return 1;
+    }
+    char magic[sizeof(SPI_LOG_MAGIC)];
+    if (std::fread(magic, 1, sizeof(magic), f) != sizeof(magic) ||
+        std::memcmp(magic, SPI_LOG_MAGIC, sizeof(magic)) != 0) {
+        std::fprintf(stderr, "%s: not a binary SPI log\n", file);
+        std::fclose(f);
+        return 1;
+    }
+
+    std::vector<Source> sources;
+    std::map<std::pair<uint16_t, uint8_t>, uint64_t> counts;
+    Source unknown;
+    unknown.tag = "?";
+    SpiLogRecord r;
+    uint64_t records = 0;
+    int status = 0;
+
+    while (std::fread(&r, sizeof(r), 1, f) == 1) {
+        records++;
+        if (r.ev == SPI_EV_SOURCE) {
+            std::string name(r.aux, '\0');
+            if (std::fread(&name[0], 1, r.aux, f) != r.aux) {
+                std::fprintf(stderr, "%s: truncated source record\n", file);
+                status = 1;
+                break;
+            }
+            Source s;
+            size_t sp = name.find(' ');
+            s.tag  = name.substr(0, sp);
+            s.path = sp == std::string::npos ? "" : name.substr(sp + 1);
+            s.shown = src_filter.empty() || s.tag == src_filter ||
+                      ends_with(s.path, src_filter);
+            if (sources.size() <= r.src) sources.resize(r.src + 1);
+            sources[r.src] = s;
+            continue;
+        }
+        const Source& s = r.src < sources.size() ? sources[r.src] : unknown;
+        if (!s.shown) continue;
+        if (stats)
+            counts[{r.src, r.ev}]++;
+        else
+            print_record(r, s);
+    }
+    std::fclose(f);
+
+    if (stats) {
+        std::printf("%llu records\n", (unsigned long long)records);
+        for (const auto& c : counts) {
+            const Source& s = c.first.first < sources.size() ? sources[c.first.first] : unknown;
+            std::printf("%-6s %-6s %12llu  %s\n", s.tag.c_str(),
+                        c.first.second < NUM_EVENTS ? ev_names[c.first.second] : "?",
+                        (unsigned long long)c.second, s.path.c_str());
+        }
+    }
+    return status;
+}
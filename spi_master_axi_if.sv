@@ -20,6 +20,25 @@
 `define REG_SPIADR 3'b011
 `define REG_SPILEN 3'b100
 `define REG_SPIDUM 3'b101
+`define REG_FIFOTH 3'b110
+`define REG_XIPCFG 3'b111
+
+// Write-only launch pair in the write space above the TX FIFO window (reads
+// of 0x40/0x44 are the RX FIFO window). REG_LNADDR holds the flash byte
+// address, right-aligned. A full-word write to REG_LAUNCH loads the command
+// registers from its fields and starts the transfer in the same write:
+//   [7:0]   opcode (8-bit command)
+//   [9:8]   address: 0 none, 1 REG_LNADDR[23:0], 2 or 3 REG_LNADDR[31:0]
+//   [11:10] operation: 0 rd, 1 wr, 2 qrd, 3 qwr (as REG_STATUS[3:0])
+//   [15:12] dummy cycles, read and write
+//   [27:16] data bytes
+//   [31:28] chip select (as REG_STATUS[11:8])
+// The loaded values read back through REG_SPICMD .. REG_SPIDUM. The fields
+// are narrower than the registers they load: at most 15 dummy cycles, the
+// same count for reads and writes, and at most 4095 data bytes. Longer or
+// asymmetric commands go through REG_SPILEN/REG_SPIDUM and REG_STATUS.
+`define REG_LNADDR 5'b10000
+`define REG_LAUNCH 5'b10001
 
 module spi_master_axi_if #(
       parameter AXI4_ADDRESS_WIDTH = 32,
@@ -77,6 +96,11 @@ module spi_master_axi_if #(
     output logic                   [15:0] spi_data_len,
     output logic                   [15:0] spi_dummy_rd,
     output logic                   [15:0] spi_dummy_wr,
+    output logic                    [7:0] spi_tx_ae_th,
+    output logic                    [7:0] spi_rx_af_th,
+    output logic                    [2:0] spi_irq_en,
+    output logic                   [31:0] spi_xip_cfg,
+    output logic                          spi_xip_cfg_valid,
     output logic                          spi_swrst,
     output logic                          spi_rd,
     output logic                          spi_wr,
@@ -87,7 +111,11 @@ module spi_master_axi_if #(
     input  logic                          spi_data_tx_ready,
     input  logic                   [31:0] spi_data_rx,
     input  logic                          spi_data_rx_valid,
-    output logic                          spi_data_rx_ready
+    output logic                          spi_data_rx_ready,
+    output logic                          spi_perf_snapshot,
+    output logic                          spi_perf_clear,
+    output logic                    [3:0] spi_perf_addr,
+    input  logic                   [31:0] spi_perf_rdata
     );
 
   localparam WR_ADDR_CMP = `log2(AXI4_WDATA_WIDTH/8)-1;
@@ -96,7 +124,7 @@ module spi_master_axi_if #(
   localparam OFFSET_BIT  =  ( `log2(AXI4_WDATA_WIDTH-1) - 3 );  // Address Offset: OFFSET IS 32bit--> 2bit; 64bit--> 3bit; 128bit--> 4bit and so on
 
   logic                 [4:0] wr_addr;
-  logic                 [4:0] rd_addr;
+  logic                 [5:0] rd_addr;    // 0x80-0xBC: performance counters
 
   logic                       is_tx_fifo_sel;
   logic                       is_rx_fifo_sel;
@@ -104,9 +132,9 @@ module spi_master_axi_if #(
   logic                       is_rx_fifo_sel_q;
 
   logic                       read_req;
-  logic                 [4:0] read_address;
+  logic                 [5:0] read_address;
   logic                       sample_AR;
-  logic                 [4:0] ARADDR_Q;
+  logic                 [5:0] ARADDR_Q;
   logic                 [7:0] ARLEN_Q;
   logic                       decr_ARLEN;
   logic                 [7:0] CountBurstCS;
@@ -121,18 +149,21 @@ module spi_master_axi_if #(
   logic                 [4:0] AWADDR_Q;
   logic                 [7:0] AWLEN_Q;
   logic                       decr_AWLEN;
-  logic                 [7:0] CountBurst_AW_CS;
-  logic                 [7:0] CountBurst_AW_NS;
+  logic                       aw_first_beat;
+  logic                       w_ok;
+  logic                       w_ok_q;
   logic   [AXI4_ID_WIDTH-1:0] AWID_Q;
   logic [AXI4_USER_WIDTH-1:0] AWUSER_Q;
 
-  enum logic [2:0] { IDLE, SINGLE, BURST, WAIT_WDATA_BURST, WAIT_WDATA_SINGLE, BURST_RESP } AR_CS, AR_NS, AW_CS, AW_NS;
+  logic                [31:0] spi_launch_addr;
+
+  enum logic [2:0] { IDLE, SINGLE, BURST, WAIT_WDATA_SINGLE, BURST_RESP } AR_CS, AR_NS, AW_CS, AW_NS;
 
   assign wr_addr = s_axi_awaddr[WR_ADDR_CMP+4:WR_ADDR_CMP];
-  assign rd_addr = s_axi_araddr[RD_ADDR_CMP+4:RD_ADDR_CMP];
+  assign rd_addr = s_axi_araddr[RD_ADDR_CMP+5:RD_ADDR_CMP];
 
   assign is_tx_fifo_sel = (wr_addr[3] == 1'b1);
-  assign is_rx_fifo_sel = (rd_addr[4] == 1'b1);
+  assign is_rx_fifo_sel = (rd_addr[5:4] == 2'b01);
 
   assign spi_data_tx = s_axi_wdata[31:0];
 
@@ -146,7 +177,6 @@ module spi_master_axi_if #(
       CountBurstCS <= '0;
       ARID_Q       <= '0;
       ARUSER_Q     <= '0;
-      is_tx_fifo_sel_q <= '0;
       is_rx_fifo_sel_q <= '0;
     end
     else
@@ -154,8 +184,9 @@ module spi_master_axi_if #(
       AR_CS <= AR_NS;
       CountBurstCS <= CountBurstNS;
 
-      is_tx_fifo_sel_q <= is_tx_fifo_sel;
-      is_rx_fifo_sel_q <= is_rx_fifo_sel;
+      // FIFO select belongs to the burst, taken with the address
+      if(sample_AR)
+        is_rx_fifo_sel_q <= is_rx_fifo_sel;
 
       if(sample_AR)
         ARLEN_Q  <=  s_axi_arlen;
@@ -166,7 +197,7 @@ module spi_master_axi_if #(
       if(sample_AR)
       begin
         ARID_Q   <=  s_axi_arid;
-        ARADDR_Q <=  read_address;
+        ARADDR_Q <=  rd_addr;
         ARUSER_Q <=  s_axi_aruser;
       end
     end
@@ -205,7 +236,7 @@ module spi_master_axi_if #(
           else
           begin
             AR_NS = BURST;
-            CountBurstNS   = CountBurstCS + 1'b1;
+            CountBurstNS   = '0;
           end
         end
         else
@@ -240,7 +271,6 @@ module spi_master_axi_if #(
           begin
             sample_AR      = 1'b1;
             read_req       = 1'b1;
-            read_address   =  rd_addr;
 
             if(s_axi_arlen == 0)
             begin
@@ -250,7 +280,7 @@ module spi_master_axi_if #(
             else
             begin
               AR_NS          = BURST;
-              CountBurstNS   = CountBurstCS + 1'b1;
+              CountBurstNS   = '0;
             end
           end
           else
@@ -271,10 +301,12 @@ module spi_master_axi_if #(
 
       BURST:
       begin
+        // beat CountBurstCS; INCR over registers, the RX FIFO window stays put
         s_axi_rresp  = `OKAY;
         s_axi_rid    = ARID_Q;
         s_axi_ruser  = ARUSER_Q;
-        read_address   =  ARADDR_Q;
+        read_address = is_rx_fifo_sel_q ? ARADDR_Q : ARADDR_Q + CountBurstCS[5:0];
+        s_axi_rlast  = (ARLEN_Q == 0);
 
         if (is_rx_fifo_sel_q)
           s_axi_rvalid = spi_data_rx_valid;
@@ -289,9 +321,9 @@ module spi_master_axi_if #(
           if(ARLEN_Q > 0)
           begin
             AR_NS         = BURST;
-            read_req      = 1'b1; // read the previous address
+            read_req      = 1'b1;
             decr_ARLEN    = 1'b1;
-            read_address  =  ARADDR_Q + CountBurstCS ;
+            CountBurstNS  = CountBurstCS + 1'b1;
             s_axi_rlast         = 1'b0;
             s_axi_arready       = 1'b0;
           end
@@ -304,7 +336,6 @@ module spi_master_axi_if #(
             begin
               sample_AR      = 1'b1;
               read_req       = 1'b1;
-              read_address   = rd_addr;
 
               if(s_axi_arlen == 0)
               begin
@@ -314,7 +345,7 @@ module spi_master_axi_if #(
               else
               begin
                 AR_NS = BURST;
-                CountBurstNS   = 1;
+                CountBurstNS   = 0;
               end
             end
             else
@@ -328,9 +359,8 @@ module spi_master_axi_if #(
         else
         begin
           AR_NS          = BURST;
-          read_req     = 1'b1; // read the previous address
+          read_req     = 1'b1;
           decr_ARLEN   = 1'b0;
-          read_address =  ARADDR_Q + CountBurstCS;
           s_axi_arready      = 1'b0;
         end
 
@@ -342,26 +372,31 @@ module spi_master_axi_if #(
   end
 
   //Write FSM
+  // Beats to the TX FIFO window are only accepted while the FIFO has room
+  // (wready follows spi_data_tx_ready), so a burst streams straight into the
+  // FIFO with back-pressure. AWLEN_Q counts the beats still to come, minus
+  // one; bursts to a register all go to that register.
   always_ff @(posedge s_axi_aclk, negedge s_axi_aresetn)
   begin
     if(s_axi_aresetn == 1'b0)
     begin
       AW_CS            <= IDLE;
       AWADDR_Q         <= '0;
-      CountBurst_AW_CS <= '0;
+      AWLEN_Q          <= '0;
       AWID_Q           <= '0;
       AWUSER_Q         <= '0;
+      is_tx_fifo_sel_q <= '0;
     end
     else
     begin
       AW_CS <= AW_NS;
-      CountBurst_AW_CS <= CountBurst_AW_NS;
       if(sample_AW)
       begin
-        AWLEN_Q  <=  s_axi_awlen;
+        AWLEN_Q  <=  s_axi_awlen - {7'b0, aw_first_beat};
         AWADDR_Q <=  wr_addr;
         AWID_Q   <=  s_axi_awid;
         AWUSER_Q <=  s_axi_awuser;
+        is_tx_fifo_sel_q <= is_tx_fifo_sel;
       end
       else
       if(decr_AWLEN)
@@ -371,15 +406,19 @@ module spi_master_axi_if #(
     end
   end
 
+  // a beat can be taken: not the TX FIFO, or the TX FIFO has room
+  assign w_ok   = !is_tx_fifo_sel   || spi_data_tx_ready;
+  assign w_ok_q = !is_tx_fifo_sel_q || spi_data_tx_ready;
+
   always_comb
   begin
-    s_axi_awready        = 1'b0;
-    s_axi_wready         = 1'b0;
+    s_axi_awready  = 1'b0;
+    s_axi_wready   = 1'b0;
     write_address  = '0;
-    write_req       = 1'b0;
+    write_req      = 1'b0;
     sample_AW      = 1'b0;
+    aw_first_beat  = 1'b0;
     decr_AWLEN     = 1'b0;
-    CountBurst_AW_NS   = CountBurst_AW_CS;
     s_axi_bid   = '0;
     s_axi_bresp = `OKAY;
     s_axi_buser = '0;
@@ -389,238 +428,71 @@ module spi_master_axi_if #(
     case(AW_CS)
       IDLE:
       begin
-        s_axi_awready        = 1'b1;
-
+        s_axi_awready = 1'b1;
         if(s_axi_awvalid)
         begin
-          sample_AW       = 1'b1;
+          sample_AW = 1'b1;
 
-          if(s_axi_wvalid)
+          if(s_axi_wvalid && w_ok)
           begin
-              s_axi_wready    = 1'b1;
-              write_req       = 1'b1;
-              write_address   =  wr_addr;
-              if(s_axi_awlen == 0)
-              begin
-                AW_NS = SINGLE;
-                CountBurst_AW_NS   = 0;
-              end
-              else
-              begin
-                AW_NS = BURST;
-                CountBurst_AW_NS   = 1;
-              end
+            s_axi_wready  = 1'b1;
+            write_req     = 1'b1;
+            write_address = wr_addr;
+            if(s_axi_awlen == 0)
+              AW_NS = SINGLE;
+            else
+            begin
+              aw_first_beat = 1'b1;
+              AW_NS         = BURST;
+            end
           end
           else // GOT ADDRESS WRITE, not DATA
           begin
-            s_axi_wready    = 1'b1;
-            write_req       = 1'b0;
-            write_address   = '0;
-
             if(s_axi_awlen == 0)
-            begin
-              AW_NS             =  WAIT_WDATA_SINGLE;
-              CountBurst_AW_NS  = 0;
-            end
+              AW_NS = WAIT_WDATA_SINGLE;
             else
-            begin
-              AW_NS =  WAIT_WDATA_BURST;
-              CountBurst_AW_NS    = 0;
-            end
+              AW_NS = BURST;
           end
         end
-        else
-        begin
-          s_axi_wready         = 1'b1;
-          AW_NS              = IDLE;
-          CountBurst_AW_NS   = '0;
-        end
-
       end //~ IDLE
 
-
-      WAIT_WDATA_BURST :
-      begin
-        s_axi_awready        = 1'b0;
-
-        if(s_axi_wvalid)
-        begin
-            s_axi_wready     = 1'b1;
-            write_req        = 1'b1;
-            write_address    = AWADDR_Q;
-            AW_NS            = BURST;
-            CountBurst_AW_NS = 1;
-            decr_AWLEN       = 1'b1;
-        end
-        else
-        begin
-          s_axi_wready         = 1'b1;
-          write_req              =  1'b0;
-          AW_NS                  = WAIT_WDATA_BURST; // wait for data
-          CountBurst_AW_NS       = '0;
-        end
-
-      end //~WAIT_WDATA_BURST
-
       WAIT_WDATA_SINGLE :
       begin
-        s_axi_awready        = 1'b0;
-        CountBurst_AW_NS = '0;
-
-        if(s_axi_wvalid)
-        begin
-            s_axi_wready         = 1'b1;
-            write_req        = 1'b1;
-            write_address    = AWADDR_Q;
-            AW_NS            = SINGLE;
-        end
-        else
+        if(s_axi_wvalid && w_ok_q)
         begin
-          s_axi_wready         = 1'b1;
-          write_req        = 1'b0;
-          AW_NS = WAIT_WDATA_SINGLE; // wait for data
+          s_axi_wready  = 1'b1;
+          write_req     = 1'b1;
+          write_address = AWADDR_Q;
+          AW_NS         = SINGLE;
         end
       end
 
-      SINGLE: begin
-        s_axi_bid    = AWID_Q;
-        s_axi_bresp  = `OKAY;
-        s_axi_buser  = AWUSER_Q;
-        s_axi_bvalid = 1'b1;
-
-        // we have a valid response here, waiting to be delivered
-        if(s_axi_bready)
-        begin
-          s_axi_awready = 1'b1;
-          if(s_axi_awvalid)
-          begin
-            sample_AW       =   1'b1;
-            write_req       =   1'b1;
-            write_address   =   wr_addr;
-
-            if(s_axi_awlen == 0)
-            begin
-              AW_NS          = SINGLE;
-              CountBurst_AW_NS   = '0;
-            end
-            else
-            begin
-              AW_NS          = BURST;
-              CountBurst_AW_NS   = CountBurst_AW_CS + 1'b1;
-            end
-          end
-          else
-          begin
-            AW_NS = IDLE;
-            CountBurst_AW_NS   = '0;
-          end
-        end
-        else // NOt ready: stay here untile RR RADY is OK
-        begin
-          AW_NS            = SINGLE;
-          CountBurst_AW_NS = '0;
-          s_axi_awready          = 1'b0;
-        end
-
-      end //~ SINGLE
-
       BURST:
       begin
-
-        CountBurst_AW_NS = CountBurst_AW_CS;
-        s_axi_awready        = 1'b0;
-
-        //write_address  =  AWADDR_Q + CountBurst_AW_CS ;
-        write_address  =  AWADDR_Q; //TODO check burst type
-
-        if(s_axi_wvalid)
-        begin
-            s_axi_wready = 1'b1;
-            write_req      = 1'b1; // read the previous address
-            decr_AWLEN     = 1'b1;
-            CountBurst_AW_NS   = CountBurst_AW_CS + 1'b1;
-        end
-        else
+        write_address = AWADDR_Q; // FIFO window or one register, no INCR
+        if(s_axi_wvalid && w_ok_q)
         begin
           s_axi_wready = 1'b1;
-          write_req      = 1'b0; // read the previous address
-          decr_AWLEN     = 1'b0;
-
-        end
-        if(AWLEN_Q > 0)
-        begin
-          AW_NS          = BURST;
-          //    AWREADY        = 1'b0;
-        end
-        else
-        begin
-          AW_NS          = BURST_RESP;
-          //    AWREADY        = 1'b1;
+          write_req    = 1'b1;
+          if(AWLEN_Q == 0)
+            AW_NS = BURST_RESP;
+          else
+            decr_AWLEN = 1'b1;
         end
       end //~ BURST
 
-
-      BURST_RESP :
+      SINGLE, BURST_RESP:
       begin
-        s_axi_bvalid  = 1'b1;
-        s_axi_bid     = AWID_Q;
-        s_axi_bresp   = `OKAY;
-        s_axi_buser   = AWUSER_Q;
+        s_axi_bid    = AWID_Q;
+        s_axi_bresp  = `OKAY;
+        s_axi_buser  = AWUSER_Q;
+        s_axi_bvalid = 1'b1;
         if(s_axi_bready)
-        begin
-          s_axi_awready = 1'b1;
-          // Check if there are any pending request
-          if(s_axi_awvalid)
-          begin
-            sample_AW = 1'b1;
-            if(s_axi_wvalid)
-            begin
-                s_axi_wready = 1'b1;
-                write_req       = 1'b1;
-                write_address   = wr_addr;
-                if(s_axi_awlen == 0)
-                begin
-                  AW_NS            = SINGLE;
-                  CountBurst_AW_NS = 0;
-                end
-                else
-                begin
-                  AW_NS = BURST;
-                  CountBurst_AW_NS   = 1;
-                end
-            end
-            else // GOT ADDRESS WRITE, not DATA
-            begin
-              s_axi_wready = 1'b1;
-              write_req       = 1'b0;
-              write_address   = '0;
-
-              if(s_axi_awlen == 0)
-              begin
-                AW_NS             =  WAIT_WDATA_SINGLE;
-                CountBurst_AW_NS  = 0;
-              end
-              else
-              begin
-                AW_NS            = WAIT_WDATA_BURST;
-                CountBurst_AW_NS = 0;
-              end
-            end
-          end
-          else
-          begin
-            s_axi_wready = 1'b1;
-            AW_NS            = IDLE;
-            CountBurst_AW_NS = '0;
-          end
-        end
-        else //~BREADY
-        begin
-          AW_NS         = BURST_RESP;
-          s_axi_awready = 1'b0;
-          s_axi_wready = 1'b0;
-        end
+          AW_NS = IDLE;
       end
+
+      default:
+        AW_NS = IDLE;
     endcase
   end
 
@@ -633,6 +505,8 @@ module spi_master_axi_if #(
       spi_wr            = 1'b0;
       spi_qrd           = 1'b0;
       spi_qwr           = 1'b0;
+      spi_perf_snapshot = 1'b0;
+      spi_perf_clear    = 1'b0;
       spi_clk_div_valid = 1'b0;
       spi_clk_div       =  'h0;
       spi_cmd           =  'h0;
@@ -643,6 +517,12 @@ module spi_master_axi_if #(
       spi_dummy_rd    =  'h0;
       spi_dummy_wr      =  'h0;
       spi_csreg         =  'h0;
+      spi_tx_ae_th      =  'h0;
+      spi_rx_af_th      =  'h0;
+      spi_irq_en        =  'h0;
+      spi_xip_cfg       = 32'h0000_080B;  // disabled, 0x0B with 8 dummy cycles
+      spi_xip_cfg_valid = 1'b0;
+      spi_launch_addr   =  'h0;
     end
     else if (write_req)
     begin
@@ -651,7 +531,10 @@ module spi_master_axi_if #(
       spi_wr    = 1'b0;
       spi_qrd   = 1'b0;
       spi_qwr   = 1'b0;
+      spi_perf_snapshot = 1'b0;
+      spi_perf_clear    = 1'b0;
       spi_clk_div_valid = 1'b0;
+      spi_xip_cfg_valid = 1'b0;
       case(write_address)
         `REG_STATUS:
         begin
@@ -662,6 +545,8 @@ module spi_master_axi_if #(
             spi_qrd = s_axi_wdata[2];
             spi_qwr = s_axi_wdata[3];
             spi_swrst = s_axi_wdata[4];
+            spi_perf_snapshot = s_axi_wdata[5];
+            spi_perf_clear    = s_axi_wdata[6];
           end
           if ( s_axi_wstrb[1] == 1 )
           begin
@@ -704,6 +589,57 @@ module spi_master_axi_if #(
           if ( s_axi_wstrb[3] == 1 )
             spi_dummy_wr[15:8] = s_axi_wdata[31:24];
         end
+        `REG_FIFOTH:
+        begin
+          if ( s_axi_wstrb[0] == 1 )
+            spi_tx_ae_th = s_axi_wdata[7:0];
+          if ( s_axi_wstrb[1] == 1 )
+            spi_rx_af_th = s_axi_wdata[15:8];
+          if ( s_axi_wstrb[2] == 1 )
+            spi_irq_en = s_axi_wdata[18:16];
+        end
+        `REG_XIPCFG:
+        begin
+          for ( int byte_index = 0; byte_index < 4; byte_index = byte_index+1 )
+            if ( s_axi_wstrb[byte_index] == 1 )
+              spi_xip_cfg[byte_index*8 +: 8] = s_axi_wdata[(byte_index*8) +: 8];
+          spi_xip_cfg_valid = 1'b1;
+        end
+        `REG_LNADDR:
+          for ( int byte_index = 0; byte_index < 4; byte_index = byte_index+1 )
+            if ( s_axi_wstrb[byte_index] == 1 )
+              spi_launch_addr[byte_index*8 +: 8] = s_axi_wdata[(byte_index*8) +: 8];
+        `REG_LAUNCH:
+          if ( &s_axi_wstrb[3:0] )
+          begin
+            spi_cmd      = {s_axi_wdata[7:0], 24'h0};
+            spi_cmd_len  = 6'd8;
+            case ( s_axi_wdata[9:8] )
+              2'b00:
+              begin
+                spi_addr     = 'h0;
+                spi_addr_len = 6'd0;
+              end
+              2'b01:
+              begin
+                spi_addr     = {spi_launch_addr[23:0], 8'h0};
+                spi_addr_len = 6'd24;
+              end
+              default:
+              begin
+                spi_addr     = spi_launch_addr;
+                spi_addr_len = 6'd32;
+              end
+            endcase
+            spi_dummy_rd = {12'h0, s_axi_wdata[15:12]};
+            spi_dummy_wr = {12'h0, s_axi_wdata[15:12]};
+            spi_data_len = {1'b0, s_axi_wdata[27:16], 3'b000};
+            spi_csreg    = s_axi_wdata[31:28];
+            spi_rd       = (s_axi_wdata[11:10] == 2'd0);
+            spi_wr       = (s_axi_wdata[11:10] == 2'd1);
+            spi_qrd      = (s_axi_wdata[11:10] == 2'd2);
+            spi_qwr      = (s_axi_wdata[11:10] == 2'd3);
+          end
       endcase
     end
     else
@@ -713,7 +649,10 @@ module spi_master_axi_if #(
       spi_wr = 1'b0;
       spi_qrd = 1'b0;
       spi_qwr = 1'b0;
+      spi_perf_snapshot = 1'b0;
+      spi_perf_clear    = 1'b0;
       spi_clk_div_valid = 1'b0;
+      spi_xip_cfg_valid = 1'b0;
     end
   end // SLAVE_REG_WRITE_PROC
 
@@ -722,6 +661,8 @@ module spi_master_axi_if #(
   always_comb
     begin
       s_axi_rdata = {32'h0,spi_data_rx};
+      if (read_address[5])
+        s_axi_rdata[31:0] = spi_perf_rdata;
       case(read_address)
         `REG_STATUS:
                 s_axi_rdata[31:0] = spi_status;
@@ -735,9 +676,15 @@ module spi_master_axi_if #(
           s_axi_rdata[31:0] = {spi_data_len,2'b00,spi_addr_len,2'b00,spi_cmd_len};
         `REG_SPIDUM:
                 s_axi_rdata[31:0] = {spi_dummy_wr,spi_dummy_rd};
+        `REG_FIFOTH:
+                s_axi_rdata[31:0] = {13'h0,spi_irq_en,spi_rx_af_th,spi_tx_ae_th};
+        `REG_XIPCFG:
+                s_axi_rdata[31:0] = spi_xip_cfg;
       endcase
     end // SLAVE_REG_READ_PROC
 
-  assign spi_data_tx_valid = write_req & (write_address[3] == 1'b1);
+  assign spi_perf_addr = read_address[3:0];
+
+  assign spi_data_tx_valid = write_req & (write_address[3] == 1'b1);  // wready already waited for room
 
 endmodule
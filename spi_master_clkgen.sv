@@ -8,6 +8,11 @@
 // CONDITIONS OF ANY KIND, either express or implied. See the License for the
 // specific language governing permissions and limitations under the License.
 
+// spi_rise/spi_fall flag the system clock cycle after which spi_clk
+// toggles. spi_mid flags the cycle halfway between two toggles, where DTR
+// outputs change so that they are stable at both clock edges; with mid_en
+// set a divider of 0, which has no such cycle, runs as 1.
+
 module spi_master_clkgen
 (
     input  logic                        clk,
@@ -15,29 +20,36 @@ module spi_master_clkgen
     input  logic                        en,
     input  logic          [7:0]         clk_div,
     input  logic                        clk_div_valid,
+    input  logic                        mid_en,
     output logic                        spi_clk,
     output logic                        spi_fall,
-    output logic                        spi_rise
+    output logic                        spi_rise,
+    output logic                        spi_mid
 );
 
     logic [7:0] counter_trgt;
     logic [7:0] counter_trgt_next;
+    logic [7:0] counter_max;
     logic [7:0] counter;
     logic [7:0] counter_next;
 
     logic       spi_clk_next;
     logic       running;
 
+    assign counter_max = (mid_en && counter_trgt == 8'h0) ? 8'h1 : counter_trgt;
+
     always_comb
     begin
             spi_rise = 1'b0;
             spi_fall = 1'b0;
+            spi_mid  = 1'b0;
             if (clk_div_valid)
                 counter_trgt_next = clk_div;
             else
                 counter_trgt_next = counter_trgt;
 
-            if (counter == counter_trgt)
+            // >=: counter_max drops back to 0 when mid_en goes low
+            if (counter >= counter_max)
             begin
                 counter_next = 0;
                 spi_clk_next = ~spi_clk;
@@ -50,6 +62,7 @@ module spi_master_clkgen
             begin
                 counter_next = counter + 1;
                 spi_clk_next = spi_clk;
+                spi_mid      = running && (counter == (counter_max >> 1));
             end
     end
 
@@ -13,6 +13,15 @@
 `define SPI_QUAD_RX 2'b10
 `define SPI_DUAL_RX 2'b11 // specs only wants Read Dual Out, nothing else that requires Dual SPI
 
+// Lanes used by the CMD and ADDR phases (spi_cmd_lanes, spi_addr_lanes).
+// LEGACY keeps the original behaviour: 4 lanes for spi_qrd/spi_qwr (QPI),
+// otherwise 1 lane. Phases sent on 2 or 4 lanes report SPI_QUAD_TX on
+// spi_mode so that the pads drive sdo1-3.
+`define SPI_LANES_LEGACY 2'b00
+`define SPI_LANES_1      2'b01
+`define SPI_LANES_2      2'b10
+`define SPI_LANES_4      2'b11
+
 module spi_master_controller
 (
     input  logic                          clk,
@@ -20,7 +29,7 @@ module spi_master_controller
     output logic                          eot,
     input  logic                    [7:0] spi_clk_div,
     input  logic                          spi_clk_div_valid,
-    output logic                    [6:0] spi_status,
+    output logic                    [7:0] spi_status,       // one-hot state, IDLE .. WAIT_EDGE as bit 0 .. 7
     input  logic                   [31:0] spi_addr,
     input  logic                    [5:0] spi_addr_len,
     input  logic                   [31:0] spi_cmd,
@@ -29,6 +38,12 @@ module spi_master_controller
     input  logic                   [15:0] spi_dummy_rd,
     input  logic                   [15:0] spi_dummy_wr,
     input  logic                    [3:0] spi_csreg,
+    input  logic                    [1:0] spi_cmd_lanes,
+    input  logic                    [1:0] spi_addr_lanes,
+    input  logic                          spi_data_cont, // reads: reload spi_data_len on rx_done while set
+    input  logic                          spi_dtr,       // ADDR, MODE and data phases on both SPI clock edges
+    input  logic                    [7:0] spi_mode_bits, // reads: sent after the address (MODE), on its lanes
+    input  logic                          spi_mode_bits_en,
     // input  logic                          spi_swrst, //FIXME Not used at all
     input  logic                          spi_rd,
     input  logic                          spi_wr,
@@ -54,11 +69,28 @@ module spi_master_controller
     input  logic                          spi_sdi0,
     input  logic                          spi_sdi1,
     input  logic                          spi_sdi2,
-    input  logic                          spi_sdi3
+    input  logic                          spi_sdi3,
+    // for performance counters (spi_master_perf)
+    output logic                    [2:0] spi_state,        // IDLE .. WAIT_EDGE as 0 .. 7
+    output logic                          spi_data_tx_start, // data phase of spi_data_len bits starts
+    output logic                          spi_data_rx_start,
+    output logic                          spi_tx_stall,      // SPI clock held: no TX data
+    output logic                          spi_rx_stall       // SPI clock held: RX word not taken
 );
 
   logic spi_rise;
   logic spi_fall;
+  logic spi_mid;
+
+  // DTR: the flash samples on both edges, so TX beats change at spi_mid.
+  // The first edge of a DTR output phase comes after the phase was loaded
+  // (on a fall, or in IDLE), so only midpoints that follow an edge of the
+  // phase shift; RX samples on both edges.
+  logic dtr_tx;
+  logic dtr_rx;
+  logic dtr_edge_seen;
+  logic tx_edge;
+  logic rx_edge;
 
   logic spi_clock_en;
 
@@ -76,6 +108,12 @@ module spi_master_controller
 
   logic en_quad;
   logic en_quad_int;
+  logic cmd_quad;
+  logic addr_quad;
+  logic tx_quad;
+  logic cmd_dual;
+  logic addr_dual;
+  logic tx_dual;
   logic en_dual;
   logic en_dual_int;
   
@@ -94,13 +132,44 @@ module spi_master_controller
   logic tx_clk_en;
   logic rx_clk_en;
 
-  enum logic [2:0] {DATA_NULL,DATA_EMPTY,DATA_CMD,DATA_ADDR,DATA_FIFO} ctrl_data_mux;
+  enum logic [2:0] {DATA_NULL,DATA_EMPTY,DATA_CMD,DATA_ADDR,DATA_MODE,DATA_FIFO} ctrl_data_mux;
 
   enum logic [4:0] {IDLE,CMD,ADDR,MODE,DUMMY,DATA_TX,DATA_RX,WAIT_EDGE} state,state_next;
 
   assign en_quad = spi_qrd | spi_qwr | en_quad_int;
+
+  assign cmd_quad  = (spi_cmd_lanes  == `SPI_LANES_LEGACY) ? en_quad : (spi_cmd_lanes  == `SPI_LANES_4);
+  assign addr_quad = (spi_addr_lanes == `SPI_LANES_LEGACY) ? en_quad : (spi_addr_lanes == `SPI_LANES_4);
+  assign cmd_dual  = (spi_cmd_lanes  == `SPI_LANES_2);
+  assign addr_dual = (spi_addr_lanes == `SPI_LANES_2);
+
+  // TX shifter width follows the phase being shifted out; on a counter load
+  // it follows the phase being entered. DUMMY always runs on one lane, so
+  // spi_dummy_rd/spi_dummy_wr are in SPI clocks whatever the data width.
+  always_comb
+  begin
+    tx_dual = 1'b0;
+    case (counter_tx_valid ? state_next : state)
+      CMD:     begin tx_quad = cmd_quad;  tx_dual = cmd_dual;  end
+      ADDR:    begin tx_quad = addr_quad; tx_dual = addr_dual; end
+      MODE:    begin tx_quad = addr_quad; tx_dual = addr_dual; end
+      DATA_TX: tx_quad = en_quad;
+      default: tx_quad = 1'b0;
+    endcase
+  end
   assign en_dual = spi_drd | en_dual_int;
 
+  assign dtr_tx  = spi_dtr && (state == ADDR || state == MODE || state == DATA_TX);
+  assign dtr_rx  = spi_dtr && (state == DATA_RX);
+  assign tx_edge = dtr_tx ? (spi_mid && dtr_edge_seen) : spi_fall;
+  assign rx_edge = spi_rise || (dtr_rx && spi_fall);
+
+  assign spi_state         = state[2:0];
+  assign spi_data_tx_start = counter_tx_valid && (state_next == DATA_TX);
+  assign spi_data_rx_start = counter_rx_valid;
+  assign spi_tx_stall      = (state == DATA_TX) && !tx_clk_en;
+  assign spi_rx_stall      = (state == DATA_RX) && !rx_clk_en;
+
   spi_master_clkgen u_clkgen
   (
     .clk           ( clk               ),
@@ -108,9 +177,11 @@ module spi_master_controller
     .en            ( spi_clock_en      ),
     .clk_div       ( spi_clk_div       ),
     .clk_div_valid ( spi_clk_div_valid ),
+    .mid_en        ( dtr_tx            ),
     .spi_clk       ( spi_clk           ),
     .spi_fall      ( spi_fall          ),
-    .spi_rise      ( spi_rise          )
+    .spi_rise      ( spi_rise          ),
+    .spi_mid       ( spi_mid           )
   );
 
   spi_master_tx u_txreg
@@ -118,13 +189,14 @@ module spi_master_controller
     .clk            ( clk              ),
     .rstn           ( rstn             ),
     .en             ( spi_en_tx        ),
-    .tx_edge        ( spi_fall         ),
+    .tx_edge        ( tx_edge          ),
     .tx_done        ( tx_done          ),
     .sdo0           ( spi_sdo0         ),
     .sdo1           ( spi_sdo1         ),
     .sdo2           ( spi_sdo2         ),
     .sdo3           ( spi_sdo3         ),
-    .en_quad_in     ( en_quad          ),
+    .en_quad_in     ( tx_quad          ),
+    .en_dual_in     ( tx_dual          ),
     .counter_in     ( counter_tx       ),
     .counter_in_upd ( counter_tx_valid ),
     .data           ( data_to_tx       ),
@@ -138,7 +210,7 @@ module spi_master_controller
     .clk            ( clk                    ),
     .rstn           ( rstn                   ),
     .en             ( spi_en_rx              ),
-    .rx_edge        ( spi_rise               ),
+    .rx_edge        ( rx_edge                ),
     .rx_done        ( rx_done                ),
     .sdi0           ( spi_sdi0               ),
     .sdi1           ( spi_sdi1               ),
@@ -188,6 +260,13 @@ module spi_master_controller
               spi_ctrl_data_tx_ready = 1'b0;
           end
 
+          DATA_MODE:
+          begin
+              data_to_tx       = {spi_mode_bits, 24'h0};
+              data_to_tx_valid = ctrl_data_valid;
+              spi_ctrl_data_tx_ready = 1'b0;
+          end
+
           DATA_FIFO:
           begin
               data_to_tx       = spi_ctrl_data_tx;
@@ -220,14 +299,14 @@ module spi_master_controller
       begin
         spi_status[0] = 1'b1;
         s_spi_mode = `SPI_QUAD_RX;
-        if (spi_rd || spi_wr || spi_qrd || spi_qwr)
+        if (spi_rd || spi_wr || spi_qrd || spi_qwr || spi_drd)
         begin
           spi_cs       = 1'b0;
           spi_clock_en = 1'b1;
 
           if (spi_cmd_len != 0)
           begin
-            s_spi_mode = (spi_qrd | spi_qwr) ? `SPI_QUAD_TX : `SPI_STD;
+            s_spi_mode = (cmd_quad || cmd_dual) ? `SPI_QUAD_TX : `SPI_STD;
             counter_tx       = {10'h0,spi_cmd_len}; // spi_cmd_len is 6 bit, so fill 10 zeros
             counter_tx_valid = 1'b1;
             ctrl_data_mux    = DATA_CMD;
@@ -237,7 +316,7 @@ module spi_master_controller
           end
           else if (spi_addr_len != 0)
           begin
-            s_spi_mode = (spi_qrd | spi_qwr) ? `SPI_QUAD_TX : `SPI_STD;
+            s_spi_mode = (addr_quad || addr_dual) ? `SPI_QUAD_TX : `SPI_STD;
             counter_tx       = {10'h0,spi_addr_len};
             counter_tx_valid = 1'b1;
             ctrl_data_mux    = DATA_ADDR;
@@ -247,12 +326,14 @@ module spi_master_controller
           end
           else if (spi_data_len != 0)
           begin
-            if (spi_rd || spi_qrd)
+            if (spi_rd || spi_qrd || spi_drd)
             begin
-              s_spi_mode = (spi_qrd) ? `SPI_QUAD_RX : `SPI_STD;
+              s_spi_mode = (spi_qrd) ? `SPI_QUAD_RX
+                         : (spi_drd) ? `SPI_DUAL_RX
+                         :             `SPI_STD;
               if(spi_dummy_rd != 0)
               begin
-                counter_tx       = en_quad ? {spi_dummy_rd[13:0],2'b00} : spi_dummy_rd;
+                counter_tx       = spi_dummy_rd;
                 counter_tx_valid = 1'b1;
                 spi_en_tx        = 1'b1;
                 ctrl_data_mux    = DATA_EMPTY;
@@ -271,7 +352,7 @@ module spi_master_controller
               s_spi_mode = (spi_qwr) ? `SPI_QUAD_TX : `SPI_STD;
               if(spi_dummy_wr != 0)
               begin
-                counter_tx       = en_quad ? {spi_dummy_wr[13:0],2'b00} : spi_dummy_wr;
+                counter_tx       = spi_dummy_wr;
                 counter_tx_valid = 1'b1;
                 ctrl_data_mux    = DATA_EMPTY;
                 spi_en_tx        = 1'b1;
@@ -301,12 +382,12 @@ module spi_master_controller
         spi_status[1] = 1'b1;
         spi_cs = 1'b0;
         spi_clock_en = 1'b1;
-        s_spi_mode = (en_quad) ? `SPI_QUAD_TX : `SPI_STD;
+        s_spi_mode = (cmd_quad || cmd_dual) ? `SPI_QUAD_TX : `SPI_STD;
         if (tx_done)
         begin
           if (spi_addr_len != 0)
           begin
-            s_spi_mode = (en_quad) ? `SPI_QUAD_TX : `SPI_STD;
+            s_spi_mode = (addr_quad || addr_dual) ? `SPI_QUAD_TX : `SPI_STD;
             counter_tx       = {10'h0,spi_addr_len};
             counter_tx_valid = 1'b1;
             ctrl_data_mux    = DATA_ADDR;
@@ -323,7 +404,7 @@ module spi_master_controller
                              `SPI_STD;
               if(spi_dummy_rd != 0)
               begin
-                counter_tx       = en_quad ? {spi_dummy_rd[13:0],2'b00} : spi_dummy_rd;
+                counter_tx       = spi_dummy_rd;
                 counter_tx_valid = 1'b1;
                 spi_en_tx        = 1'b1;
                 ctrl_data_mux    = DATA_EMPTY;
@@ -345,7 +426,7 @@ module spi_master_controller
             
               if(spi_dummy_wr != 0)
               begin
-                counter_tx       = en_quad ? {spi_dummy_wr[13:0],2'b00} : spi_dummy_wr;
+                counter_tx       = spi_dummy_wr;
                 counter_tx_valid = 1'b1;
                 ctrl_data_mux    = DATA_EMPTY;
                 spi_en_tx        = 1'b1;
@@ -381,20 +462,29 @@ module spi_master_controller
         spi_status[2] = 1'b1;
         spi_cs        = 1'b0;
         spi_clock_en  = 1'b1;
-        s_spi_mode    = (en_quad) ? `SPI_QUAD_TX : `SPI_STD;
+        s_spi_mode    = (addr_quad || addr_dual) ? `SPI_QUAD_TX : `SPI_STD;
 
         if (tx_done)
         begin
           if (spi_data_len != 0)
           begin
-            if (do_rx)
+            if (do_rx && spi_mode_bits_en)
+            begin
+              // mode bits on the address lanes, then dummy and data from MODE
+              counter_tx       = 16'd8;
+              counter_tx_valid = 1'b1;
+              ctrl_data_mux    = DATA_MODE;
+              ctrl_data_valid  = 1'b1;
+              state_next       = MODE;
+            end
+            else if (do_rx)
             begin
               s_spi_mode = (en_quad) ? `SPI_QUAD_RX 
                         : (en_dual) ? `SPI_DUAL_RX 
                         :              `SPI_STD;
               if(spi_dummy_rd != 0)
               begin
-                counter_tx       = en_quad ? {spi_dummy_rd[13:0],2'b00} : spi_dummy_rd;
+                counter_tx       = spi_dummy_rd;
                 counter_tx_valid = 1'b1;
                 spi_en_tx        = 1'b1;
                 ctrl_data_mux    = DATA_EMPTY;
@@ -414,7 +504,7 @@ module spi_master_controller
               spi_en_tx  = 1'b1;
 
               if(spi_dummy_wr != 0) begin
-                counter_tx       = en_quad ? {spi_dummy_wr[13:0],2'b00} : spi_dummy_wr;
+                counter_tx       = spi_dummy_wr;
                 counter_tx_valid = 1'b1;
                 ctrl_data_mux    = DATA_EMPTY;
                 state_next       = DUMMY;
@@ -438,9 +528,31 @@ module spi_master_controller
       MODE:
       begin
         spi_status[3] = 1'b1;
-        spi_cs = 1'b0;
-        spi_clock_en = 1'b1;
-        spi_en_tx        = 1'b1;
+        spi_cs        = 1'b0;
+        spi_clock_en  = 1'b1;
+        spi_en_tx     = 1'b1;
+        s_spi_mode    = (addr_quad || addr_dual) ? `SPI_QUAD_TX : `SPI_STD;
+
+        if (tx_done)
+        begin
+          s_spi_mode = (en_quad) ? `SPI_QUAD_RX
+                    : (en_dual) ? `SPI_DUAL_RX
+                    :              `SPI_STD;
+          if (spi_dummy_rd != 0)
+          begin
+            counter_tx       = spi_dummy_rd;
+            counter_tx_valid = 1'b1;
+            ctrl_data_mux    = DATA_EMPTY;
+            state_next       = DUMMY;
+          end
+          else
+          begin
+            counter_rx       = spi_data_len;
+            counter_rx_valid = 1'b1;
+            spi_en_rx        = 1'b1;
+            state_next       = DATA_RX;
+          end
+        end
       end
 
       DUMMY:
@@ -515,7 +627,19 @@ module spi_master_controller
               :              `SPI_STD;
 
         if (rx_done) begin
-          state_next = WAIT_EDGE;
+          if (spi_data_cont) begin
+            // continuous read: next spi_data_len bits without leaving DATA_RX
+            counter_rx       = spi_data_len;
+            counter_rx_valid = 1'b1;
+            spi_en_rx        = 1'b1;
+            state_next       = DATA_RX;
+          end else if (spi_dtr) begin
+            // the last DTR beat is sampled on a fall, the clock is low now
+            eot        = 1'b1;
+            state_next = IDLE;
+          end else begin
+            state_next = WAIT_EDGE;
+          end
         end else begin
           spi_en_rx  = 1'b1;
           state_next = DATA_RX;
@@ -523,7 +647,7 @@ module spi_master_controller
       end
       WAIT_EDGE:
       begin
-        spi_status[6] = 1'b1;
+        spi_status[7] = 1'b1;
         spi_cs        = 1'b0;
         spi_clock_en  = 1'b0;
         s_spi_mode    = (en_quad) ? `SPI_QUAD_RX
@@ -548,6 +672,7 @@ module spi_master_controller
     if (rstn == 1'b0)
     begin
       state       <= IDLE;
+      dtr_edge_seen <= 1'b0;
       en_quad_int <= 1'b0;
       en_dual_int <= 1'b0;
       do_rx       <= 1'b0;
@@ -557,6 +682,11 @@ module spi_master_controller
     begin
       state <= state_next;
       spi_mode <= s_spi_mode;
+
+      if (state == IDLE || spi_mid)
+        dtr_edge_seen <= 1'b0;
+      else if (dtr_tx && (spi_rise || spi_fall))
+        dtr_edge_seen <= 1'b1;
       if (spi_qrd || spi_qwr)
         en_quad_int <= 1'b1;
       else if (state_next == IDLE)
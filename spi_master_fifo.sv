@@ -10,6 +10,14 @@
 
 `define log2(VALUE) ((VALUE) < ( 1 ) ? 0 : (VALUE) < ( 2 ) ? 1 : (VALUE) < ( 4 ) ? 2 : (VALUE) < ( 8 ) ? 3 : (VALUE) < ( 16 )  ? 4 : (VALUE) < ( 32 )  ? 5 : (VALUE) < ( 64 )  ? 6 : (VALUE) < ( 128 ) ? 7 : (VALUE) < ( 256 ) ? 8 : (VALUE) < ( 512 ) ? 9 : (VALUE) < ( 1024 ) ? 10 : (VALUE) < ( 2048 ) ? 11 : (VALUE) < ( 4096 ) ? 12 : (VALUE) < ( 8192 ) ? 13 : (VALUE) < ( 16384 ) ? 14 : (VALUE) < ( 32768 ) ? 15 : (VALUE) < ( 65536 ) ? 16 : (VALUE) < ( 131072 ) ? 17 : (VALUE) < ( 262144 ) ? 18 : (VALUE) < ( 524288 ) ? 19 : (VALUE) < ( 1048576 ) ? 20 : (VALUE) < ( 1048576 * 2 ) ? 21 : (VALUE) < ( 1048576 * 4 ) ? 22 : (VALUE) < ( 1048576 * 8 ) ? 23 : (VALUE) < ( 1048576 * 16 ) ? 24 : 25)
 
+`ifndef SYNTHESIS
+`include "spi_log.svh"
+
+`ifndef SPI_LOG_MAX_FIFO
+`define SPI_LOG_MAX_FIFO `SPI_LOG_MAX
+`endif
+`endif
+
 module spi_master_fifo
 #(
     parameter DATA_WIDTH = 32,
@@ -136,14 +144,20 @@ module spi_master_fifo
 
     assign ready_o = ~full;
 
-    // debug
+`ifndef SYNTHESIS
+    // Pushes and pops at trace level (+spi_log_fifo=5), any FIFO instance
+    `SPI_LOG_DECL("FIFO", `SPI_LOG_MAX_FIFO)
+
     always_ff @(posedge clk_i) begin
-    if (valid_i && !full)
-        $display("[RXFIFO] wrote 0x%08h elements=%0d ready_o=%b", 
-                  data_i, elements+1, ~full);
-    if (ready_i && valid_o)
-        $display("[RXFIFO] read  0x%08h elements=%0d", 
-                  data_o, elements-1);
+        if (valid_i && !full) begin
+            `SPI_LOG(`SPI_LOG_TRACE, ("%m wrote 0x%08h elements=%0d", data_i, elements + 1))
+            `SPI_LOG_REC(`SPI_EV_PUSH, data_i, elements + 1)
+        end
+        if (ready_i && valid_o) begin
+            `SPI_LOG(`SPI_LOG_TRACE, ("%m read  0x%08h elements=%0d", data_o, elements - 1))
+            `SPI_LOG_REC(`SPI_EV_POP, data_o, elements - 1)
+        end
     end
+`endif
 
 endmodule
@@ -0,0 +1,76 @@
+// Performance counters for axi_spi_master.
+//
+// Live 32-bit counters (wrapping) of system clocks, completed transactions
+// (eot), data bytes sent and received (spi_data_len / 8 per data phase,
+// counted when the phase starts), SPI clock stall cycles and cycles spent in
+// each controller state. Stalls are the cycles the controller holds the SPI
+// clock in DATA_TX because the TX shifter ran dry (TX FIFO underrun) or in
+// DATA_RX because the RX side cannot take the next word (RX FIFO full).
+//
+// Software reads a coherent set: snapshot_i copies every live counter into
+// the readable shadow registers in the same cycle, clear_i zeroes the live
+// counters (with both set the snapshot takes the values before the clear).
+// rdata_o is the shadow register at word index addr_i:
+//
+//   0 cycles       4 tx stall cycles
+//   1 transactions 5 rx stall cycles
+//   2 tx bytes     6, 7 reserved (0)
+//   3 rx bytes     8 + n cycles in controller state n (IDLE, CMD, ADDR, MODE,
+//                  DUMMY, DATA_TX, DATA_RX, WAIT_EDGE)
+
+module spi_master_perf (
+    input  logic        clk,
+    input  logic        rstn,
+
+    input  logic        snapshot_i,
+    input  logic        clear_i,
+
+    // from spi_master_controller
+    input  logic  [2:0] state_i,
+    input  logic        eot_i,
+    input  logic        tx_start_i,
+    input  logic        rx_start_i,
+    input  logic [15:0] data_len_i,      // bits of the data phase starting
+    input  logic        tx_stall_i,
+    input  logic        rx_stall_i,
+
+    input  logic  [3:0] addr_i,
+    output logic [31:0] rdata_o
+);
+
+    localparam NUM_CNT = 16;
+
+    logic [31:0] cnt    [NUM_CNT];
+    logic [31:0] shadow [NUM_CNT];
+    logic [31:0] cnt_inc[NUM_CNT];
+
+    always_comb begin
+        for (int i = 0; i < NUM_CNT; i++)
+            cnt_inc[i] = '0;
+        cnt_inc[0] = 32'd1;
+        cnt_inc[1] = {31'b0, eot_i};
+        cnt_inc[2] = tx_start_i ? {19'b0, data_len_i[15:3]} : 32'd0;
+        cnt_inc[3] = rx_start_i ? {19'b0, data_len_i[15:3]} : 32'd0;
+        cnt_inc[4] = {31'b0, tx_stall_i};
+        cnt_inc[5] = {31'b0, rx_stall_i};
+        cnt_inc[8 + int'(state_i)] = 32'd1;
+    end
+
+    always_ff @(posedge clk or negedge rstn) begin
+        if (!rstn) begin
+            for (int i = 0; i < NUM_CNT; i++) begin
+                cnt[i]    <= '0;
+                shadow[i] <= '0;
+            end
+        end else begin
+            for (int i = 0; i < NUM_CNT; i++) begin
+                if (snapshot_i)
+                    shadow[i] <= cnt[i];
+                cnt[i] <= clear_i ? '0 : cnt[i] + cnt_inc[i];
+            end
+        end
+    end
+
+    assign rdata_o = shadow[addr_i];
+
+endmodule
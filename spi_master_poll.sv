@@ -0,0 +1,105 @@
+// Status register auto-poll for spi_flash_wrapper.
+//
+// After start_i the engine issues a one-byte read of cmd_i (e.g. 0x05 Read
+// Status, 0x70 Read Flag Status), waits interval_i system clocks with chip
+// select high, and repeats until (value & mask_i) == match_i or max_i reads
+// have been issued (0: no limit). done_o pulses once with the eot of the last
+// read; timeout_o is set with it when the value never matched. count_o holds
+// the number of reads of the last poll for profiling.
+//
+// The status byte is taken from the controller's RX port while busy_o, it
+// never reaches the RX FIFO. With several devices each one has its own
+// engine (spi_master_sched): req_o asks for the controller and a read only
+// starts once grant_i is set, eot_i and the RX port are the engine's own.
+
+module spi_master_poll (
+    input  logic        clk,
+    input  logic        rstn,
+
+    input  logic [7:0]  cmd_i,
+    input  logic [7:0]  mask_i,
+    input  logic [7:0]  match_i,
+    input  logic [15:0] interval_i,      // system clocks between reads
+    input  logic [15:0] max_i,           // reads before giving up, 0 = no limit
+
+    input  logic        start_i,
+    output logic        busy_o,
+    output logic        done_o,
+    output logic        timeout_o,       // valid with done_o
+    output logic [15:0] count_o,
+    output logic [7:0]  value_o,         // last status byte read
+
+    // one-byte read request towards the controller, valid while busy_o
+    output logic        req_o,
+    input  logic        grant_i,
+    output logic        req_start_o,
+    input  logic        eot_i,
+
+    input  logic [31:0] rx_data_i,
+    input  logic        rx_valid_i,
+    output logic        rx_ready_o
+);
+
+    enum logic [1:0] { P_IDLE, P_ISSUE, P_WAIT, P_GAP } poll_CS;
+
+    logic [15:0] gap_cnt;
+    logic        hit;
+    logic        last_try;
+
+    // a partial RX word holds its byte in the low bits
+    assign hit      = ((value_o & mask_i) == (match_i & mask_i));
+    assign last_try = (max_i != 16'd0) && (count_o + 16'd1 >= max_i);
+
+    assign busy_o      = (poll_CS != P_IDLE);
+    assign req_o       = (poll_CS == P_ISSUE);
+    assign req_start_o = req_o && grant_i;
+    assign rx_ready_o  = (poll_CS == P_WAIT);
+    assign done_o      = (poll_CS == P_WAIT) && eot_i && (hit || last_try);
+    assign timeout_o   = done_o && !hit;
+
+    always_ff @(posedge clk or negedge rstn) begin
+        if (!rstn) begin
+            poll_CS <= P_IDLE;
+            gap_cnt <= '0;
+            count_o <= '0;
+            value_o <= '0;
+        end else begin
+            case (poll_CS)
+                P_IDLE:
+                    if (start_i) begin
+                        poll_CS <= P_ISSUE;
+                        count_o <= '0;
+                    end
+
+                P_ISSUE:
+                    if (grant_i)
+                        poll_CS <= P_WAIT;
+
+                P_WAIT: begin
+                    if (rx_valid_i)
+                        value_o <= rx_data_i[7:0];
+                    if (eot_i) begin
+                        count_o <= count_o + 16'd1;
+                        if (hit || last_try)
+                            poll_CS <= P_IDLE;
+                        else if (interval_i == 16'd0)
+                            poll_CS <= P_ISSUE;
+                        else begin
+                            poll_CS <= P_GAP;
+                            gap_cnt <= interval_i;
+                        end
+                    end
+                end
+
+                P_GAP: begin
+                    gap_cnt <= gap_cnt - 16'd1;
+                    if (gap_cnt == 16'd1)
+                        poll_CS <= P_ISSUE;
+                end
+
+                default: poll_CS <= P_IDLE;
+            endcase
+        end
+    end
+
+endmodule
@@ -90,13 +90,12 @@ module spi_master_rx
               data_int_next = {data_int[30:0], sdi0};
 
           if (rx_done) begin
-            $display("[RX] done data=0x%08h data_ready=%b", data_int_next, data_ready);
-            
             counter_next = 0;
             data_valid   = 1'b1;
 
+            // en still set on rx_done: the counter was reloaded, keep going
             if (data_ready)
-              rx_NS = IDLE;
+              rx_NS = (en) ? RECEIVE : IDLE;
             else
               rx_NS = WAIT_FIFO_DONE;
           end else if (reg_done) begin
@@ -114,7 +113,7 @@ module spi_master_rx
       WAIT_FIFO_DONE: begin
         data_valid = 1'b1;
         if (data_ready)
-          rx_NS = IDLE;
+          rx_NS = (en) ? RECEIVE : IDLE;
       end
 
       WAIT_FIFO: begin
@@ -0,0 +1,239 @@
+// Chip select scheduler for spi_flash_wrapper.
+//
+// Shares the one controller between the host's direct commands, the command
+// queue (spi_master_seq) and one status auto-poll engine (spi_master_poll)
+// per device. A device counts as busy (dev_busy_o) while its engine polls,
+// e.g. for WIP after a program or erase, and the queue does not issue to it
+// then. Whoever gets the controller keeps it from start_o to eot_i.
+//
+// Grants, when no transfer runs: polls first, round-robin over the devices,
+// then the queue, then the host. After a status read the next grant goes to
+// the queue or the host if either is waiting, so even with interval 0 every
+// other transfer is free for the devices that are not polled.
+//
+// host_start_i is a pulse; the request is kept until it is granted. The
+// host is served while the queue is idle (both use the FIFOs) and its own
+// device is not polled; polls of the other devices go on meanwhile.
+//
+// owner_o / cs_o tell the wrapper whose command fields to use; they are
+// valid with start_o and until eot_i.
+
+module spi_master_sched #(
+    parameter NUM_CS = 4                 // devices with a poll engine, 1..4
+) (
+    input  logic        clk,
+    input  logic        rstn,
+
+    // poll configuration, the same for every device
+    input  logic [7:0]  poll_cmd_i,
+    input  logic [7:0]  poll_mask_i,
+    input  logic [7:0]  poll_match_i,
+    input  logic [15:0] poll_interval_i,
+    input  logic [15:0] poll_max_i,
+
+    // host: one command or one poll of host_cs_i at a time; the command
+    // fields must hold until the command has been granted
+    input  logic        host_start_i,
+    input  logic        host_poll_i,
+    input  logic [1:0]  host_cs_i,
+
+    // command queue
+    input  logic        seq_busy_i,
+    input  logic        seq_req_i,
+    output logic        seq_grant_o,
+    input  logic [1:0]  seq_cs_i,
+    input  logic        seq_poll_i,      // poll seq_cs_i
+
+    // towards the controller
+    output logic        start_o,
+    output logic [1:0]  owner_o,         // OWN_HOST, OWN_SEQ, OWN_POLL
+    output logic [1:0]  cs_o,
+    input  logic        eot_i,
+    output logic        seq_eot_o,
+
+    input  logic [31:0] rx_data_i,
+    input  logic        rx_valid_i,
+    output logic        rx_ready_o,
+    output logic        poll_xfer_o,     // a poll owns the controller, RX data is its own
+
+    output logic [3:0]  dev_busy_o,
+    output logic        polls_busy_o,
+    output logic        poll_done_o,     // one cycle, per finished poll
+    output logic        poll_timeout_o,  // with poll_done_o
+    output logic [15:0] poll_count_o,    // of the last finished poll
+    output logic [7:0]  poll_value_o
+);
+
+    localparam logic [1:0] OWN_HOST = 2'd0;
+    localparam logic [1:0] OWN_SEQ  = 2'd1;
+    localparam logic [1:0] OWN_POLL = 2'd2;
+
+    logic        xfer_q;
+    logic [1:0]  owner_q;
+    logic [1:0]  cs_q;
+
+    logic        host_pend_q;       // host_start_i not granted yet
+    logic        host_ok;
+    logic        poll_last_q;       // the last grant was a status read
+    logic [1:0]  poll_rr_q;         // device of the last status read
+    logic [1:0]  poll_pick;
+
+    logic [3:0]  poll_own;
+    logic [3:0]  poll_req;
+    logic [3:0]  poll_grant;
+    logic [3:0]  poll_start;
+    logic [3:0]  poll_eot;
+    logic [3:0]  poll_rx_ready;
+    logic [3:0]  poll_done;
+    logic [3:0]  poll_timeout;
+    logic [15:0] poll_count [4];
+    logic [7:0]  poll_value [4];
+    logic [1:0]  last_poll;
+
+    // -------------------------------------------------------------------------
+    // One poll engine per device
+    // -------------------------------------------------------------------------
+    for (genvar d = 0; d < 4; d++) begin : g_poll
+        if (d < NUM_CS) begin : g_dev
+            spi_master_poll u_poll (
+                .clk        (clk),
+                .rstn       (rstn),
+
+                .cmd_i      (poll_cmd_i),
+                .mask_i     (poll_mask_i),
+                .match_i    (poll_match_i),
+                .interval_i (poll_interval_i),
+                .max_i      (poll_max_i),
+
+                .start_i    (poll_start[d]),
+                .busy_o     (dev_busy_o[d]),
+                .done_o     (poll_done[d]),
+                .timeout_o  (poll_timeout[d]),
+                .count_o    (poll_count[d]),
+                .value_o    (poll_value[d]),
+
+                .req_o      (poll_req[d]),
+                .grant_i    (poll_grant[d]),
+                /* verilator lint_off PINCONNECTEMPTY */
+                .req_start_o(),
+                /* verilator lint_on PINCONNECTEMPTY */
+                .eot_i      (poll_eot[d]),
+
+                .rx_data_i  (rx_data_i),
+                .rx_valid_i (rx_valid_i && poll_own[d]),
+                .rx_ready_o (poll_rx_ready[d])
+            );
+        end else begin : g_none
+            assign dev_busy_o[d]    = 1'b0;
+            assign poll_done[d]     = 1'b0;
+            assign poll_timeout[d]  = 1'b0;
+            assign poll_count[d]    = '0;
+            assign poll_value[d]    = '0;
+            assign poll_req[d]      = 1'b0;
+            assign poll_rx_ready[d] = 1'b0;
+        end
+    end
+
+    // the host polls only while the queue is idle
+    always_comb begin
+        for (int d = 0; d < 4; d++)
+            poll_start[d] = seq_busy_i ? (seq_poll_i && seq_cs_i == 2'(d))
+                                       : (host_poll_i && host_cs_i == 2'(d));
+    end
+
+    // -------------------------------------------------------------------------
+    // Arbiter
+    // -------------------------------------------------------------------------
+    assign host_ok = (host_start_i || host_pend_q) && !seq_busy_i && !dev_busy_o[host_cs_i];
+
+    // first requesting device after the last one read
+    always_comb begin
+        poll_pick = poll_rr_q;
+        for (int i = 4; i >= 1; i--)
+            if (poll_req[2'(poll_rr_q + 2'(i))]) poll_pick = 2'(poll_rr_q + 2'(i));
+    end
+
+    always_comb begin
+        start_o     = 1'b0;
+        owner_o     = owner_q;
+        cs_o        = cs_q;
+        poll_grant  = '0;
+        seq_grant_o = 1'b0;
+
+        if (!xfer_q) begin
+            owner_o = OWN_HOST;
+            cs_o    = host_cs_i;
+            if (|poll_req && !(poll_last_q && (seq_req_i || host_ok))) begin
+                owner_o          = OWN_POLL;
+                cs_o             = poll_pick;
+                poll_grant[cs_o] = 1'b1;
+                start_o          = 1'b1;
+            end else if (seq_req_i) begin
+                owner_o     = OWN_SEQ;
+                cs_o        = seq_cs_i;
+                seq_grant_o = 1'b1;
+                start_o     = 1'b1;
+            end else if (host_ok) begin
+                start_o     = 1'b1;
+            end
+        end
+    end
+
+    always_ff @(posedge clk or negedge rstn) begin
+        if (!rstn) begin
+            xfer_q      <= 1'b0;
+            owner_q     <= OWN_HOST;
+            cs_q        <= 2'd0;
+            host_pend_q <= 1'b0;
+            poll_last_q <= 1'b0;
+            poll_rr_q   <= 2'd0;
+        end else begin
+            if (start_o) begin
+                xfer_q      <= 1'b1;
+                owner_q     <= owner_o;
+                cs_q        <= cs_o;
+                poll_last_q <= (owner_o == OWN_POLL);
+                if (owner_o == OWN_POLL)
+                    poll_rr_q <= cs_o;
+            end else if (eot_i) begin
+                xfer_q      <= 1'b0;
+            end
+
+            if (start_o && owner_o == OWN_HOST)
+                host_pend_q <= 1'b0;
+            else if (host_start_i)
+                host_pend_q <= 1'b1;
+        end
+    end
+
+    assign poll_xfer_o = xfer_q && owner_q == OWN_POLL;
+
+    always_comb begin
+        for (int d = 0; d < 4; d++) begin
+            poll_own[d] = poll_xfer_o && cs_q == 2'(d);
+            poll_eot[d] = eot_i && poll_own[d];
+        end
+    end
+
+    assign seq_eot_o  = eot_i && xfer_q && owner_q == OWN_SEQ;
+    assign rx_ready_o = |(poll_rx_ready & poll_own);
+
+    // -------------------------------------------------------------------------
+    // Poll status
+    // -------------------------------------------------------------------------
+    assign polls_busy_o   = |dev_busy_o;
+    assign poll_done_o    = |poll_done;
+    assign poll_timeout_o = |poll_timeout;
+
+    always_ff @(posedge clk or negedge rstn) begin
+        if (!rstn)
+            last_poll <= 2'd0;
+        else
+            for (int d = 0; d < 4; d++)
+                if (poll_done[d]) last_poll <= 2'(d);
+    end
+
+    assign poll_count_o = poll_count[last_poll];
+    assign poll_value_o = poll_value[last_poll];
+
+endmodule
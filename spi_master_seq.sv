@@ -0,0 +1,193 @@
+// Command sequencer for spi_flash_wrapper.
+//
+// Software pushes 64-bit command descriptors into a queue and pulses
+// start_i; the sequencer then issues them to the controller one after the
+// other, starting the next command the cycle after the previous one's eot,
+// so chip select is only high for a couple of system clocks in between.
+// done_o pulses with the eot of the last command, the first one with
+// DESC_LAST set. A queue that runs empty before it is an underrun: the
+// sequencer waits for the next descriptor (busy_o stays high), and flush_i
+// ends the chain there. Data words of the commands go through the wrapper's
+// TX and RX FIFOs in order.
+//
+// Every descriptor is queued with the chip select of its device (desc_cs_i,
+// beside the 64 bits). A command with DESC_POLL set starts a status auto-poll
+// of its device (spi_master_sched), e.g. to wait for WIP after a page
+// program, and the device counts as busy until the poll has matched. The
+// sequencer goes on with the next descriptor meanwhile, unless that one is
+// for a busy device: commands stay in order, but a program or erase on one
+// device overlaps the commands for the others. done_o waits for the last
+// poll. abort_i (a poll timeout, or a descriptor the wrapper cannot issue)
+// or flush_i ends the chain; the remaining descriptors stay queued until a
+// flush_i while idle. start_i with an empty queue is an empty chain: done_o
+// pulses in the same cycle and busy_o stays low.
+//
+// Descriptor layout (same fields as the wrapper's direct inputs):
+//   [7:0]   command        [31:8]  addr
+//   [44:32] data_count     [46:45] data_mode     [48:47] addr_mode
+//   [49]    rd_wr          [50]    has_addr      [55:51] dummy_cycle
+//   [56]    DESC_LAST      [57]    DESC_POLL     [58]    dtr
+//   [59]    addr_4b        [63:60] addr[27:24]
+//
+// A queued command reaches the first 256 MB with a 4-byte address.
+
+module spi_master_seq #(
+    parameter DESC_DEPTH = 8
+) (
+    input  logic        clk,
+    input  logic        rstn,
+
+    input  logic [63:0] desc_i,
+    input  logic [1:0]  desc_cs_i,
+    input  logic        desc_valid_i,
+    output logic        desc_ready_o,
+    input  logic        flush_i,         // drop all queued descriptors; ends a running chain
+
+    input  logic        start_i,         // pulse: run the queue
+    output logic        busy_o,          // high from start_i until done_o
+    output logic        done_o,          // one cycle, with the last eot (empty queue: with start_i)
+
+    // current command towards the controller, valid while busy_o; it
+    // starts when the scheduler grants req_o
+    output logic        req_o,
+    input  logic        grant_i,
+    output logic        req_start_o,
+    output logic [1:0]  req_cs_o,
+    output logic [7:0]  req_command_o,
+    output logic [31:0] req_addr_o,
+    output logic        req_addr_4b_o,
+    output logic [12:0] req_data_count_o,
+    output logic [1:0]  req_data_mode_o,
+    output logic [1:0]  req_addr_mode_o,
+    output logic        req_rd_wr_o,
+    output logic        req_has_addr_o,
+    output logic [4:0]  req_dummy_cycle_o,
+    output logic        req_dtr_o,
+
+    // status auto-poll of req_cs_o after DESC_POLL commands
+    output logic        poll_start_o,
+    input  logic        dev_busy_i,      // req_cs_o is being polled
+    input  logic        polls_busy_i,    // any device is being polled
+    input  logic        abort_i,         // a poll ended without a match, or the head
+                                         // descriptor cannot be issued
+
+    input  logic        eot_i
+);
+
+    localparam LOG_DEPTH = $clog2(DESC_DEPTH + 1);   // `log2 of spi_master_fifo
+
+    logic [63:0]        desc;
+    logic [1:0]         desc_cs;
+    logic               desc_valid;
+    logic               desc_pop;
+
+    // -------------------------------------------------------------------------
+    // Descriptor queue
+    // -------------------------------------------------------------------------
+    spi_master_fifo #(
+        .DATA_WIDTH  (66),
+        .BUFFER_DEPTH(DESC_DEPTH)
+    ) u_descfifo (
+        .clk_i  (clk),
+        .rst_ni (rstn),
+        .clr_i  (flush_i && !busy_o),
+
+        /* verilator lint_off PINCONNECTEMPTY */
+        .elements_o(),
+        /* verilator lint_on PINCONNECTEMPTY */
+
+        .data_o ({desc_cs, desc}),
+        .valid_o(desc_valid),
+        .ready_i(desc_pop),
+
+        .valid_i(desc_valid_i),
+        .data_i ({desc_cs_i, desc_i}),
+        .ready_o(desc_ready_o)
+    );
+
+    assign req_command_o     = desc[7:0];
+    assign req_addr_o        = {4'b0, desc[63:60], desc[31:8]};
+    assign req_addr_4b_o     = desc[59];
+    assign req_data_count_o  = desc[44:32];
+    assign req_data_mode_o   = desc[46:45];
+    assign req_addr_mode_o   = desc[48:47];
+    assign req_rd_wr_o       = desc[49];
+    assign req_has_addr_o    = desc[50];
+    assign req_dummy_cycle_o = desc[55:51];
+    assign req_dtr_o         = desc[58];
+    assign req_cs_o          = desc_cs;
+
+    // -------------------------------------------------------------------------
+    // Issue FSM: the head descriptor stays in the queue until its eot
+    // -------------------------------------------------------------------------
+    enum logic [1:0] { S_IDLE, S_ISSUE, S_WAIT, S_DRAIN } seq_CS, seq_NS;
+
+    logic last;
+    logic abort_q;      // abort_i or flush_i: issue nothing more
+    assign last = desc[56];
+
+    always_comb begin
+        seq_NS       = seq_CS;
+        req_o        = 1'b0;
+        desc_pop     = 1'b0;
+        done_o       = 1'b0;
+        poll_start_o = 1'b0;
+
+        case (seq_CS)
+            S_IDLE:
+                if (start_i && desc_valid)
+                    seq_NS = S_ISSUE;
+                else if (start_i)
+                    done_o = 1'b1;
+
+            S_ISSUE:
+                if (abort_q) begin
+                    seq_NS = S_DRAIN;
+                end else if (desc_valid && !dev_busy_i) begin
+                    req_o = 1'b1;
+                    if (grant_i)
+                        seq_NS = S_WAIT;
+                end
+
+            S_WAIT:
+                if (eot_i) begin
+                    desc_pop     = 1'b1;
+                    poll_start_o = desc[57];
+                    if (!last)
+                        seq_NS = S_ISSUE;
+                    else if (!desc[57] && !polls_busy_i) begin
+                        done_o = 1'b1;
+                        seq_NS = S_IDLE;
+                    end else
+                        seq_NS = S_DRAIN;
+                end
+
+            // a poll started with the last eot is busy from the next cycle
+            S_DRAIN:
+                if (!polls_busy_i) begin
+                    done_o = 1'b1;
+                    seq_NS = S_IDLE;
+                end
+
+            default: seq_NS = S_IDLE;
+        endcase
+    end
+
+    assign req_start_o = req_o && grant_i;
+
+    always_ff @(posedge clk or negedge rstn) begin
+        if (!rstn) begin
+            seq_CS  <= S_IDLE;
+            abort_q <= 1'b0;
+        end else begin
+            seq_CS <= seq_NS;
+            if (seq_CS == S_IDLE)
+                abort_q <= 1'b0;
+            else if (abort_i || flush_i)
+                abort_q <= 1'b1;
+        end
+    end
+
+    assign busy_o = (seq_CS != S_IDLE);
+
+endmodule
@@ -20,6 +20,7 @@ module spi_master_tx
     output logic        sdo2,
     output logic        sdo3,
     input  logic        en_quad_in,
+    input  logic        en_dual_in,
     input  logic [15:0] counter_in,
     input  logic        counter_in_upd,
     input  logic [31:0] data,
@@ -39,19 +40,24 @@ module spi_master_tx
 
   enum logic [0:0] { IDLE, TRANSMIT } tx_CS, tx_NS;
 
-  assign sdo0 = (en_quad_in) ? data_int[28] : data_int[31];
-  assign sdo1 = data_int[29];
-  assign sdo2 = data_int[30];
-  assign sdo3 = data_int[31];
+  // dual: IO1 carries the odd bits, IO2/IO3 (WP#/HOLD#) are held high
+  assign sdo0 = (en_quad_in) ? data_int[28] : (en_dual_in) ? data_int[30] : data_int[31];
+  assign sdo1 = (en_dual_in && !en_quad_in) ? data_int[31] : data_int[29];
+  assign sdo2 = (en_dual_in && !en_quad_in) ? 1'b1         : data_int[30];
+  assign sdo3 = (en_dual_in && !en_quad_in) ? 1'b1         : data_int[31];
 
   assign tx_done = done;
 
-  assign reg_done  = (!en_quad_in && (counter[4:0] == 5'b11111)) || (en_quad_in && (counter[2:0] == 3'b111));
+  assign reg_done  = (en_quad_in                && (counter[2:0] == 3'b111  ))
+                  || (!en_quad_in && en_dual_in  && (counter[3:0] == 4'b1111 ))
+                  || (!en_quad_in && !en_dual_in && (counter[4:0] == 5'b11111));
 
   always_comb
   begin
     if (counter_in_upd)
-      counter_trgt_next = (en_quad_in) ? {2'b00,counter_in[15:2]} : counter_in;
+      counter_trgt_next = (en_quad_in) ? {2'b00,counter_in[15:2]}
+                        : (en_dual_in) ? {1'b0, counter_in[15:1]}
+                        :                counter_in;
     else
       counter_trgt_next = counter_trgt;
   end
@@ -82,7 +88,9 @@ module spi_master_tx
 
         if (tx_edge) begin
           counter_next = counter + 1;
-          data_int_next = (en_quad_in) ? {data_int[27:0],4'b0000} : {data_int[30:0],1'b0};
+          data_int_next = (en_quad_in) ? {data_int[27:0],4'b0000}
+                        : (en_dual_in) ? {data_int[29:0],2'b00}
+                        :                {data_int[30:0],1'b0};
 
           if (tx_done) begin
             counter_next = 0;
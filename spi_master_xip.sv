@@ -0,0 +1,265 @@
+// Execute-in-place read window for axi_spi_master.
+//
+// AXI reads routed here are served from two line buffers of LINE_WORDS
+// 32-bit words. A miss fetches the whole line with one flash read command
+// (cfg_cmd_i, e.g. 0x0B / 0x6B / 0xEB) driven straight into the controller,
+// bypassing the RX FIFO; words are served as soon as they arrive. With
+// cfg_prefetch_i set, every hit in line N starts a fetch of line N+1 into the
+// other buffer, so sequential reads stream without waiting on the command,
+// address and dummy phases.
+//
+// The window is little-endian byte addressed: flash byte A shows up in
+// rdata[8*(A%4) +: 8]. Lines are not kept coherent with the register
+// interface; writing REG_XIPCFG (cfg_inval_i) drops both lines.
+
+module spi_master_xip
+#(
+    parameter AXI4_RDATA_WIDTH = 32,
+    parameter AXI4_USER_WIDTH  = 4,
+    parameter AXI4_ID_WIDTH    = 16,
+    parameter XIP_ADDR_WIDTH   = 24,    // flash bytes in the window, at most 24
+    parameter LINE_WORDS       = 8
+)
+(
+    input  logic                          clk,
+    input  logic                          rstn,
+
+    // configuration from REG_XIPCFG
+    input  logic                    [7:0] cfg_cmd_i,
+    input  logic                    [7:0] cfg_dummy_i,
+    input  logic                          cfg_quad_i,       // data on 4 lanes (spi_qrd)
+    input  logic                          cfg_quad_addr_i,  // address on 4 lanes
+    input  logic                          cfg_prefetch_i,
+    input  logic                          cfg_inval_i,
+
+    // AXI read channels, already decoded to the window
+    input  logic                          arvalid_i,
+    input  logic      [AXI4_ID_WIDTH-1:0] arid_i,
+    input  logic                    [7:0] arlen_i,
+    input  logic     [XIP_ADDR_WIDTH-1:0] araddr_i,
+    input  logic    [AXI4_USER_WIDTH-1:0] aruser_i,
+    output logic                          arready_o,
+
+    output logic                          rvalid_o,
+    output logic      [AXI4_ID_WIDTH-1:0] rid_o,
+    output logic   [AXI4_RDATA_WIDTH-1:0] rdata_o,
+    output logic                    [1:0] rresp_o,
+    output logic                          rlast_o,
+    output logic    [AXI4_USER_WIDTH-1:0] ruser_o,
+    input  logic                          rready_i,
+
+    // controller request, valid while busy_o; a fetch only starts while the
+    // controller is idle and no register command starts in the same cycle,
+    // so a register command is never cut short or mixed into a line
+    input  logic                          spi_idle_i,
+    input  logic                          host_req_i,
+    output logic                          busy_o,
+    output logic                          spi_rd_o,
+    output logic                          spi_qrd_o,
+    output logic                   [31:0] spi_cmd_o,
+    output logic                   [31:0] spi_addr_o,
+    output logic                    [1:0] spi_addr_lanes_o,
+    output logic                   [15:0] spi_data_len_o,
+    output logic                   [15:0] spi_dummy_rd_o,
+    input  logic                          eot_i,
+
+    input  logic                   [31:0] rx_data_i,
+    input  logic                          rx_valid_i,
+    output logic                          rx_ready_o
+);
+
+  localparam LOG_LINE   = $clog2(LINE_WORDS);
+  localparam WADDR_BITS = XIP_ADDR_WIDTH - 2;           // word address
+  localparam TAG_BITS   = WADDR_BITS - LOG_LINE;        // line address
+
+  logic [31:0]         line_buf [2][LINE_WORDS];
+  logic [TAG_BITS-1:0] tag      [2];
+  logic          [1:0] valid;
+  logic                mru;
+
+  // ---------------------------------------------------------------------------
+  // Fetch engine
+  // ---------------------------------------------------------------------------
+  enum logic [1:0] { F_IDLE, F_START, F_BUSY } F_CS;
+
+  logic                fill_slot;
+  logic                fill_drop;   // invalidated while filling
+  logic   [LOG_LINE:0] fill_cnt;
+  logic [TAG_BITS-1:0] fill_tag;
+
+  logic                fetch_req;
+  logic                fetch_slot;
+  logic [TAG_BITS-1:0] fetch_tag;
+
+  assign busy_o           = (F_CS != F_IDLE);
+  assign spi_rd_o         = (F_CS == F_START) && !cfg_quad_i;
+  assign spi_qrd_o        = (F_CS == F_START) &&  cfg_quad_i;
+  assign spi_cmd_o        = {cfg_cmd_i, 24'h0};
+  assign spi_addr_o       = 32'(fill_tag) << (LOG_LINE + 2 + 8);    // 24-bit address in [31:8]
+  assign spi_addr_lanes_o = cfg_quad_addr_i ? 2'b11 : 2'b01;
+  assign spi_data_len_o   = 16'(LINE_WORDS * 32);
+  assign spi_dummy_rd_o   = {8'h0, cfg_dummy_i};
+  assign rx_ready_o       = (F_CS == F_BUSY);
+
+  always_ff @(posedge clk, negedge rstn)
+  begin
+    if (rstn == 1'b0)
+    begin
+      F_CS      <= F_IDLE;
+      fill_slot <= 1'b0;
+      fill_drop <= 1'b0;
+      fill_cnt  <= '0;
+      fill_tag  <= '0;
+      valid     <= '0;
+      tag[0]    <= '0;
+      tag[1]    <= '0;
+    end
+    else
+    begin
+      if (cfg_inval_i)
+        valid <= '0;
+
+      case (F_CS)
+        F_IDLE:
+          if (fetch_req && spi_idle_i && !host_req_i)
+          begin
+            F_CS              <= F_START;
+            fill_slot         <= fetch_slot;
+            fill_tag          <= fetch_tag;
+            fill_cnt          <= '0;
+            fill_drop         <= 1'b0;
+            tag[fetch_slot]   <= fetch_tag;
+            valid[fetch_slot] <= 1'b0;
+          end
+
+        F_START:
+          F_CS <= F_BUSY;
+
+        F_BUSY:
+        begin
+          if (cfg_inval_i)
+            fill_drop <= 1'b1;
+          if (rx_valid_i)
+          begin
+            // RX words carry the first flash byte in [31:24]
+            line_buf[fill_slot][fill_cnt[LOG_LINE-1:0]] <= {rx_data_i[7:0], rx_data_i[15:8],
+                                                            rx_data_i[23:16], rx_data_i[31:24]};
+            fill_cnt <= fill_cnt + 1'b1;
+          end
+          if (eot_i)
+          begin
+            F_CS             <= F_IDLE;
+            valid[fill_slot] <= !(cfg_inval_i || fill_drop);
+          end
+        end
+
+        default:
+          F_CS <= F_IDLE;
+      endcase
+    end
+  end
+
+  // ---------------------------------------------------------------------------
+  // AXI read side
+  // ---------------------------------------------------------------------------
+  enum logic [0:0] { R_IDLE, R_DATA } R_CS;
+
+  logic   [WADDR_BITS-1:0] waddr_q;
+  logic              [7:0] len_q;
+  logic [AXI4_ID_WIDTH-1:0]   id_q;
+  logic [AXI4_USER_WIDTH-1:0] user_q;
+
+  logic [TAG_BITS-1:0] cur_tag;
+  logic [LOG_LINE-1:0] cur_off;
+  logic          [1:0] word_ok;     // word available in slot
+  logic          [1:0] line_here;   // line held or being filled in slot
+  logic                hit;
+  logic                hit_slot;
+  logic [TAG_BITS-1:0] next_tag;
+  logic                next_here;
+
+  assign cur_tag  = waddr_q[WADDR_BITS-1:LOG_LINE];
+  assign cur_off  = waddr_q[LOG_LINE-1:0];
+  assign next_tag = cur_tag + 1'b1;
+
+  always_comb
+  begin
+    for (int s = 0; s < 2; s++)
+    begin
+      line_here[s] = (tag[s] == cur_tag) && (valid[s] || (busy_o && fill_slot == s));
+      word_ok[s]   = (tag[s] == cur_tag) && (valid[s] ||
+                     (busy_o && fill_slot == s && {1'b0, cur_off} < fill_cnt));
+    end
+    next_here = ((tag[0] == next_tag) && (valid[0] || (busy_o && fill_slot == 1'b0)))
+             || ((tag[1] == next_tag) && (valid[1] || (busy_o && fill_slot == 1'b1)));
+  end
+
+  assign hit      = (R_CS == R_DATA) && (word_ok != 2'b00);
+  assign hit_slot = word_ok[1];
+
+  // demand miss first, otherwise prefetch the line after the one being read
+  always_comb
+  begin
+    fetch_req  = 1'b0;
+    fetch_slot = ~mru;
+    fetch_tag  = cur_tag;
+    if ((R_CS == R_DATA) && (line_here == 2'b00))
+    begin
+      fetch_req  = 1'b1;
+      fetch_slot = ~mru;
+      fetch_tag  = cur_tag;
+    end
+    else if (hit && cfg_prefetch_i && !next_here && (next_tag != '0))
+    begin
+      fetch_req  = 1'b1;
+      fetch_slot = ~hit_slot;
+      fetch_tag  = next_tag;
+    end
+  end
+
+  assign arready_o = (R_CS == R_IDLE);
+  assign rvalid_o  = hit;
+  assign rid_o     = id_q;
+  assign ruser_o   = user_q;
+  assign rresp_o   = 2'b00;
+  assign rlast_o   = (len_q == 8'h0);
+  assign rdata_o   = AXI4_RDATA_WIDTH'(line_buf[hit_slot][cur_off]);
+
+  always_ff @(posedge clk, negedge rstn)
+  begin
+    if (rstn == 1'b0)
+    begin
+      R_CS    <= R_IDLE;
+      waddr_q <= '0;
+      len_q   <= '0;
+      id_q    <= '0;
+      user_q  <= '0;
+      mru     <= 1'b0;
+    end
+    else
+    begin
+      case (R_CS)
+        R_IDLE:
+          if (arvalid_i)
+          begin
+            R_CS    <= R_DATA;
+            waddr_q <= araddr_i[XIP_ADDR_WIDTH-1:2];
+            len_q   <= arlen_i;
+            id_q    <= arid_i;
+            user_q  <= aruser_i;
+          end
+
+        R_DATA:
+          if (hit && rready_i)
+          begin
+            mru     <= hit_slot;
+            waddr_q <= waddr_q + 1'b1;   // INCR bursts only
+            len_q   <= len_q - 1'b1;
+            if (len_q == 8'h0)
+              R_CS <= R_IDLE;
+          end
+      endcase
+    end
+  end
+
+endmodule
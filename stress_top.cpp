@@ -0,0 +1,273 @@
+// Constrained-random stress test for spi_flash_top.
+//
+// Issues a seeded random mix of reads (0x03, 0x0B, 0x6B), page programs
+// (0x02, 0x32, single transactions that may wrap inside their page), sector
+// erases and WREN/WRDI through FlashDriver, mirrors every command into a
+// FlashRef and compares every read against it. At the end the whole region
+// is also compared against the model's page store.
+//
+//   +seed=<n>          random seed (default 1)
+//   +ops=<n>           operations to run (default 100000)
+//   +region=<bytes>    address range used, from 0 (default: 256 KB, so
+//                      programs and erases keep landing on the same pages)
+//   +log_from=<n>      print every operation from number n on
+//   +prescaler=<n>     prescaler_i (default 0)
+//
+// The first mismatch stops the run and prints the operation, the first
+// differing byte and the plusargs to replay it: the same seed gives the same
+// operations, so +ops=<n+1> +log_from=<n-k> reproduces it with a log of the
+// k operations before (add +trace for a waveform).
+#include "Vspi_flash_top.h"
+#include "verilated.h"
+#include "tb_trace.h"
+#include "flash_driver.h"
+#include "flash_mem.h"
+#include "flash_ref.h"
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+vluint64_t sim_time = 0;
+
+enum StressOp { S_READ, S_FAST_READ, S_QUAD_READ, S_PROGRAM, S_QUAD_PROGRAM,
+                S_ERASE, S_WREN, S_WRDI, NUM_OPS };
+
+const char* const op_names[NUM_OPS] = {
+    "read", "fast_read", "quad_read", "program", "quad_program",
+    "sector_erase", "wren", "wrdi"
+};
+
+// Relative weights of the operations
+const int op_weights[NUM_OPS] = {20, 25, 10, 22, 8, 1, 7, 2};
+
+struct StressStats {
+    uint64_t ops[NUM_OPS] = {};
+    uint64_t transactions = 0;
+    uint64_t bytes        = 0;
+};
+
+// Value of +name=<value>, or def when absent
+std::string plusarg(const char* name, const std::string& def) {
+    std::string key = std::string(name) + "=";
+    const char* arg = Verilated::commandArgsPlusMatch(key.c_str());
+    if (!arg[0]) return def;
+    return std::string(arg + 1 + key.size());
+}
+
+// Length of a read or program: mostly short, sometimes up to max
+size_t rand_len(std::mt19937_64& rng, size_t max) {
+    size_t cap = (rng() % 8 == 0) ? max : 32;
+    return 1 + rng() % cap;
+}
+
+int main(int argc, char **argv) {
+    Verilated::commandArgs(argc, argv);
+
+    TbTrace* tfp = new TbTrace;
+    tfp->init();
+
+    Vspi_flash_top *dut = new Vspi_flash_top;
+    tfp->open(dut, "stress");
+
+    uint64_t seed     = std::strtoull(plusarg("seed", "1").c_str(), nullptr, 0);
+    uint64_t num_ops  = std::strtoull(plusarg("ops", "100000").c_str(), nullptr, 0);
+    uint64_t log_from = std::strtoull(plusarg("log_from", "-1").c_str(), nullptr, 0);
+
+    FlashDriver drv(dut, tfp, sim_time);
+    drv.prescaler = std::atoi(plusarg("prescaler", "0").c_str());
+
+    // Reset, all inputs idle
+    dut->rstn            = 0;
+    dut->command_i       = 0;
+    dut->data_mode_i     = 0;
+    dut->addr_mode_i     = 0;
+    dut->rd_wr_i         = 0;
+    dut->dummy_cycle_i   = 0;
+    dut->data_count_i    = 0;
+    dut->continuous_i    = 0;
+    dut->stop_i          = 0;
+    dut->has_addr_i      = 0;
+    dut->clr_status_i    = 0;
+    dut->start_i         = 0;
+    dut->addr_i          = 0;
+    dut->data_tx_i       = 0;
+    dut->data_tx_valid_i = 0;
+    dut->data_rx_ready_i = 0;
+    dut->flush_tx_i      = 0;
+    dut->flush_rx_i      = 0;
+    dut->tx_ae_thresh_i  = 0;
+    dut->rx_af_thresh_i  = 0;
+    dut->irq_en_i        = 0;
+    dut->desc_i          = 0;
+    dut->desc_valid_i    = 0;
+    dut->seq_start_i     = 0;
+    dut->poll_start_i    = 0;
+    dut->poll_cmd_i      = 0;
+    dut->poll_mask_i     = 0;
+    dut->poll_match_i    = 0;
+    dut->poll_interval_i = 0;
+    dut->poll_max_i      = 0;
+    dut->dtr_i           = 0;
+    dut->addr_4b_i       = 0;
+    dut->mode_en_i       = 0;
+    dut->mode_bits_i     = 0;
+    dut->no_cmd_i        = 0;
+    dut->cs_i            = 0;
+    dut->desc_cs_i       = 0;
+    drv.tick(10);
+    dut->rstn = 1;
+    drv.tick(10);
+
+    FlashMem* mem = FlashMem::find();
+    uint32_t region = std::strtoul(plusarg("region", "0x40000").c_str(), nullptr, 0);
+    if (region == 0 || region > mem->size()) region = mem->size();
+    if (region > (1u << 24)) region = 1u << 24;     // 3-byte addresses
+
+    FlashRef ref(mem->size());
+    std::mt19937_64 rng(seed);
+    std::discrete_distribution<int> pick(op_weights, op_weights + NUM_OPS);
+    StressStats st;
+
+    std::cout << "stress: seed=" << seed << " ops=" << num_ops << " region=0x"
+              << std::hex << region << std::dec << " prescaler=" << drv.prescaler << "\n";
+
+    auto wall_start = std::chrono::steady_clock::now();
+    std::vector<uint8_t> buf(FlashRef::PAGE_SIZE * 2), got, exp;
+    bool failed = false;
+    uint64_t n = 0;
+
+    for (; n < num_ops && !failed; n++) {
+        int      op   = pick(rng);
+        uint32_t addr = uint32_t(rng() % region);
+        size_t   len  = 0;
+        bool     wren = false;
+        st.ops[op]++;
+
+        FlashCmd c;
+        c.has_addr = true;
+        c.addr     = addr;
+        switch (op) {
+            case S_READ:
+            case S_FAST_READ:
+            case S_QUAD_READ:
+                len = rand_len(rng, 512);
+                c.opcode    = op == S_READ ? OP_READ : op == S_FAST_READ ? OP_FAST_READ
+                                                                          : OP_QUAD_READ;
+                c.data_mode = op == S_QUAD_READ ? MODE_QUAD : MODE_STD;
+                c.read      = true;
+                c.dummy     = op == S_READ ? 0 : FlashDriver::FAST_DUMMY;
+                break;
+            case S_PROGRAM:
+            case S_QUAD_PROGRAM:
+                // one transaction, may run past the page end and wrap
+                len = rand_len(rng, FlashRef::PAGE_SIZE);
+                wren = rng() % 16 != 0;     // sometimes without WEL: no effect
+                c.opcode    = op == S_PROGRAM ? OP_PAGE_PROGRAM : OP_QUAD_PROGRAM;
+                c.data_mode = op == S_PROGRAM ? MODE_STD : MODE_QUAD;
+                for (size_t i = 0; i < len; i++)
+                    buf[i] = uint8_t(rng());
+                break;
+            case S_ERASE:
+                wren = rng() % 8 != 0;
+                break;
+            default:
+                break;
+        }
+
+        if (n >= log_from)
+            std::cout << "  op " << n << ": " << op_names[op] << " addr=0x" << std::hex
+                      << addr << std::dec << " len=" << len
+                      << (wren ? " +wren" : "") << "\n";
+
+        if (wren) {
+            drv.write_enable();
+            ref.write_enable();
+            st.transactions++;
+        }
+
+        switch (op) {
+            case S_READ:
+            case S_FAST_READ:
+            case S_QUAD_READ: {
+                got.assign(len, 0);
+                exp.assign(len, 0);
+                drv.transfer(c, nullptr, got.data(), len);
+                ref.read(addr, exp.data(), len);
+                if (got != exp) {
+                    size_t i = 0;
+                    while (got[i] == exp[i]) i++;
+                    std::cout << "MISMATCH at op " << n << " (" << op_names[op]
+                              << " addr=0x" << std::hex << addr << std::dec << " len=" << len
+                              << "): byte " << i << " (0x" << std::hex << addr + i
+                              << ") got 0x" << int(got[i]) << " expected 0x" << int(exp[i])
+                              << std::dec << "\n"
+                              << "replay: +seed=" << seed << " +ops=" << n + 1
+                              << " +log_from=" << (n >= 20 ? n - 20 : 0) << "\n";
+                    failed = true;
+                }
+                break;
+            }
+            case S_PROGRAM:
+            case S_QUAD_PROGRAM:
+                drv.transfer(c, buf.data(), nullptr, len);
+                ref.program(addr, buf.data(), len);
+                break;
+            case S_ERASE:
+                c.opcode    = OP_SECTOR_ERASE;
+                c.data_mode = MODE_NONE;
+                drv.transfer(c, nullptr, nullptr, 0);
+                ref.erase_sector(addr);
+                break;
+            case S_WREN:
+                drv.write_enable();
+                ref.write_enable();
+                break;
+            case S_WRDI:
+                drv.write_disable();
+                ref.write_disable();
+                break;
+        }
+        st.transactions++;
+        st.bytes += len;
+
+        if (drv.timeouts) {
+            std::cout << "TIMEOUT at op " << n << ", replay: +seed=" << seed
+                      << " +ops=" << n + 1 << "\n";
+            failed = true;
+        }
+    }
+
+    // Contents never read back still have to match
+    if (!failed) {
+        for (uint32_t a = 0; a < region; a++)
+            if (mem->read(a) != ref.read(a)) {
+                std::cout << "MISMATCH in final compare at 0x" << std::hex << a
+                          << ": store 0x" << int(mem->read(a)) << " expected 0x"
+                          << int(ref.read(a)) << std::dec << "\n";
+                failed = true;
+                break;
+            }
+    }
+
+    std::chrono::duration<double> wall = std::chrono::steady_clock::now() - wall_start;
+    std::cout << "\nops:";
+    for (int i = 0; i < NUM_OPS; i++)
+        std::cout << " " << op_names[i] << "=" << st.ops[i];
+    std::cout << "\n" << n << " ops, " << st.transactions << " transactions, "
+              << st.bytes << " data bytes, " << drv.ticks << " cycles in "
+              << wall.count() << " s\n"
+              << uint64_t(n / wall.count()) << " ops/s, "
+              << uint64_t(st.transactions / wall.count()) << " transactions/s, "
+              << uint64_t(drv.ticks / wall.count()) << " cycles/s\n"
+              << (failed ? "FAILED" : "PASSED") << " seed=" << seed << "\n";
+
+    dut->final();
+    tfp->close();
+    delete tfp;
+    delete dut;
+    return failed ? 1 : 0;
+}
@@ -1,21 +1,21 @@
 #include "Vspi_master_controller.h"    // generated by Verilator
 #include "verilated.h"
-#include "verilated_vcd_c.h"
+#include "tb_trace.h"
 #include <iostream>
 #include <cstdint>
 
-void tick(int32_t tick_val, Vspi_master_controller *dut, VerilatedVcdC* tfp);
-void wait_eot(Vspi_master_controller* dut, VerilatedVcdC* tfp);
+void tick(int32_t tick_val, Vspi_master_controller *dut, TbTrace* tfp);
+void wait_eot(Vspi_master_controller* dut, TbTrace* tfp);
 
 int main(int argc, char **argv, char **env) {
     Verilated::commandArgs(argc, argv);
-    Vspi_master_controller *dut = new Vspi_master_controller;
 
-    // VCD waveform dump (optional)
-    VerilatedVcdC* tfp = new VerilatedVcdC;
-    Verilated::traceEverOn(true);
-    dut->trace(tfp, 99);
-    tfp->open("waveform.vcd");
+    // Waveform dump (optional), +trace=none|vcd|fst
+    TbTrace* tfp = new TbTrace;
+    tfp->init();
+
+    Vspi_master_controller *dut = new Vspi_master_controller;
+    tfp->open(dut, "waveform");
 
     dut->rstn                  = 0;
     dut->spi_clk_div           = 0;
@@ -28,10 +28,17 @@ int main(int argc, char **argv, char **env) {
     dut->spi_dummy_rd          = 0;
     dut->spi_dummy_wr          = 0;
     dut->spi_csreg             = 0;
+    dut->spi_cmd_lanes         = 0;
+    dut->spi_addr_lanes        = 0;
+    dut->spi_data_cont         = 0;
+    dut->spi_dtr               = 0;
+    dut->spi_mode_bits         = 0;
+    dut->spi_mode_bits_en      = 0;
     dut->spi_rd                = 0;
     dut->spi_wr                = 0;
     dut->spi_qrd               = 0;
     dut->spi_qwr               = 0;
+    dut->spi_drd               = 0;
     dut->spi_ctrl_data_tx      = 0;
     dut->spi_ctrl_data_tx_valid= 0;
     dut->spi_ctrl_data_rx_ready= 1;
@@ -89,13 +96,14 @@ int main(int argc, char **argv, char **env) {
     // Finish
     dut->final();
     tfp->close();
+    delete tfp;
     delete dut;
     return 0;
 }
 
 vluint64_t sim_time = 0;
 
-void tick(int32_t tick_val, Vspi_master_controller *dut, VerilatedVcdC* tfp) {
+void tick(int32_t tick_val, Vspi_master_controller *dut, TbTrace* tfp) {
     for (int i = 0; i < tick_val; i++) {
         dut->clk = 0;
         dut->eval();
@@ -108,7 +116,7 @@ void tick(int32_t tick_val, Vspi_master_controller *dut, VerilatedVcdC* tfp) {
 }
 
 
-void wait_eot(Vspi_master_controller* dut, VerilatedVcdC* tfp) {
+void wait_eot(Vspi_master_controller* dut, TbTrace* tfp) {
     int timeout = 10000;
     while (timeout--) {
         // falling edge first
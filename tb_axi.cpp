@@ -0,0 +1,498 @@
+// AXI testbench for axi_spi_master with the execute-in-place read window.
+//
+// Programs a 1 KB image through the register interface, then reads it back
+// through the XIP window with sequential single-beat reads, sequential 8-beat
+// bursts and random single-beat reads, for several REG_XIPCFG settings.
+// Every read is checked against the image; average and worst-case latency
+// (ARVALID to last R beat, system clock cycles) are reported per pattern.
+// TEST 5 moves data through the TX/RX FIFO windows with one AXI transaction
+// per word and with bursts and reports bytes per AXI clock for both. TEST 6
+// checks the performance counters against known traffic. TEST 7 compares the
+// system clocks from the first AXI write to the first SPI clock edge for the
+// five-register command sequence and for REG_LAUNCH. TEST 8 starts register
+// commands while XIP line fetches run.
+#include "Vaxi_spi_flash_top.h"
+#include "verilated.h"
+#include "tb_trace.h"
+#include "axi_bfm.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// ============================================================================
+// Globals
+// ============================================================================
+vluint64_t sim_time = 0;
+int test_pass = 0;
+int test_fail = 0;
+
+const uint32_t XIP_BASE   = 0x01000000;
+const uint32_t IMAGE_ADDR = 0x000400;
+const uint32_t IMAGE_SIZE = 1024;
+
+// ============================================================================
+// Helpers
+// ============================================================================
+void check(const std::string& test_name, uint32_t got, uint32_t expected) {
+    if (got == expected) {
+        std::cout << "  [PASS] " << test_name
+                  << " got=0x" << std::hex << got << std::dec << "\n";
+        test_pass++;
+    } else {
+        std::cout << "  [FAIL] " << test_name
+                  << " expected=0x" << std::hex << expected
+                  << " got=0x" << got << std::dec << "\n";
+        test_fail++;
+    }
+}
+
+// Image word at byte offset off, as seen through the little-endian window
+uint32_t image_word(const std::vector<uint8_t>& img, uint32_t off) {
+    return uint32_t(img[off]) | (uint32_t(img[off + 1]) << 8) |
+           (uint32_t(img[off + 2]) << 16) | (uint32_t(img[off + 3]) << 24);
+}
+
+struct Latency {
+    uint64_t total = 0;
+    uint64_t worst = 0;
+    uint64_t count = 0;
+    int      errors = 0;
+
+    void add(uint64_t c) {
+        total += c;
+        count++;
+        worst = std::max(worst, c);
+    }
+};
+
+void report(const char* cfg, const char* pattern, const Latency& l) {
+    char line[160];
+    std::snprintf(line, sizeof(line), "  %-18s %-12s %5llu reads  avg %8.1f  worst %6llu cycles",
+                  cfg, pattern, (unsigned long long)l.count,
+                  l.count ? double(l.total) / l.count : 0.0,
+                  (unsigned long long)l.worst);
+    std::cout << line << "\n";
+    if (l.errors == 0) {
+        test_pass++;
+    } else {
+        std::cout << "  [FAIL] " << cfg << " " << pattern << ": "
+                  << l.errors << " mismatching words\n";
+        test_fail++;
+    }
+}
+
+// Bytes per AXI clock of one transfer done with single beats and with bursts
+void report_rate(const char* what, uint64_t single_c, uint64_t burst_c, int bytes) {
+    char line[160];
+    std::snprintf(line, sizeof(line),
+                  "  %-20s single %6llu cycles %5.2f B/clk   burst %6llu cycles %5.2f B/clk",
+                  what, (unsigned long long)single_c, double(bytes) / single_c,
+                  (unsigned long long)burst_c, double(bytes) / burst_c);
+    std::cout << line << "\n";
+}
+
+// AXI write to first SPI clock of both ways to start a command
+void report_launch(const char* what, uint64_t regs_c, uint64_t launch_c) {
+    char line[160];
+    std::snprintf(line, sizeof(line), "  %-18s registers %4llu cycles   launch %4llu cycles",
+                  what, (unsigned long long)regs_c, (unsigned long long)launch_c);
+    std::cout << line << "\n";
+}
+
+// Snapshot the performance counters (optionally clearing them) and read all
+void read_perf(AxiBfm& bfm, uint32_t* v, bool clear = false) {
+    bfm.write32(REG_STATUS, clear ? 0x60 : 0x20);
+    bfm.read_burst(REG_PERF, v, PERF_WORDS);
+}
+
+struct XipConfig {
+    const char* name;
+    uint32_t    cfg;
+};
+
+// ============================================================================
+// main
+// ============================================================================
+int main(int argc, char **argv) {
+    Verilated::commandArgs(argc, argv);
+
+    // +trace=none|vcd|fst, see tb_trace.h
+    TbTrace* tfp = new TbTrace;
+    tfp->init();
+
+    Vaxi_spi_flash_top *dut = new Vaxi_spi_flash_top;
+    tfp->open(dut, "waveform_axi");
+
+    AxiBfm bfm(dut, tfp, sim_time);
+
+    // -------------------------------------------------------------------------
+    // Reset
+    // -------------------------------------------------------------------------
+    bfm.reset_inputs();
+    dut->rstn = 0;
+    bfm.tick(10);
+    dut->rstn = 1;
+    bfm.tick(10);
+
+    std::cout << "\n=== AXI SPI Master XIP Testbench ===\n\n";
+
+    bfm.write32(REG_CLKDIV, 1);
+
+    // =========================================================================
+    // TEST 1: JEDEC ID through the register interface
+    // =========================================================================
+    std::cout << "[TEST 1] Read JEDEC ID (0x9F) through the RX FIFO\n";
+    bfm.spi_command(0x9F, false, 0, 24, 0, 0x1);
+    check("JEDEC ID", bfm.read32(REG_RXFIFO), 0x0020BA19);
+    bfm.wait_idle();
+
+    // =========================================================================
+    // TEST 2: Program a 1 KB image, 32 bytes per page program
+    // =========================================================================
+    std::cout << "\n[TEST 2] Program " << IMAGE_SIZE << " bytes at 0x"
+              << std::hex << IMAGE_ADDR << std::dec << "\n";
+    std::vector<uint8_t> image(IMAGE_SIZE);
+    for (uint32_t i = 0; i < IMAGE_SIZE; i++)
+        image[i] = uint8_t((i * 7 + 3) ^ (i >> 8));
+
+    for (uint32_t off = 0; off < IMAGE_SIZE; off += 32) {
+        bfm.spi_command(0x06, false, 0, 0, 0, 0x2);
+        bfm.wait_idle();
+        // fill the TX FIFO before starting, first byte on the wire in [31:24]
+        for (uint32_t w = 0; w < 8; w++) {
+            const uint8_t* p = &image[off + w * 4];
+            bfm.write32(REG_TXFIFO, (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) |
+                                    (uint32_t(p[2]) << 8) | p[3]);
+        }
+        bfm.spi_command(0x02, true, IMAGE_ADDR + off, 256, 0, 0x2);
+        bfm.wait_idle();
+    }
+
+    // =========================================================================
+    // TEST 3: XIP read latency and data, per configuration and access pattern
+    // =========================================================================
+    std::cout << "\n[TEST 3] XIP reads from 0x" << std::hex << XIP_BASE + IMAGE_ADDR
+              << std::dec << "\n";
+
+    const uint32_t XIP_EN       = 1u << 31;
+    const uint32_t XIP_PREFETCH = 1u << 18;
+    const uint32_t XIP_QUAD_ADR = 1u << 17;
+    const uint32_t XIP_QUAD     = 1u << 16;
+    const XipConfig configs[] = {
+        {"0x0B",              XIP_EN | (8u << 8)  | 0x0B},
+        {"0x0B prefetch",     XIP_EN | (8u << 8)  | 0x0B | XIP_PREFETCH},
+        {"0x6B prefetch",     XIP_EN | (8u << 8)  | 0x6B | XIP_QUAD | XIP_PREFETCH},
+        {"0xEB prefetch",     XIP_EN | (10u << 8) | 0xEB | XIP_QUAD | XIP_QUAD_ADR | XIP_PREFETCH},
+    };
+
+    for (const XipConfig& xc : configs) {
+        // rewriting REG_XIPCFG drops both lines, every pattern starts cold
+        Latency seq, burst, rnd;
+
+        bfm.write32(REG_XIPCFG, xc.cfg);
+        for (uint32_t off = 0; off < IMAGE_SIZE; off += 4) {
+            uint32_t v = 0;
+            uint64_t c = bfm.read_burst(XIP_BASE + IMAGE_ADDR + off, &v, 1);
+            seq.add(c);
+            if (v != image_word(image, off)) seq.errors++;
+        }
+        report(xc.name, "sequential", seq);
+
+        bfm.write32(REG_XIPCFG, xc.cfg);
+        for (uint32_t off = 0; off < IMAGE_SIZE; off += 32) {
+            uint32_t v[8];
+            burst.add(bfm.read_burst(XIP_BASE + IMAGE_ADDR + off, v, 8));
+            for (int b = 0; b < 8; b++)
+                if (v[b] != image_word(image, off + 4 * b)) burst.errors++;
+        }
+        report(xc.name, "burst8", burst);
+
+        bfm.write32(REG_XIPCFG, xc.cfg);
+        uint16_t lfsr = 0xACE1;
+        for (int i = 0; i < 128; i++) {
+            lfsr = (lfsr >> 1) ^ (-(lfsr & 1u) & 0xB400u);
+            uint32_t off = (lfsr % (IMAGE_SIZE / 4)) * 4;
+            uint32_t v = 0;
+            rnd.add(bfm.read_burst(XIP_BASE + IMAGE_ADDR + off, &v, 1));
+            if (v != image_word(image, off)) rnd.errors++;
+        }
+        report(xc.name, "random", rnd);
+    }
+
+    // =========================================================================
+    // TEST 4: register interface still works once XIP is disabled
+    // =========================================================================
+    std::cout << "\n[TEST 4] Register read after XIP\n";
+    bfm.write32(REG_XIPCFG, 0x0000080B);
+    check("XIPCFG readback", bfm.read32(REG_XIPCFG), 0x0000080B);
+    bfm.spi_command(0x03, true, IMAGE_ADDR, 32, 0, 0x1);
+    check("Read (0x03) first word", bfm.read32(REG_RXFIFO),
+          (uint32_t(image[0]) << 24) | (uint32_t(image[1]) << 16) |
+          (uint32_t(image[2]) << 8) | image[3]);
+    bfm.wait_idle();
+
+    // =========================================================================
+    // TEST 5: FIFO windows, single-beat against burst transfers
+    // =========================================================================
+    std::cout << "\n[TEST 5] TX/RX FIFO windows: single beats against bursts\n";
+    {
+        uint32_t words[64], back[64];
+        uint64_t single_c = 0, burst_c = 0;
+
+        // bus side only: 8 words into the empty TX FIFO, then software reset
+        for (int i = 0; i < 8; i++) words[i] = 0xA5000000u | i;
+        for (int i = 0; i < 8; i++)
+            single_c += bfm.write32(REG_TXFIFO, words[i]);
+        bfm.write32(REG_STATUS, 0x10);
+        burst_c = bfm.write_burst(REG_TXFIFO, words, 8);
+        check("TX level after burst", bfm.read32(REG_STATUS) >> 24, 8);
+        bfm.write32(REG_STATUS, 0x10);
+        report_rate("TX FIFO 8 words", single_c, burst_c, 32);
+
+        // 8 words waiting in the RX FIFO
+        bfm.spi_command(0x0B, true, IMAGE_ADDR, 256, 8, 0x1);
+        bfm.wait_idle();
+        single_c = 0;
+        for (int i = 0; i < 8; i++)
+            single_c += bfm.read_burst(REG_RXFIFO, &back[i], 1);
+        bfm.spi_command(0x0B, true, IMAGE_ADDR, 256, 8, 0x1);
+        bfm.wait_idle();
+        burst_c = bfm.read_burst(REG_RXFIFO, back + 8, 8);
+        int bad = 0;
+        for (int i = 0; i < 8; i++) {
+            uint32_t w = (uint32_t(image[4 * i]) << 24) | (uint32_t(image[4 * i + 1]) << 16) |
+                         (uint32_t(image[4 * i + 2]) << 8) | image[4 * i + 3];
+            bad += (back[i] != w) + (back[8 + i] != w);
+        }
+        check("RX FIFO data, single and burst", bad, 0);
+        report_rate("RX FIFO 8 words", single_c, burst_c, 32);
+
+        // one page streamed through the 8-word FIFOs while the SPI runs
+        for (int i = 0; i < 64; i++) words[i] = 0x01020304u * (i + 1);
+        for (int b = 0; b < 2; b++) {
+            uint32_t page = 0x001000 + 0x100 * b;
+            bfm.spi_command(0x06, false, 0, 0, 0, 0x2);
+            bfm.wait_idle();
+            bfm.spi_command(0x02, true, page, 2048, 0, 0x2);
+            uint64_t c = 0;
+            if (b)
+                c = bfm.write_burst(REG_TXFIFO, words, 64);
+            else
+                for (int i = 0; i < 64; i++)
+                    c += bfm.write32(REG_TXFIFO, words[i]);
+            (b ? burst_c : single_c) = c;
+            bfm.wait_idle();
+        }
+        report_rate("Page program 256 B", single_c, burst_c, 256);
+
+        for (int b = 0; b < 2; b++) {
+            uint32_t page = 0x001000 + 0x100 * b;
+            bfm.spi_command(0x0B, true, page, 2048, 8, 0x1);
+            uint64_t c = 0;
+            if (b)
+                c = bfm.read_burst(REG_RXFIFO, back, 64);
+            else
+                for (int i = 0; i < 64; i++)
+                    c += bfm.read_burst(REG_RXFIFO, &back[i], 1);
+            (b ? burst_c : single_c) = c;
+            bfm.wait_idle();
+            bad = 0;
+            for (int i = 0; i < 64; i++)
+                bad += (back[i] != words[i]);
+            check(b ? "Page read back, burst" : "Page read back, single", bad, 0);
+        }
+        report_rate("Page read 256 B", single_c, burst_c, 256);
+    }
+
+    // =========================================================================
+    // TEST 6: performance counters against known traffic
+    // =========================================================================
+    std::cout << "\n[TEST 6] Performance counters\n";
+    {
+        uint32_t p[PERF_WORDS], q[PERF_WORDS], words[16];
+        const char* state_names[8] = {"IDLE", "CMD", "ADDR", "MODE", "DUMMY",
+                                      "DATA_TX", "DATA_RX", "WAIT_EDGE"};
+
+        read_perf(bfm, p, true);
+        read_perf(bfm, p);
+        check("Transactions after clear", p[PERF_XFERS], 0);
+        check("TX bytes after clear", p[PERF_TX_BYTES], 0);
+        check("RX bytes after clear", p[PERF_RX_BYTES], 0);
+
+        // 3 + 32 bytes received, 32 sent, 4 transactions
+        read_perf(bfm, p, true);
+        bfm.spi_command(0x9F, false, 0, 24, 0, 0x1);
+        bfm.read32(REG_RXFIFO);
+        bfm.wait_idle();
+        bfm.spi_command(0x06, false, 0, 0, 0, 0x2);
+        bfm.wait_idle();
+        for (int i = 0; i < 8; i++) {
+            words[i] = 0x11223344u + 0x01010101u * i;
+            bfm.write32(REG_TXFIFO, words[i]);
+        }
+        bfm.spi_command(0x02, true, 0x002000, 256, 0, 0x2);
+        bfm.wait_idle();
+        bfm.spi_command(0x0B, true, 0x002000, 256, 8, 0x1);
+        bfm.wait_idle();
+        for (int i = 0; i < 8; i++)
+            bfm.read32(REG_RXFIFO);
+        read_perf(bfm, p);
+
+        check("Transactions", p[PERF_XFERS], 4);
+        check("TX bytes", p[PERF_TX_BYTES], 32);
+        check("RX bytes", p[PERF_RX_BYTES], 3 + 32);
+        uint64_t state_sum = 0;
+        for (int i = 0; i < 8; i++) {
+            state_sum += p[PERF_STATE + i];
+            std::cout << "  " << state_names[i] << " " << p[PERF_STATE + i] << " cycles\n";
+        }
+        check("State cycles add up to cycles", uint32_t(state_sum), p[PERF_CYCLES]);
+        check("DATA_TX cycles counted", p[PERF_STATE + 5] > 0, 1);
+        check("DUMMY cycles counted", p[PERF_STATE + 4] > 0, 1);
+        check("No TX stall with a full TX FIFO", p[PERF_TX_STALL], 0);
+        check("No RX stall within the RX FIFO", p[PERF_RX_STALL], 0);
+
+        // the shadow registers only change on a snapshot
+        bfm.spi_command(0x9F, false, 0, 24, 0, 0x1);
+        bfm.read32(REG_RXFIFO);
+        bfm.wait_idle();
+        bfm.read_burst(REG_PERF, q, PERF_WORDS);
+        int diff = 0;
+        for (int i = 0; i < PERF_WORDS; i++)
+            diff += (p[i] != q[i]);
+        check("Counters frozen until the next snapshot", diff, 0);
+
+        // 16 words into the 8-word RX FIFO without draining: RX stalls
+        read_perf(bfm, p, true);
+        bfm.spi_command(0x0B, true, 0x002000, 512, 8, 0x1);
+        bfm.tick(4000);
+        for (int i = 0; i < 16; i++)
+            bfm.read32(REG_RXFIFO);
+        bfm.wait_idle();
+        read_perf(bfm, p);
+        check("RX bytes, 64-byte read", p[PERF_RX_BYTES], 64);
+        check("RX stall cycles with a full RX FIFO", p[PERF_RX_STALL] > 0, 1);
+        std::cout << "  RX stall " << p[PERF_RX_STALL] << " cycles\n";
+
+        // 16 words written one by one after the kick: TX underruns
+        read_perf(bfm, p, true);
+        bfm.spi_command(0x06, false, 0, 0, 0, 0x2);
+        bfm.wait_idle();
+        bfm.spi_command(0x02, true, 0x002100, 512, 0, 0x2);
+        for (int i = 0; i < 16; i++) {
+            bfm.tick(100);
+            bfm.write32(REG_TXFIFO, words[i % 8]);
+        }
+        bfm.wait_idle();
+        read_perf(bfm, p);
+        check("TX bytes, 64-byte program", p[PERF_TX_BYTES], 64);
+        check("TX stall cycles with a slow writer", p[PERF_TX_STALL] > 0, 1);
+        std::cout << "  TX stall " << p[PERF_TX_STALL] << " cycles\n";
+    }
+
+    // =========================================================================
+    // TEST 7: first SPI clock after the first AXI write, registers vs launch
+    // =========================================================================
+    std::cout << "\n[TEST 7] AXI write to first SPI clock: SPICMD..STATUS against LAUNCH\n";
+    {
+        struct LaunchCmd {
+            const char* name;
+            uint8_t     cmd;
+            bool        has_addr;
+            int         bytes;
+            int         dummy;
+        };
+        const LaunchCmd cmds[] = {
+            {"JEDEC ID 0x9F",  0x9F, false, 3, 0},
+            {"Read 0x03",      0x03, true,  4, 0},
+            {"Fast read 0x0B", 0x0B, true,  4, 8},
+        };
+
+        for (const LaunchCmd& c : cmds) {
+            uint32_t v[2];
+            uint64_t lat[2];
+            for (int l = 0; l < 2; l++) {
+                uint64_t t0 = bfm.clocks;
+                bfm.arm_spi_edge();
+                if (l)
+                    bfm.spi_launch(c.cmd, c.has_addr, IMAGE_ADDR, c.bytes, c.dummy, 0);
+                else
+                    bfm.spi_command(c.cmd, c.has_addr, IMAGE_ADDR, c.bytes * 8, c.dummy, 0x1);
+                bfm.wait_spi_edge();
+                lat[l] = bfm.spi_edge_cycle - t0;
+                v[l] = bfm.read32(REG_RXFIFO);
+                bfm.wait_idle();
+            }
+            report_launch(c.name, lat[0], lat[1]);
+            check(std::string(c.name) + " data, launch", v[1], v[0]);
+            check(std::string(c.name) + " launch sooner", lat[1] < lat[0], 1);
+        }
+
+        // the launch fields read back through the command registers
+        check("SPICMD after launch", bfm.read32(REG_SPICMD), 0x0B000000);
+        check("SPIADR after launch", bfm.read32(REG_SPIADR), IMAGE_ADDR << 8);
+        check("SPILEN after launch", bfm.read32(REG_SPILEN), (32u << 16) | (24u << 8) | 8u);
+        check("SPIDUM after launch", bfm.read32(REG_SPIDUM), 0x00080008);
+
+        // write enable and a 4-byte program, then read back, all launched
+        bfm.spi_launch(0x06, false, 0, 0, 0, 1);
+        bfm.wait_idle();
+        bfm.write32(REG_TXFIFO, 0xC0FFEE42);
+        bfm.spi_launch(0x02, true, 0x002200, 4, 0, 1);
+        bfm.wait_idle();
+        bfm.spi_launch(0x03, true, 0x002200, 4, 0, 0);
+        check("Launched program read back", bfm.read32(REG_RXFIFO), 0xC0FFEE42);
+        bfm.wait_idle();
+    }
+
+    // =========================================================================
+    // TEST 8: register commands started while an XIP line fetch runs
+    // =========================================================================
+    std::cout << "\n[TEST 8] Register commands during XIP line fetches\n";
+    {
+        // a single-beat read returns with the first word of its line, the
+        // rest of the line and the prefetch of the next one are still running
+        const uint32_t cfg = XIP_EN | (8u << 8) | 0x0B | XIP_PREFETCH;
+        for (int k = 0; k < 4; k++) {
+            uint32_t off = uint32_t(k) * 64;
+            uint32_t v = 0;
+            bfm.write32(REG_XIPCFG, cfg);
+            bfm.read_burst(XIP_BASE + IMAGE_ADDR + off, &v, 1);
+            check("XIP word before the command", v, image_word(image, off));
+            if (k & 1)
+                bfm.spi_launch(0x9F, false, 0, 3, 0, 0);
+            else
+                bfm.spi_command(0x9F, false, 0, 24, 0, 0x1);
+            check("JEDEC ID started during a fetch", bfm.read32(REG_RXFIFO), 0x0020BA19);
+            bfm.wait_idle();
+
+            // neither line holds the JEDEC ID
+            uint32_t w[16];
+            bfm.read_burst(XIP_BASE + IMAGE_ADDR + off, w, 16);
+            int bad = 0;
+            for (int b = 0; b < 16; b++)
+                if (w[b] != image_word(image, off + 4 * b)) bad++;
+            check("XIP lines after the command, mismatches", bad, 0);
+        }
+        bfm.write32(REG_XIPCFG, 0x0000080B);
+    }
+
+    // =========================================================================
+    // Summary
+    // =========================================================================
+    test_fail += bfm.timeouts;
+    std::cout << "\n=== Results: "
+              << test_pass << " passed, "
+              << test_fail << " failed ===\n";
+
+    bfm.tick(20);
+
+    dut->final();
+    tfp->close();
+    delete tfp;
+    delete dut;
+    return (test_fail > 0) ? 1 : 0;
+}
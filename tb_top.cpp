@@ -1,9 +1,32 @@
 #include "Vspi_flash_top.h"
 #include "verilated.h"
-#include "verilated_vcd_c.h"
+#include "tb_trace.h"
+#include "flash_driver.h"
+#include "flash_mem.h"
+#ifdef TB_SAVABLE
+#include "verilated_save.h"
+#endif
+#include <algorithm>
+#include <chrono>
 #include <iostream>
 #include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
 #include <string>
+#include <vector>
+
+// Busy times of flash 1 in clk cycles, set with TB_MODEL_PARAMS in the Makefile
+#ifndef TB_T_PP
+#define TB_T_PP 5000
+#endif
+#ifndef TB_T_SE
+#define TB_T_SE 20000
+#endif
+#ifndef TB_T_CE
+#define TB_T_CE 50000
+#endif
 
 // ============================================================================
 // Globals
@@ -11,11 +34,12 @@
 vluint64_t sim_time = 0;
 int test_pass = 0;
 int test_fail = 0;
+TbTrace* trace = nullptr;   // for capture() in check() and check_bool()
 
 // ============================================================================
 // Helpers
 // ============================================================================
-void tick(int32_t tick_val, Vspi_flash_top *dut, VerilatedVcdC* tfp) {
+void tick(int32_t tick_val, Vspi_flash_top *dut, TbTrace* tfp) {
     for (int i = 0; i < tick_val; i++) {
         dut->clk = 0;
         dut->eval();
@@ -27,7 +51,7 @@ void tick(int32_t tick_val, Vspi_flash_top *dut, VerilatedVcdC* tfp) {
 }
 
 // Sample eot/status on falling edge before rising edge latches state→IDLE
-void wait_status(Vspi_flash_top* dut, VerilatedVcdC* tfp, int timeout = 50000) {
+void wait_status(Vspi_flash_top* dut, TbTrace* tfp, int timeout = 50000) {
     while (timeout--) {
         dut->clk = 0;
         dut->eval();
@@ -46,9 +70,10 @@ void wait_status(Vspi_flash_top* dut, VerilatedVcdC* tfp, int timeout = 50000) {
     }
     std::cout << "  [TIMEOUT] status never went high!\n";
     test_fail++;
+    tfp->capture("wait_status timeout");
 }
 
-void clear_status(Vspi_flash_top* dut, VerilatedVcdC* tfp) {
+void clear_status(Vspi_flash_top* dut, TbTrace* tfp) {
     dut->clr_status_i = 1;
     tick(1, dut, tfp);
     dut->clr_status_i = 0;
@@ -56,7 +81,7 @@ void clear_status(Vspi_flash_top* dut, VerilatedVcdC* tfp) {
 }
 
 // Pulse start for exactly 1 cycle
-void start_transfer(Vspi_flash_top* dut, VerilatedVcdC* tfp) {
+void start_transfer(Vspi_flash_top* dut, TbTrace* tfp) {
     dut->start_i = 1;
     tick(1, dut, tfp);
     dut->start_i = 0;
@@ -72,6 +97,7 @@ void check(const std::string& test_name, uint32_t got, uint32_t expected) {
                   << " expected=0x" << std::hex << expected
                   << " got=0x" << got << "\n";
         test_fail++;
+        if (trace) trace->capture(test_name);
     }
 }
 
@@ -83,11 +109,12 @@ void check_bool(const std::string& test_name, bool got, bool expected) {
         std::cout << "  [FAIL] " << test_name
                   << " expected=" << expected << " got=" << got << "\n";
         test_fail++;
+        if (trace) trace->capture(test_name);
     }
 }
 
 // Push a 32-bit word into the TX FIFO, wait for ready
-void push_tx(Vspi_flash_top* dut, VerilatedVcdC* tfp, uint32_t data) {
+void push_tx(Vspi_flash_top* dut, TbTrace* tfp, uint32_t data) {
     int timeout = 1000;
     dut->data_tx_i       = data;
     dut->data_tx_valid_i = 1;
@@ -99,7 +126,7 @@ void push_tx(Vspi_flash_top* dut, VerilatedVcdC* tfp, uint32_t data) {
 }
 
 // Drain one 32-bit word from RX FIFO
-uint32_t pop_rx(Vspi_flash_top* dut, VerilatedVcdC* tfp) {
+uint32_t pop_rx(Vspi_flash_top* dut, TbTrace* tfp) {
     int timeout = 2000;  // increase timeout
     dut->data_rx_ready_i = 1;
     while (!dut->data_rx_valid_o && timeout--) {
@@ -107,6 +134,7 @@ uint32_t pop_rx(Vspi_flash_top* dut, VerilatedVcdC* tfp) {
     }
     if (timeout <= 0) {
         std::cout << "  [pop_rx TIMEOUT] RX FIFO never had data!\n";
+        tfp->capture("pop_rx timeout");
         dut->data_rx_ready_i = 0;
         return 0xDEAD0000;  // sentinel so you know it failed here
     }
@@ -116,15 +144,29 @@ uint32_t pop_rx(Vspi_flash_top* dut, VerilatedVcdC* tfp) {
     return data;
 }
 
+// Big-endian word <-> bytes, first byte on the wire is the MSB
+uint32_t be32(const uint8_t* p) {
+    return (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) |
+           (uint32_t(p[2]) << 8)  |  uint32_t(p[3]);
+}
+
+void put_be32(uint8_t* p, uint32_t v) {
+    for (int i = 0; i < 4; i++)
+        p[i] = (v >> (24 - 8 * i)) & 0xFF;
+}
+
 // ============================================================================
 // Default safe state for all inputs
 // ============================================================================
 void default_inputs(Vspi_flash_top* dut) {
     dut->command_i       = 0;
     dut->data_mode_i     = 0;
+    dut->addr_mode_i     = 0;
     dut->rd_wr_i         = 0;
     dut->dummy_cycle_i   = 0;
     dut->data_count_i    = 0;
+    dut->continuous_i    = 0;
+    dut->stop_i          = 0;
     dut->has_addr_i      = 0;
     dut->prescaler_i     = 4;   // reasonable SPI speed
     dut->clr_status_i    = 0;
@@ -135,468 +177,1455 @@ void default_inputs(Vspi_flash_top* dut) {
     dut->data_rx_ready_i = 0;
     dut->flush_tx_i      = 0;
     dut->flush_rx_i      = 0;
+    dut->tx_ae_thresh_i  = 0;
+    dut->rx_af_thresh_i  = 0;
+    dut->irq_en_i        = 0;
+    dut->desc_i          = 0;
+    dut->desc_valid_i    = 0;
+    dut->seq_start_i     = 0;
+    dut->poll_start_i    = 0;
+    dut->poll_cmd_i      = 0;
+    dut->poll_mask_i     = 0;
+    dut->poll_match_i    = 0;
+    dut->poll_interval_i = 0;
+    dut->poll_max_i      = 0;
+    dut->dtr_i           = 0;
+    dut->addr_4b_i       = 0;
+    dut->mode_en_i       = 0;
+    dut->mode_bits_i     = 0;
+    dut->no_cmd_i        = 0;
+    dut->cs_i            = 0;
+    dut->desc_cs_i       = 0;
 }
 
 // ============================================================================
-// main
+// TEST 1: Write Enable (0x06) — no addr, no data
 // ============================================================================
-int main(int argc, char **argv) {
-    Verilated::commandArgs(argc, argv);
-    Vspi_flash_top *dut = new Vspi_flash_top;
+void test_write_enable(Vspi_flash_top* dut, TbTrace* tfp, FlashDriver& drv) {
+    std::cout << "[TEST 1] Write Enable (0x06)\n";
+    bool done = drv.write_enable();
+    check_bool("status_o high after WE", done, true);
+    tick(20, dut, tfp);
+}
 
-    VerilatedVcdC* tfp = new VerilatedVcdC;
-    Verilated::traceEverOn(true);
-    dut->trace(tfp, 99);
-    tfp->open("waveform.vcd");
+// ============================================================================
+// TEST 2: Write Disable (0x04) — no addr, no data
+// ============================================================================
+void test_write_disable(Vspi_flash_top* dut, TbTrace* tfp, FlashDriver& drv) {
+    std::cout << "\n[TEST 2] Write Disable (0x04)\n";
+    bool done = drv.write_disable();
+    check_bool("status_o high after WD", done, true);
+    tick(20, dut, tfp);
+}
 
-    // -------------------------------------------------------------------------
-    // Reset
-    // -------------------------------------------------------------------------
+// ============================================================================
+// TEST 3: Read JEDEC ID (0x9F) — no addr, read 3 bytes
+// ============================================================================
+void test_jedec_id(Vspi_flash_top* dut, TbTrace* tfp, FlashDriver& drv) {
+    std::cout << "\n[TEST 3] Read JEDEC ID (0x9F)\n";
+    // MFR_ID=0x20, DEVICE_ID=0xBA19
+    uint32_t id = drv.read_jedec();
+    std::cout << "  JEDEC ID = 0x" << std::hex << id << "\n";
+    check_bool("JEDEC MFR byte = 0x20", ((id >> 16) & 0xFF) == 0x20, true);
+    check("JEDEC device ID", id & 0xFFFF, 0xBA19);
+    tick(20, dut, tfp);
+}
+
+// ============================================================================
+// TEST 4: Read Status Register (0x05) — no addr, read 1 byte
+// ============================================================================
+void test_read_status(Vspi_flash_top* dut, TbTrace* tfp, FlashDriver& drv) {
+    std::cout << "\n[TEST 4] Read Status Register 1 (0x05)\n";
+    uint8_t sr = drv.read_status();
+    std::cout << "  Status Reg = 0x" << std::hex << int(sr) << "\n";
+    // Flash model initialises status_reg_1 = 0x00
+    check("Status byte", sr, 0x00);
+    tick(20, dut, tfp);
+}
+
+// ============================================================================
+// TEST 5: Read Flag Status Register (0x70) — no addr, read 1 byte
+// ============================================================================
+void test_read_flag_status(Vspi_flash_top* dut, TbTrace* tfp, FlashDriver& drv) {
+    std::cout << "\n[TEST 5] Read Flag Status Register (0x70)\n";
+    uint8_t fsr = drv.read_flag_status();
+    std::cout << "  Flag Status Reg = 0x" << std::hex << int(fsr) << "\n";
+    // bit 7: ready, no program or erase in progress
+    check("Flag Status byte", fsr, 0x80);
+    tick(20, dut, tfp);
+}
+
+// ============================================================================
+// TEST 6: Write Enable then Page Program (0x02) at address 0x000000
+// ============================================================================
+void test_page_program(Vspi_flash_top* dut, TbTrace* tfp, FlashDriver& drv) {
+    std::cout << "\n[TEST 6] Page Program (0x02) — write 4 bytes to 0x000000\n";
+    uint8_t wr[4];
+    put_be32(wr, 0xDEADBEEF);
+    bool done = drv.program(0x000000, wr, 4);   // issues WREN first
+    check_bool("Page program completed", done, true);
+    tick(20, dut, tfp);
+}
+
+// ============================================================================
+// TEST 7: Read back what was written — Fast Read (0x0B) with 8 dummy cycles
+// ============================================================================
+void test_fast_read(Vspi_flash_top* dut, TbTrace* tfp, FlashDriver& drv) {
+    std::cout << "\n[TEST 7] Fast Read (0x0B) — read 4 bytes from 0x000000\n";
+    uint8_t rd[4];
+    drv.fast_read(0x000000, rd, 4);
+    std::cout << "  Read back = 0x" << std::hex << be32(rd) << "\n";
+    check("Fast Read data matches written", be32(rd), 0xDEADBEEF);
+    tick(20, dut, tfp);
+}
+
+// ============================================================================
+// TEST 8: Normal Read (0x03) — no dummy cycles, different address
+// ============================================================================
+void test_read(Vspi_flash_top* dut, TbTrace* tfp, FlashDriver& drv) {
+    std::cout << "\n[TEST 8] Normal Read (0x03) — read 4 bytes from 0x000004\n";
+    // First write something at 0x000004
+    uint8_t wr[4], rd[4];
+    put_be32(wr, 0xCAFEBABE);
+    drv.program(0x000004, wr, 4);
+    tick(10, dut, tfp);
+
+    // Now read it back with normal read
+    drv.read(0x000004, rd, 4);
+    std::cout << "  Read back = 0x" << std::hex << be32(rd) << "\n";
+    check("Normal Read data matches written", be32(rd), 0xCAFEBABE);
+    tick(20, dut, tfp);
+}
+
+// ============================================================================
+// TEST 9: Sector Erase (0xD8) then verify erased (0xFF)
+// ============================================================================
+void test_sector_erase(Vspi_flash_top* dut, TbTrace* tfp, FlashDriver& drv) {
+    std::cout << "\n[TEST 9] Sector Erase (0xD8) at 0x000000, then verify\n";
+    bool done = drv.erase_sector(0x000000);     // issues WREN first
+    check_bool("Erase completed", done, true);
+    tick(20, dut, tfp);
+
+    // Read back — should be 0xFFFFFFFF
+    uint8_t rd[4];
+    drv.read(0x000000, rd, 4);
+    std::cout << "  Post-erase read = 0x" << std::hex << be32(rd) << "\n";
+    check("Erased region reads 0xFFFFFFFF", be32(rd), 0xFFFFFFFF);
+    tick(20, dut, tfp);
+}
+
+// ============================================================================
+// TEST 10: Software Reset (0x66 then 0x99)
+// ============================================================================
+void test_soft_reset(Vspi_flash_top* dut, TbTrace* tfp, FlashDriver& drv) {
+    std::cout << "\n[TEST 10] Software Reset (0x66 + 0x99)\n";
+    drv.command(OP_RESET_ENABLE);
+    tick(10, dut, tfp);
+    bool done = drv.command(OP_RESET);
+    check_bool("Reset completed", done, true);
+    tick(20, dut, tfp);
+}
+
+// ============================================================================
+// TEST 11: TX FIFO flush
+// ============================================================================
+void test_tx_flush(Vspi_flash_top* dut, TbTrace* tfp, FlashDriver& drv) {
+    std::cout << "\n[TEST 11] TX FIFO flush\n";
     default_inputs(dut);
-    dut->rstn = 0;
+    // Push some data
+    push_tx(dut, tfp, 0x11223344);
+    push_tx(dut, tfp, 0x55667788);
+    check_bool("TX FIFO not empty before flush", !dut->tx_fifo_empty_o, true);
+
+    // Flush
+    dut->flush_tx_i = 1;
+    tick(2, dut, tfp);
+    dut->flush_tx_i = 0;
+    tick(2, dut, tfp);
+    check_bool("TX FIFO empty after flush", dut->tx_fifo_empty_o, true);
     tick(10, dut, tfp);
-    dut->rstn = 1;
-    dut->data_rx_ready_i = 0;
+}
+
+// ============================================================================
+// TEST 12: Back-to-back writes — write 8 bytes to consecutive addresses
+// ============================================================================
+void test_back_to_back(Vspi_flash_top* dut, TbTrace* tfp, FlashDriver& drv) {
+    std::cout << "\n[TEST 12] Back-to-back writes (0x000010 and 0x000014)\n";
+    uint32_t expected[2] = {0xAABBCCDD, 0x11223344};
+    for (int i = 0; i < 2; i++) {
+        uint8_t wr[4];
+        put_be32(wr, expected[i]);
+        drv.program(0x000010 + (i * 4), wr, 4);
+        tick(5, dut, tfp);
+    }
+
+    // Read both back
+    for (int i = 0; i < 2; i++) {
+        uint8_t rd[4];
+        drv.read(0x000010 + (i * 4), rd, 4);
+        check("Back-to-back read word " + std::to_string(i), be32(rd), expected[i]);
+        tick(5, dut, tfp);
+    }
+}
+
+// ============================================================================
+// TEST 13: Busy signal — check it goes high during transfer
+// ============================================================================
+void test_busy(Vspi_flash_top* dut, TbTrace* tfp, FlashDriver& drv) {
+    std::cout << "\n[TEST 13] Busy signal during transfer\n";
+    default_inputs(dut);
+    dut->command_i   = 0x06;
+    dut->data_mode_i = 0b00;
+    dut->has_addr_i  = 0;
+    dut->rd_wr_i     = 0;
+
+    start_transfer(dut, tfp);
+    tick(2, dut, tfp);  // a couple cycles in — should be busy
+    check_bool("busy_o high during transfer", dut->busy_o, true);
+
+    wait_status(dut, tfp);
+    tick(2, dut, tfp);
+    check_bool("busy_o low after transfer", dut->busy_o, false);
+    clear_status(dut, tfp);
     tick(10, dut, tfp);
+}
 
-    std::cout << "\n=== SPI Flash Top Testbench ===\n\n";
+// ============================================================================
+// TEST 14: clr_status_i clears status_o
+// ============================================================================
+void test_clr_status(Vspi_flash_top* dut, TbTrace* tfp, FlashDriver& drv) {
+    std::cout << "\n[TEST 14] clr_status_i clears status_o\n";
+    default_inputs(dut);
+    dut->command_i   = 0x06;
+    dut->data_mode_i = 0b00;
+    dut->has_addr_i  = 0;
+    dut->rd_wr_i     = 0;
+    start_transfer(dut, tfp);
+    wait_status(dut, tfp);
+    check_bool("status_o high before clear", dut->status_o, true);
 
-    // =========================================================================
-    // TEST 1: Write Enable (0x06) — no addr, no data
-    // =========================================================================
-    std::cout << "[TEST 1] Write Enable (0x06)\n";
-    {
-        default_inputs(dut);
-        dut->command_i   = 0x06;
-        dut->data_mode_i = 0;  // no data phase
-        dut->has_addr_i  = 0;
-        dut->rd_wr_i     = 0;      // write direction (wr path)
+    dut->clr_status_i = 1;
+    tick(1, dut, tfp);
+    dut->clr_status_i = 0;
+    tick(2, dut, tfp);
+    check_bool("status_o low after clear", dut->status_o, false);
+    tick(10, dut, tfp);
+}
+
+// ============================================================================
+// TEST 15: Multi-page program and read through the driver
+// ============================================================================
+void test_multi_page(Vspi_flash_top* dut, TbTrace* tfp, FlashDriver& drv) {
+    std::cout << "\n[TEST 15] Multi-page program + fast read (1000 bytes at 0x0100F0)\n";
+    // Unaligned start so the driver has to split at page boundaries, and
+    // longer than the 8-word FIFOs so data has to stream during transfers
+    const uint32_t base = 0x0100F0;
+    std::vector<uint8_t> wr(1000);
+    for (size_t i = 0; i < wr.size(); i++)
+        wr[i] = uint8_t(i * 7 + 3);
+
+    bool done = drv.program(base, wr);
+    check_bool("Multi-page program completed", done, true);
+
+    std::vector<uint8_t> rd = drv.fast_read(base, wr.size());
+    size_t bad = 0;
+    for (size_t i = 0; i < wr.size(); i++)
+        if (rd[i] != wr[i] && bad++ == 0)
+            std::cout << "  first mismatch at +" << std::dec << i
+                      << " got=0x" << std::hex << int(rd[i])
+                      << " exp=0x" << int(wr[i]) << "\n";
+    check("Multi-page readback mismatches", bad, 0);
+    tick(20, dut, tfp);
+}
+
+// ============================================================================
+// TEST 16: Quad I/O — program with 0x02 / 0x32, read with 0x0B / 0x6B / 0xEB
+// ============================================================================
+void test_quad_io(Vspi_flash_top* dut, TbTrace* tfp, FlashDriver& drv) {
+    std::cout << "\n[TEST 16] Quad I/O (0x32, 0x6B, 0xEB) against single-lane commands\n";
+    const uint32_t base_std  = 0x020000;
+    const uint32_t base_quad = 0x020100;
+    const size_t   n = FlashDriver::PAGE_SIZE;
+    std::vector<uint8_t> wr(n);
+    for (size_t i = 0; i < n; i++)
+        wr[i] = uint8_t(i * 13 + 0x5A);
+
+    check_bool("Page program (0x02) completed", drv.program(base_std, wr), true);
+    check_bool("Quad program (0x32) completed",
+               drv.quad_program(base_quad, wr.data(), n), true);
+
+    // Every read command on both pages must return the same data
+    const char* names[3] = {"0x0B", "0x6B", "0xEB"};
+    PhaseCycles ph[3];
+    for (int base_i = 0; base_i < 2; base_i++) {
+        uint32_t base = base_i ? base_quad : base_std;
+        for (int k = 0; k < 3; k++) {
+            std::vector<uint8_t> rd(n, 0);
+            PhaseCycles p;
+            drv.phases = &p;
+            if      (k == 0) drv.fast_read(base, rd.data(), n);
+            else if (k == 1) drv.quad_read(base, rd.data(), n);
+            else             drv.quad_io_read(base, rd.data(), n);
+            drv.phases = nullptr;
+            if (base_i == 0) ph[k] = p;
 
-        start_transfer(dut, tfp);
-        wait_status(dut, tfp);
-        check_bool("status_o high after WE", dut->status_o, true);
-        clear_status(dut, tfp);
-        tick(20, dut, tfp);
+            size_t bad = 0;
+            for (size_t i = 0; i < n; i++)
+                if (rd[i] != wr[i]) bad++;
+            check(std::string(names[k]) + " read of " +
+                  (base_i ? "0x32" : "0x02") + " page mismatches", bad, 0);
+        }
     }
 
-    // =========================================================================
-    // TEST 2: Write Disable (0x04) — no addr, no data
-    // =========================================================================
-    std::cout << "\n[TEST 2] Write Disable (0x04)\n";
-    {
-        default_inputs(dut);
-        dut->command_i   = 0x04;
-        dut->data_mode_i = 0b00;
-        dut->has_addr_i  = 0;
-        dut->rd_wr_i     = 0;
+    // Four lanes move a byte in a quarter of the SPI clocks
+    double rx_ratio   = double(ph[0].data_rx) / ph[1].data_rx;
+    double addr_ratio = double(ph[1].addr) / ph[2].addr;
+    std::cout << "  data_rx cycles 0x0B=" << std::dec << ph[0].data_rx
+              << " 0x6B=" << ph[1].data_rx << " ratio=" << rx_ratio << "\n";
+    std::cout << "  addr cycles    0x6B=" << ph[1].addr
+              << " 0xEB=" << ph[2].addr << " ratio=" << addr_ratio << "\n";
+    check_bool("Quad data phase ~4x faster", rx_ratio > 3.8 && rx_ratio < 4.2, true);
+    check_bool("Quad address phase ~4x faster", addr_ratio > 3.5 && addr_ratio < 4.5, true);
+    tick(20, dut, tfp);
+}
 
-        start_transfer(dut, tfp);
-        wait_status(dut, tfp);
-        check_bool("status_o high after WD", dut->status_o, true);
-        clear_status(dut, tfp);
-        tick(20, dut, tfp);
+// ============================================================================
+// TEST 17: Dual I/O — 0x3B / 0xBB bit ordering and cycles against 0x0B
+// ============================================================================
+void test_dual_io(Vspi_flash_top* dut, TbTrace* tfp, FlashDriver& drv) {
+    std::cout << "\n[TEST 17] Dual I/O (0x3B, 0xBB) against Fast Read (0x0B)\n";
+    // Walking ones/zeros first so a swapped IO0/IO1 or a lane shifted by
+    // one bit shows up directly, then a page of mixed data
+    const uint32_t base = 0x020200;
+    const size_t   n = FlashDriver::PAGE_SIZE;
+    std::vector<uint8_t> wr(n);
+    for (size_t i = 0; i < n; i++) {
+        if      (i < 8)  wr[i] = uint8_t(0x80 >> i);
+        else if (i < 16) wr[i] = uint8_t(~(0x80 >> (i - 8)));
+        else             wr[i] = uint8_t(i * 29 + 0x17);
     }
+    check_bool("Page program completed", drv.program(base, wr), true);
 
-    // =========================================================================
-    // TEST 3: Read JEDEC ID (0x9F) — no addr, read 3 bytes
-    // =========================================================================
-    std::cout << "\n[TEST 3] Read JEDEC ID (0x9F)\n";
-    {
-        default_inputs(dut);
-        dut->command_i   = 0x9F;
-        dut->data_mode_i = 0b01;   // std SPI data phase
-        dut->rd_wr_i     = 1;      // read
-        dut->has_addr_i  = 0;
-        dut->data_count_i= 2;      // 3 bytes (0=1byte, 2=3bytes), but data_len
-                                   // is in 32-bit words so request 4 bytes (1 word)
-        dut->data_count_i= 3;      // 4 bytes = 1 full 32-bit word from RX FIFO
-        dut->dummy_cycle_i = 0;
-
-        start_transfer(dut, tfp);
-        wait_status(dut, tfp);
-        tick(10, dut, tfp);
-        uint32_t id = pop_rx(dut, tfp);
-        // MFR_ID=0x20, DEVICE_ID=0xBA19, device_info[3]=0x10
-        // bytes come out MSB first packed into 32-bit word
-        std::cout << "  JEDEC ID word = 0x" << std::hex << id << "\n";
-        check_bool("JEDEC MFR byte = 0x20", ((id >> 24) & 0xFF) == 0x20, true);
+    const char* names[3] = {"0x0B", "0x3B", "0xBB"};
+    PhaseCycles ph[3];
+    for (int k = 0; k < 3; k++) {
+        std::vector<uint8_t> rd(n, 0);
+        drv.phases = &ph[k];
+        if      (k == 0) drv.fast_read(base, rd.data(), n);
+        else if (k == 1) drv.dual_read(base, rd.data(), n);
+        else             drv.dual_io_read(base, rd.data(), n);
+        drv.phases = nullptr;
 
-        clear_status(dut, tfp);
-        tick(20, dut, tfp);
+        check(std::string(names[k]) + " walking bits 0-3",  be32(&rd[0]),  0x80402010);
+        check(std::string(names[k]) + " walking bits 4-7",  be32(&rd[4]),  0x08040201);
+        check(std::string(names[k]) + " walking zeros 0-3", be32(&rd[8]),  0x7FBFDFEF);
+        check(std::string(names[k]) + " walking zeros 4-7", be32(&rd[12]), 0xF7FBFDFE);
+        size_t bad = 0;
+        for (size_t i = 0; i < n; i++)
+            if (rd[i] != wr[i]) bad++;
+        check(std::string(names[k]) + " page mismatches", bad, 0);
     }
 
-    // =========================================================================
-    // TEST 4: Read Status Register (0x05) — no addr, read 1 byte
-    // =========================================================================
-    std::cout << "\n[TEST 4] Read Status Register 1 (0x05)\n";
-    {
-        default_inputs(dut);
-        dut->command_i    = 0x05;
-        dut->data_mode_i  = 0b01;
-        dut->rd_wr_i      = 1;
-        dut->has_addr_i   = 0;
-        dut->data_count_i = 3;     // 4 bytes = 1 RX FIFO word
-        dut->dummy_cycle_i= 0;
-
-        start_transfer(dut, tfp);
-        wait_status(dut, tfp);
-        tick(10, dut, tfp);
-        uint32_t sr = pop_rx(dut, tfp);
-        std::cout << "  Status Reg word = 0x" << std::hex << sr << "\n";
-        // Flash model initialises status_reg_1 = 0x00
-        check("Status byte[31:24]", (sr >> 24) & 0xFF, 0x00);
+    double rx_ratio   = double(ph[0].data_rx) / ph[1].data_rx;
+    double addr_ratio = double(ph[1].addr) / ph[2].addr;
+    std::cout << "  data_rx cycles 0x0B=" << std::dec << ph[0].data_rx
+              << " 0x3B=" << ph[1].data_rx << " ratio=" << rx_ratio << "\n";
+    std::cout << "  addr cycles    0x3B=" << ph[1].addr
+              << " 0xBB=" << ph[2].addr << " ratio=" << addr_ratio << "\n";
+    check_bool("Dual data phase ~2x faster", rx_ratio > 1.9 && rx_ratio < 2.1, true);
+    check_bool("Dual address phase ~2x faster", addr_ratio > 1.8 && addr_ratio < 2.2, true);
+    tick(20, dut, tfp);
+}
+
+// ============================================================================
+// TEST 18: Long transfers across the sector boundary at 0x030000
+// ============================================================================
+void test_long_reads(Vspi_flash_top* dut, TbTrace* tfp, FlashDriver& drv) {
+    std::cout << "\n[TEST 18] Long reads: one 4 KB transaction and a continuous read\n";
+    const uint32_t base = 0x02F800;
+    const size_t   n = 4096;
+    std::vector<uint8_t> wr(n);
+    for (size_t i = 0; i < n; i++)
+        wr[i] = uint8_t((i >> 8) ^ (i * 3));
+    check_bool("4 KB program completed", drv.program(base, wr), true);
+
+    // One CS-low transaction, well past the old 256-byte limit
+    std::vector<uint8_t> rd(n, 0);
+    FlashCmd c;
+    c.opcode   = OP_FAST_READ;
+    c.read     = true;
+    c.has_addr = true;
+    c.addr     = base;
+    c.dummy    = FlashDriver::FAST_DUMMY;
+    check_bool("4 KB fast read in one transaction",
+               drv.transfer(c, nullptr, rd.data(), n), true);
+    size_t bad = 0;
+    for (size_t i = 0; i < n; i++)
+        if (rd[i] != wr[i]) bad++;
+    check("4 KB fast read mismatches", bad, 0);
+
+    // Continuous quad read, stopped by the driver; odd length so the
+    // tail is cut inside a word
+    const size_t m = n - 3;
+    std::vector<uint8_t> rs(m, 0);
+    FlashCmd q;
+    q.opcode    = OP_QUAD_READ;
+    q.data_mode = MODE_QUAD;
+    q.has_addr  = true;
+    q.dummy     = FlashDriver::FAST_DUMMY;
+    check_bool("Continuous quad read completed",
+               drv.stream_read(q, base, rs.data(), m), true);
+    bad = 0;
+    for (size_t i = 0; i < m; i++)
+        if (rs[i] != wr[i]) bad++;
+    check("Continuous quad read mismatches", bad, 0);
+    check_bool("RX FIFO empty after stop", dut->rx_fifo_empty_o, true);
+
+    // data_count 8191 does not fit spi_data_len: refused, not shortened
+    default_inputs(dut);
+    dut->command_i    = OP_READ;
+    dut->data_mode_i  = MODE_STD;
+    dut->rd_wr_i      = 1;
+    dut->has_addr_i   = 1;
+    dut->addr_i       = base;
+    dut->data_count_i = 0x1FFF;
+    start_transfer(dut, tfp);
+    tick(1, dut, tfp);
+    check_bool("8191 count sets status_o at once", dut->status_o, true);
+    check_bool("8191 count sets len_err_o", dut->len_err_o, true);
+    check_bool("8191 count never asserts CS", dut->busy_o, false);
+    clear_status(dut, tfp);
+    check_bool("len_err_o cleared with status", dut->len_err_o, false);
+
+    // ... and a queued one ends its chain, the descriptor stays queued
+    dut->desc_i       = 0x03ull | (0x1FFFull << 32) | (1ull << 45) | (1ull << 49)
+                      | (1ull << 50) | (1ull << 56);
+    dut->desc_valid_i = 1;
+    tick(1, dut, tfp);
+    dut->desc_valid_i = 0;
+    dut->seq_start_i  = 1;
+    tick(1, dut, tfp);
+    dut->seq_start_i  = 0;
+    wait_status(dut, tfp);
+    check_bool("Queued 8191 count sets len_err_o", dut->len_err_o, true);
+    check_bool("Queued 8191 count ends the chain", dut->seq_busy_o, false);
+    check_bool("Queued 8191 count never asserts CS", dut->busy_o, false);
+    dut->flush_tx_i = 1;
+    tick(1, dut, tfp);
+    dut->flush_tx_i = 0;
+    clear_status(dut, tfp);
+    dut->seq_start_i  = 1;
+    tick(1, dut, tfp);
+    dut->seq_start_i  = 0;
+    tick(1, dut, tfp);
+    check_bool("Refused descriptor flushed", dut->status_o && !dut->seq_busy_o, true);
+    clear_status(dut, tfp);
+    default_inputs(dut);
+    tick(20, dut, tfp);
+}
+
+// ============================================================================
+// TEST 19: FIFO watermarks and irq_o
+// ============================================================================
+void test_watermarks(Vspi_flash_top* dut, TbTrace* tfp, FlashDriver& drv) {
+    std::cout << "\n[TEST 19] FIFO almost-empty / almost-full watermarks\n";
+    default_inputs(dut);
+    dut->tx_ae_thresh_i = 2;
+    dut->rx_af_thresh_i = 6;
+    dut->irq_en_i       = 0b010;    // tx almost empty only
+    tick(1, dut, tfp);
+    check_bool("tx_almost_empty_o with empty TX FIFO", dut->tx_almost_empty_o, true);
+    check_bool("irq_o follows tx_almost_empty_o", dut->irq_o, true);
+
+    for (int i = 0; i < 3; i++)
+        push_tx(dut, tfp, 0x01010101 * i);
+    check_bool("tx_almost_empty_o low at 3 words", dut->tx_almost_empty_o, false);
+    check_bool("irq_o low at 3 words", dut->irq_o, false);
+
+    dut->flush_tx_i = 1;
+    tick(1, dut, tfp);
+    dut->flush_tx_i = 0;
+    tick(1, dut, tfp);
 
-        clear_status(dut, tfp);
-        tick(20, dut, tfp);
+    // 32-byte read with nobody draining: RX fills to 8 words
+    dut->irq_en_i     = 0b001;      // rx almost full only
+    dut->command_i    = OP_FAST_READ;
+    dut->data_mode_i  = MODE_STD;
+    dut->rd_wr_i      = 1;
+    dut->has_addr_i   = 1;
+    dut->addr_i       = 0x020000;   // TEST 16 data
+    dut->dummy_cycle_i= FlashDriver::FAST_DUMMY;
+    dut->data_count_i = 31;
+    check_bool("rx_almost_full_o low before read", dut->rx_almost_full_o, false);
+    start_transfer(dut, tfp);
+    wait_status(dut, tfp);
+    tick(2, dut, tfp);
+    check_bool("rx_almost_full_o at 8 words", dut->rx_almost_full_o, true);
+    check_bool("irq_o follows rx_almost_full_o", dut->irq_o, true);
+
+    uint32_t first = pop_rx(dut, tfp);
+    check("First RX word", first, 0x5A677481);
+    for (int i = 1; i < 8; i++)
+        pop_rx(dut, tfp);
+    check_bool("rx_almost_full_o low after drain", dut->rx_almost_full_o, false);
+    check_bool("irq_o low after drain", dut->irq_o, false);
+    clear_status(dut, tfp);
+    default_inputs(dut);
+    tick(10, dut, tfp);
+}
+
+// ============================================================================
+// TEST 20: Command queue — program two pages and read them back in one chain
+// ============================================================================
+void test_cmd_queue(Vspi_flash_top* dut, TbTrace* tfp, FlashDriver& drv) {
+    std::cout << "\n[TEST 20] Command queue: WREN/PP/WREN/PP/READ/READ as one chain\n";
+    default_inputs(dut);
+    tick(2, dut, tfp);
+
+    uint8_t data_a[38], data_b[16];
+    for (int i = 0; i < 38; i++) data_a[i] = uint8_t(0xC0 + i);
+    for (int i = 0; i < 16; i++) data_b[i] = uint8_t(0x3F - i);
+
+    std::vector<FlashDesc> chain(6);
+    chain[0].cmd.opcode    = OP_WRITE_ENABLE;
+    chain[0].cmd.data_mode = MODE_NONE;
+    chain[1].cmd.opcode    = OP_PAGE_PROGRAM;
+    chain[1].cmd.has_addr  = true;
+    chain[1].cmd.addr      = 0x034000;
+    chain[1].len           = sizeof(data_a);
+    chain[2]               = chain[0];
+    chain[3]               = chain[1];
+    chain[3].cmd.addr      = 0x034100;
+    chain[3].len           = sizeof(data_b);
+    chain[4].cmd.opcode    = OP_FAST_READ;
+    chain[4].cmd.read      = true;
+    chain[4].cmd.has_addr  = true;
+    chain[4].cmd.dummy     = FlashDriver::FAST_DUMMY;
+    chain[4].cmd.addr      = 0x034000;
+    chain[4].len           = sizeof(data_a);
+    chain[5]               = chain[4];
+    chain[5].cmd.addr      = 0x034100;
+    chain[5].len           = sizeof(data_b);
+
+    uint8_t tx[sizeof(data_a) + sizeof(data_b)];
+    uint8_t rx[sizeof(data_a) + sizeof(data_b)];
+    std::memcpy(tx, data_a, sizeof(data_a));
+    std::memcpy(tx + sizeof(data_a), data_b, sizeof(data_b));
+    std::memset(rx, 0, sizeof(rx));
+
+    bool ok = drv.run_chain(chain, tx, rx);
+    check_bool("Chain completed with one status", ok, true);
+    check_bool("Read back matches both pages",
+               std::memcmp(tx, rx, sizeof(tx)) == 0, true);
+    std::cout << "  CS high between commands: " << std::dec
+              << drv.last_cs_high << " cycles over 5 gaps\n";
+    check_bool("CS gap at most 2 cycles per command", drv.last_cs_high <= 10, true);
+    check_bool("Queue idle after chain", dut->seq_busy_o, false);
+
+    // seq_start_i on the empty queue finishes at once
+    dut->seq_start_i = 1;
+    tick(1, dut, tfp);
+    dut->seq_start_i = 0;
+    tick(1, dut, tfp);
+    check_bool("Empty chain sets status_o", dut->status_o, true);
+    check_bool("Empty chain leaves the queue idle", dut->seq_busy_o, false);
+    clear_status(dut, tfp);
+
+    // Only DESC_LAST ends a chain: a queue that runs dry waits for more
+    const uint64_t jedec = 0x9Full | (3ull << 32) | (1ull << 45) | (1ull << 49);
+    dut->desc_i       = jedec;
+    dut->desc_valid_i = 1;
+    tick(1, dut, tfp);
+    dut->desc_valid_i = 0;
+    dut->seq_start_i  = 1;
+    tick(1, dut, tfp);
+    dut->seq_start_i  = 0;
+    uint32_t id0 = pop_rx(dut, tfp);
+    tick(200, dut, tfp);
+    check_bool("Underrun keeps the chain running", dut->seq_busy_o, true);
+    check_bool("No status before DESC_LAST", dut->status_o, false);
+    dut->desc_i       = jedec | (1ull << 56);
+    dut->desc_valid_i = 1;
+    tick(1, dut, tfp);
+    dut->desc_valid_i = 0;
+    check("Refilled command data", pop_rx(dut, tfp), id0);
+    wait_status(dut, tfp);
+    check_bool("Chain ends on DESC_LAST", dut->seq_busy_o, false);
+    clear_status(dut, tfp);
+
+    // flush_tx_i ends a chain waiting for descriptors
+    dut->desc_i       = jedec;
+    dut->desc_valid_i = 1;
+    tick(1, dut, tfp);
+    dut->desc_valid_i = 0;
+    dut->seq_start_i  = 1;
+    tick(1, dut, tfp);
+    dut->seq_start_i  = 0;
+    pop_rx(dut, tfp);
+    tick(200, dut, tfp);
+    dut->flush_tx_i = 1;
+    tick(1, dut, tfp);
+    dut->flush_tx_i = 0;
+    wait_status(dut, tfp);
+    check_bool("Flush ends an underrun chain", dut->seq_busy_o, false);
+    clear_status(dut, tfp);
+
+    default_inputs(dut);
+    tick(10, dut, tfp);
+}
+
+// ============================================================================
+// TEST 21: Status auto-poll — match, timeout, and WIP polls inside a chain
+// ============================================================================
+void test_auto_poll(Vspi_flash_top* dut, TbTrace* tfp, FlashDriver& drv) {
+    std::cout << "\n[TEST 21] Status auto-poll (0x05)\n";
+    default_inputs(dut);
+    tick(2, dut, tfp);
+
+    bool ok = drv.wait_ready();
+    check_bool("WIP clear matches", ok, true);
+    check("Reads until match", uint32_t(drv.last_poll_count), 1);
+    check_bool("No status word left in the RX FIFO", dut->rx_fifo_empty_o, true);
+
+    // WIP never sets here: 5 reads 16 cycles apart, then timeout
+    uint64_t t0 = drv.ticks;
+    ok = drv.poll(OP_READ_STATUS, FlashDriver::SR_WIP, FlashDriver::SR_WIP, 16, 5);
+    uint64_t t = drv.ticks - t0;
+    check_bool("WIP set times out", ok, false);
+    check("Reads until timeout", uint32_t(drv.last_poll_count), 5);
+    check_bool("Interval kept between reads", t >= 4 * 16, true);
+    check_bool("poll_timeout_o cleared with status", dut->poll_timeout_o, false);
+
+    // DESC_POLL after every page program of a queued 3-page program
+    std::vector<uint8_t> pages(3 * FlashDriver::PAGE_SIZE);
+    for (size_t i = 0; i < pages.size(); i++)
+        pages[i] = uint8_t(i * 13 + 1);
+    FlashCmd pp;
+    pp.opcode   = OP_PAGE_PROGRAM;
+    pp.has_addr = true;
+    ok = drv.queue_program(pp, 0x035000, pages.data(), pages.size());
+    check_bool("Queued program with WIP polls", ok, true);
+    std::vector<uint8_t> back = drv.fast_read(0x035000, pages.size());
+    check_bool("Read back matches", back == pages, true);
+    default_inputs(dut);
+    tick(10, dut, tfp);
+}
+
+// ============================================================================
+// TEST 22: Sparse store — backdoor access and chip erase (0xC7)
+// ============================================================================
+void test_chip_erase(Vspi_flash_top* dut, TbTrace* tfp, FlashDriver& drv) {
+    std::cout << "\n[TEST 22] Flash store backdoor and Chip Erase (0xC7)\n";
+    FlashMem* mem = FlashMem::find();
+    check_bool("Store found", mem != nullptr, true);
+    check("Bus program visible in the store", mem->read(0x035000), 0x01);
+
+    std::vector<uint8_t> img(64);
+    for (size_t i = 0; i < img.size(); i++) {
+        img[i] = uint8_t(0xC0 ^ i);
+        mem->write(0x036000 + uint32_t(i), img[i]);
     }
+    check_bool("Backdoor write visible on the bus",
+               drv.fast_read(0x036000, img.size()) == img, true);
 
-    // =========================================================================
-    // TEST 5: Read Flag Status Register (0x70) — no addr, read 1 byte
-    // =========================================================================
-    std::cout << "\n[TEST 5] Read Flag Status Register (0x70)\n";
-    {
-        default_inputs(dut);
-        dut->command_i    = 0x70;
-        dut->data_mode_i  = 0b01;
-        dut->rd_wr_i      = 1;
-        dut->has_addr_i   = 0;
-        dut->data_count_i = 3;
-        dut->dummy_cycle_i= 0;
-
-        start_transfer(dut, tfp);
-        wait_status(dut, tfp);
-        tick(10, dut, tfp);
-        uint32_t fsr = pop_rx(dut, tfp);
-        std::cout << "  Flag Status Reg word = 0x" << std::hex << fsr << "\n";
-        check("Flag Status byte[31:24]", (fsr >> 24) & 0xFF, 0x00);
+    bool ok = drv.erase_chip();
+    check_bool("Chip erase", ok, true);
+    check("Pages left", uint32_t(mem->pages()), 0);
+    std::vector<uint8_t> blank(img.size(), 0xFF);
+    check_bool("0x035000 erased", drv.fast_read(0x035000, blank.size()) == blank, true);
+    check_bool("0x036000 erased", drv.fast_read(0x036000, blank.size()) == blank, true);
 
-        clear_status(dut, tfp);
-        tick(20, dut, tfp);
+    // a page written after the erase starts from 0xFF again
+    mem->write(0x036010, 0x00);
+    check("Rewritten page, written byte", mem->read(0x036010), 0x00);
+    check("Rewritten page, old byte", mem->read(0x036000), 0xFF);
+    default_inputs(dut);
+    tick(10, dut, tfp);
+}
+
+// ============================================================================
+// TEST 23: Mapped image file, program on top of it, whole and diff dumps
+// ============================================================================
+void test_image_dump(Vspi_flash_top* dut, TbTrace* tfp, FlashDriver& drv) {
+    std::cout << "\n[TEST 23] Image file at 0x038000, full and diff dumps\n";
+    FlashMem* mem = FlashMem::find();
+    std::vector<uint8_t> img(0x2000);
+    for (size_t i = 0; i < img.size(); i++)
+        img[i] = uint8_t(i * 31 + (i >> 8));
+    std::ofstream("tb_image.bin", std::ios::binary)
+        .write(reinterpret_cast<const char*>(img.data()), img.size());
+
+    check("Bytes mapped", uint32_t(mem->map_image("tb_image.bin", 0x038000)), 0x2000);
+    check("Image pages copied", uint32_t(mem->pages()), 1);   // 0x036000 from TEST 22
+    check_bool("Image on the bus",
+               drv.fast_read(0x038000, img.size()) == img, true);
+
+    // programming only copies out the page it lands in
+    std::vector<uint8_t> patch(16, 0x00);
+    bool ok = drv.program(0x039100, patch);
+    check_bool("Program over the image", ok, true);
+    std::vector<uint8_t> expect = img;
+    std::copy(patch.begin(), patch.end(), expect.begin() + 0x1100);
+    check_bool("Image with patch on the bus",
+               drv.fast_read(0x038000, expect.size()) == expect, true);
+
+    check_bool("Full dump", mem->dump("tb_dump.bin", false), true);
+    std::ifstream full("tb_dump.bin", std::ios::binary);
+    std::vector<uint8_t> all((std::istreambuf_iterator<char>(full)),
+                             std::istreambuf_iterator<char>());
+    check("Full dump size", uint32_t(all.size()), 0x03A000);
+    check_bool("Full dump contents",
+               std::equal(expect.begin(), expect.end(), all.begin() + 0x038000), true);
+
+    // 0x036000 (TEST 22) and the patched image page
+    check_bool("Diff dump", mem->dump("tb_dump.diff", true), true);
+    std::ifstream df("tb_dump.diff", std::ios::binary);
+    std::vector<uint8_t> diff((std::istreambuf_iterator<char>(df)),
+                              std::istreambuf_iterator<char>());
+    check("Diff dump size", uint32_t(diff.size()), 8 + 2 * (8 + 4096));
+    uint32_t rec2 = 8 + 8 + 4096;
+    check("Second record address",
+          diff.size() >= rec2 + 8 ? uint32_t(diff[rec2]) | (uint32_t(diff[rec2 + 1]) << 8) |
+                                    (uint32_t(diff[rec2 + 2]) << 16)
+                                  : 0,
+          0x039000);
+
+    // the file goes away below: keep its bytes, so a checkpoint after this
+    // test does not need it
+    mem->detach_image();
+    check_bool("Image kept after detach",
+               drv.fast_read(0x038000, expect.size()) == expect, true);
+    std::remove("tb_image.bin");
+    std::remove("tb_dump.bin");
+    std::remove("tb_dump.diff");
+    default_inputs(dut);
+    tick(10, dut, tfp);
+}
+
+// ============================================================================
+// TEST 24: DTR reads — 0x0D / 0xBD / 0xED against their SDR counterparts
+// ============================================================================
+void test_dtr(Vspi_flash_top* dut, TbTrace* tfp, FlashDriver& drv) {
+    std::cout << "\n[TEST 24] DTR reads (0x0D, 0xBD, 0xED) against 0x0B, 0xBB, 0xEB\n";
+    // Walking ones/zeros: a beat taken on the wrong edge shifts them by a lane
+    const uint32_t base = 0x020400;
+    const size_t   n = FlashDriver::PAGE_SIZE;
+    std::vector<uint8_t> wr(n);
+    for (size_t i = 0; i < n; i++) {
+        if      (i < 8)  wr[i] = uint8_t(0x80 >> i);
+        else if (i < 16) wr[i] = uint8_t(~(0x80 >> (i - 8)));
+        else             wr[i] = uint8_t(i * 41 + 0x2B);
     }
+    check_bool("Page program completed", drv.program(base, wr), true);
 
-    // =========================================================================
-    // TEST 6: Write Enable then Page Program (0x02) at address 0x000000
-    // =========================================================================
-    std::cout << "\n[TEST 6] Page Program (0x02) — write 4 bytes to 0x000000\n";
-    {
-        // Step 1: Write Enable first
-        default_inputs(dut);
-        dut->command_i   = 0x06;
-        dut->data_mode_i = 0b00;
-        dut->has_addr_i  = 0;
-        dut->rd_wr_i     = 0;
-        start_transfer(dut, tfp);
-        wait_status(dut, tfp);
-        clear_status(dut, tfp);
-        tick(10, dut, tfp);
+    const char* names[6] = {"0x0B", "0x0D", "0xBB", "0xBD", "0xEB", "0xED"};
+    PhaseCycles ph[6];
+    for (int k = 0; k < 6; k++) {
+        std::vector<uint8_t> rd(n, 0);
+        drv.phases = &ph[k];
+        switch (k) {
+            case 0: drv.fast_read(base, rd.data(), n); break;
+            case 1: drv.dtr_read(base, rd.data(), n); break;
+            case 2: drv.dual_io_read(base, rd.data(), n); break;
+            case 3: drv.dtr_dual_io_read(base, rd.data(), n); break;
+            case 4: drv.quad_io_read(base, rd.data(), n); break;
+            case 5: drv.dtr_quad_io_read(base, rd.data(), n); break;
+        }
+        drv.phases = nullptr;
 
-        // Step 2: Page Program
-        default_inputs(dut);
-        dut->command_i    = 0x02;
-        dut->data_mode_i  = 0b01;  // std SPI
-        dut->rd_wr_i      = 0;     // write
-        dut->has_addr_i   = 1;
-        dut->addr_i       = 0x000000;
-        dut->data_count_i = 3;     // 4 bytes
-        dut->dummy_cycle_i= 0;
+        check(std::string(names[k]) + " walking bits 0-3",  be32(&rd[0]),  0x80402010);
+        check(std::string(names[k]) + " walking zeros 4-7", be32(&rd[12]), 0xF7FBFDFE);
+        size_t bad = 0;
+        for (size_t i = 0; i < n; i++)
+            if (rd[i] != wr[i]) bad++;
+        check(std::string(names[k]) + " page mismatches", bad, 0);
+    }
 
-        // Pre-load TX FIFO with 0xDEADBEEF
-        push_tx(dut, tfp, 0xDEADBEEF);
+    // Same SPI clock: two beats per clock halve the address and data phases
+    for (int k = 0; k < 6; k += 2) {
+        double rx_ratio   = double(ph[k].data_rx) / ph[k + 1].data_rx;
+        double addr_ratio = double(ph[k].addr) / ph[k + 1].addr;
+        std::cout << "  " << names[k] << "/" << names[k + 1] << " data_rx cycles "
+                  << std::dec << ph[k].data_rx << "/" << ph[k + 1].data_rx
+                  << " ratio=" << rx_ratio << ", addr cycles " << ph[k].addr
+                  << "/" << ph[k + 1].addr << " ratio=" << addr_ratio << "\n";
+        check_bool(std::string(names[k + 1]) + " data phase ~2x faster",
+                   rx_ratio > 1.9 && rx_ratio < 2.1, true);
+        check_bool(std::string(names[k + 1]) + " address phase faster", addr_ratio > 1.7, true);
+    }
 
-        start_transfer(dut, tfp);
-        wait_status(dut, tfp);
-        check_bool("Page program completed", dut->status_o, true);
+    // Divider 0: the data phase runs at clk/2 per edge, the address phase
+    // at divider 1 (no system clock between the edges to change the data)
+    int prescaler = drv.prescaler;
+    drv.prescaler = 0;
+    PhaseCycles sdr0, dtr0;
+    std::vector<uint8_t> rd(n, 0);
+    drv.phases = &sdr0;
+    drv.quad_io_read(base, rd.data(), n);
+    drv.phases = &dtr0;
+    rd.assign(n, 0);
+    drv.dtr_quad_io_read(base, rd.data(), n);
+    drv.phases = nullptr;
+    check_bool("0xED at prescaler 0", rd == wr, true);
+    double rx0 = double(sdr0.data_rx) / dtr0.data_rx;
+    std::cout << "  prescaler 0: 0xEB/0xED data_rx cycles " << sdr0.data_rx << "/"
+              << dtr0.data_rx << " ratio=" << rx0 << "\n";
+    check_bool("0xED data phase ~2x faster at prescaler 0", rx0 > 1.9 && rx0 < 2.1, true);
+    drv.prescaler = prescaler;
 
-        clear_status(dut, tfp);
-        tick(20, dut, tfp);
+    // Mode bits of 0xED on both edges of one clock: 0xA0 keeps the flash in
+    // continuous read, so the next reads send no opcode
+    const uint32_t offs[3] = {0x00, 0x9C, 0xF0};
+    const size_t   len = 16;
+    PhaseCycles pe[3], pb;
+    for (int k = 0; k < 3; k++) {
+        rd.assign(len, 0);
+        drv.phases = &pe[k];
+        drv.dtr_quad_io_read_cont(base + offs[k], rd.data(), len, k < 2);
+        drv.phases = nullptr;
+        check_bool("0xED with mode bits, read " + std::to_string(k),
+                   std::equal(rd.begin(), rd.end(), wr.begin() + offs[k]), true);
     }
+    check_bool("0xED sends the opcode first", pe[0].cmd > 0, true);
+    check("0xED continuous read sends no opcode", pe[1].cmd + pe[2].cmd, 0);
+    check_bool("Driver left continuous read after 0xED", drv.cont_read, false);
+    drv.phases = &pb;
+    drv.quad_io_read_cont(base, rd.data(), len, false);
+    drv.phases = nullptr;
+    std::cout << "  0xEB/0xED mode cycles " << pb.mode << "/" << pe[0].mode << "\n";
+    check_bool("0xED mode bits ~2x faster", double(pb.mode) / pe[0].mode > 1.7, true);
+    check_bool("0x0B after 0xED mode bits 0x00", drv.fast_read(base, n) == wr, true);
 
-    // =========================================================================
-    // TEST 7: Read back what was written — Fast Read (0x0B) with 8 dummy cycles
-    // =========================================================================
-    std::cout << "\n[TEST 7] Fast Read (0x0B) — read 4 bytes from 0x000000\n";
-    {
-        default_inputs(dut);
-        dut->command_i    = 0x0B;
-        dut->data_mode_i  = 0b01;
-        dut->rd_wr_i      = 1;
-        dut->has_addr_i   = 1;
-        dut->addr_i       = 0x000000;
-        dut->data_count_i = 3;     // 4 bytes
-        dut->dummy_cycle_i= 8;
-
-        start_transfer(dut, tfp);
-        wait_status(dut, tfp);
-        tick(10, dut, tfp);
-        uint32_t rd = pop_rx(dut, tfp);
-        std::cout << "  Read back = 0x" << std::hex << rd << "\n";
-        check("Fast Read data matches written", rd, 0xDEADBEEF);
+    // Mode bit reset out of 0xED continuous read
+    drv.dtr_quad_io_read_cont(base, rd.data(), len);
+    check_bool("0xED mode bit reset completed", drv.exit_cont_read(), true);
+    check("JEDEC ID after 0xED mode bit reset", drv.read_jedec(), 0x20BA19);
+
+    // DTR flag of a queued descriptor
+    FlashDesc d;
+    d.cmd.opcode    = OP_DTR_QUAD_IO_READ;
+    d.cmd.data_mode = MODE_QUAD;
+    d.cmd.addr_mode = MODE_QUAD;
+    d.cmd.read      = true;
+    d.cmd.has_addr  = true;
+    d.cmd.addr      = base;
+    d.cmd.dummy     = FlashDriver::DTR_QUAD_IO_DUMMY;
+    d.cmd.dtr       = true;
+    d.len           = n;
+    rd.assign(n, 0);
+    check_bool("Queued 0xED completed", drv.run_chain({d}, nullptr, rd.data()), true);
+    check_bool("Queued 0xED data", rd == wr, true);
+    tick(20, dut, tfp);
+}
 
-        clear_status(dut, tfp);
-        tick(20, dut, tfp);
+// ============================================================================
+// TEST 25: 4-byte addresses — dedicated opcodes and Enter/Exit 4-byte mode
+// ============================================================================
+void test_four_byte(Vspi_flash_top* dut, TbTrace* tfp, FlashDriver& drv) {
+    std::cout << "\n[TEST 25] 4-byte addressing above 16 MB (0x13, 0x0C, 0xEC, 0x12, 0xDC, 0xB7/0xE9)\n";
+    // hi and lo share their low 24 bits: a dropped address byte shows up as
+    // the other page's data
+    const uint32_t hi = 0x02345600;
+    const uint32_t lo = hi & 0xFFFFFF;
+    const size_t   n  = 64;
+    std::vector<uint8_t> wr_hi(n), wr_lo(n);
+    for (size_t i = 0; i < n; i++) {
+        wr_hi[i] = uint8_t(i * 7 + 0x21);
+        wr_lo[i] = uint8_t(i * 11 + 0x90);
     }
 
-    // =========================================================================
-    // TEST 8: Normal Read (0x03) — no dummy cycles, different address
-    // =========================================================================
-    std::cout << "\n[TEST 8] Normal Read (0x03) — read 4 bytes from 0x000004\n";
-    {
-        // First write something at 0x000004
-        default_inputs(dut);
-        dut->command_i   = 0x06;
-        dut->data_mode_i = 0b00;
-        dut->has_addr_i  = 0;
-        dut->rd_wr_i     = 0;
-        start_transfer(dut, tfp);
-        wait_status(dut, tfp);
-        clear_status(dut, tfp);
-        tick(10, dut, tfp);
+    check_bool("4-byte program (0x12) completed", drv.program_4b(hi, wr_hi.data(), n), true);
+    check_bool("3-byte program (0x02) completed", drv.program(lo, wr_lo), true);
+    FlashMem* mem = FlashMem::find();
+    check("Store at the 4-byte address", mem->read(hi), wr_hi[0]);
+    check("Store at the 3-byte address", mem->read(lo), wr_lo[0]);
 
-        default_inputs(dut);
-        dut->command_i    = 0x02;
-        dut->data_mode_i  = 0b01;
-        dut->rd_wr_i      = 0;
-        dut->has_addr_i   = 1;
-        dut->addr_i       = 0x000004;
-        dut->data_count_i = 3;
-        push_tx(dut, tfp, 0xCAFEBABE);
-        start_transfer(dut, tfp);
-        wait_status(dut, tfp);
-        clear_status(dut, tfp);
-        tick(10, dut, tfp);
+    std::vector<uint8_t> rd(n);
+    const char* names[3] = {"0x13", "0x0C", "0xEC"};
+    for (int k = 0; k < 3; k++) {
+        rd.assign(n, 0);
+        if      (k == 0) drv.read_4b(hi, rd.data(), n);
+        else if (k == 1) drv.fast_read_4b(hi, rd.data(), n);
+        else             drv.quad_io_read_4b(hi, rd.data(), n);
+        check_bool(std::string(names[k]) + " read above 16 MB", rd == wr_hi, true);
+    }
+    check_bool("0x0B still reads 3-byte addresses", drv.fast_read(lo, n) == wr_lo, true);
 
-        // Now read it back with normal read
-        default_inputs(dut);
-        dut->command_i    = 0x03;
-        dut->data_mode_i  = 0b01;
-        dut->rd_wr_i      = 1;
-        dut->has_addr_i   = 1;
-        dut->addr_i       = 0x000004;
-        dut->data_count_i = 3;
-        dut->dummy_cycle_i= 0;
-
-        start_transfer(dut, tfp);
-        wait_status(dut, tfp);
-        tick(10, dut, tfp);
-        uint32_t rd = pop_rx(dut, tfp);
-        std::cout << "  Read back = 0x" << std::hex << rd << "\n";
-        check("Normal Read data matches written", rd, 0xCAFEBABE);
+    // Enter 4-byte mode: the 3-byte opcodes take 32-bit addresses
+    check_bool("Enter 4-byte mode (0xB7)", drv.enter_4b_mode(), true);
+    check("Flag status addressing bit", drv.read_flag_status() & 0x01, 0x01);
+    check_bool("0x0B in 4-byte mode", drv.fast_read(hi, n) == wr_hi, true);
+    rd.assign(n, 0);
+    drv.quad_io_read(hi, rd.data(), n);
+    check_bool("0xEB in 4-byte mode", rd == wr_hi, true);
+    std::vector<uint8_t> patch(8, 0x00);
+    check_bool("0x02 in 4-byte mode", drv.program(hi + 8, patch), true);
+    std::vector<uint8_t> exp_hi = wr_hi;
+    std::fill(exp_hi.begin() + 8, exp_hi.begin() + 16, 0x00);
+    check_bool("0x02 landed above 16 MB", drv.fast_read(hi, n) == exp_hi, true);
+
+    // Queued 4-byte command: the descriptor carries address bits 27:24
+    FlashDesc d;
+    d.cmd.opcode   = OP_FAST_READ;
+    d.cmd.read     = true;
+    d.cmd.has_addr = true;
+    d.cmd.addr     = hi;
+    d.cmd.dummy    = FlashDriver::FAST_DUMMY;
+    d.len          = n;
+    rd.assign(n, 0);
+    check_bool("Queued 0x0B in 4-byte mode", drv.run_chain({d}, nullptr, rd.data()), true);
+    check_bool("Queued read data", rd == exp_hi, true);
 
-        clear_status(dut, tfp);
-        tick(20, dut, tfp);
+    check_bool("Exit 4-byte mode (0xE9)", drv.exit_4b_mode(), true);
+    check("Flag status addressing bit cleared", drv.read_flag_status() & 0x01, 0x00);
+    check_bool("0x0B back on 3-byte addresses", drv.fast_read(lo, n) == wr_lo, true);
+
+    // 4-byte sector erase leaves the page at the 3-byte alias alone
+    check_bool("Sector erase (0xDC) completed", drv.erase_sector_4b(hi), true);
+    rd.assign(n, 0);
+    drv.fast_read_4b(hi, rd.data(), n);
+    check_bool("Erased above 16 MB", rd == std::vector<uint8_t>(n, 0xFF), true);
+    check_bool("3-byte page intact", drv.fast_read(lo, n) == wr_lo, true);
+    tick(20, dut, tfp);
+}
+
+// ============================================================================
+// TEST 26: Continuous read — 0xEB with mode bits 0xA0, then no opcode
+// ============================================================================
+void test_cont_read(Vspi_flash_top* dut, TbTrace* tfp, FlashDriver& drv) {
+    std::cout << "\n[TEST 26] Continuous read (0xEB, mode bits 0xA0) and mode bit reset\n";
+    const uint32_t base = 0x020800;
+    const size_t   n    = FlashDriver::PAGE_SIZE;
+    std::vector<uint8_t> wr(n);
+    for (size_t i = 0; i < n; i++)
+        wr[i] = uint8_t(i * 29 + 0x5C);
+    check_bool("Page program completed", drv.program(base, wr), true);
+
+    // Short reads at scattered offsets: the first one sends 0xEB, the others
+    // only address, mode bits, dummy and data
+    const uint32_t offs[4] = {0x00, 0x9C, 0x14, 0xF0};
+    const size_t   len = 16;
+    PhaseCycles ph[4];
+    uint64_t    cyc[4];
+    for (int k = 0; k < 4; k++) {
+        std::vector<uint8_t> rd(len, 0);
+        drv.phases = &ph[k];
+        drv.quad_io_read_cont(base + offs[k], rd.data(), len);
+        drv.phases = nullptr;
+        cyc[k] = drv.last_cycles;
+        std::string name = "Continuous read " + std::to_string(k);
+        check_bool(name + " data", std::equal(rd.begin(), rd.end(), wr.begin() + offs[k]), true);
+        check_bool(name + " sends mode bits", ph[k].mode > 0, true);
     }
+    check_bool("First read sends the opcode", ph[0].cmd > 0, true);
+    check("Later reads send no opcode", ph[1].cmd + ph[2].cmd + ph[3].cmd, 0);
+    std::cout << "  cycles per read: " << std::dec << cyc[0] << " with opcode, " << cyc[1]
+              << " without\n";
+    check_bool("Opcode clocks saved", cyc[0] >= cyc[1] + 14 * uint64_t(drv.prescaler + 1), true);
 
-    // =========================================================================
-    // TEST 9: Sector Erase (0xD8) then verify erased (0xFF)
-    // =========================================================================
-    std::cout << "\n[TEST 9] Sector Erase (0xD8) at 0x000000, then verify\n";
-    {
-        // Write Enable
-        default_inputs(dut);
-        dut->command_i   = 0x06;
-        dut->data_mode_i = 0b00;
-        dut->has_addr_i  = 0;
-        dut->rd_wr_i     = 0;
-        start_transfer(dut, tfp);
-        wait_status(dut, tfp);
-        clear_status(dut, tfp);
-        tick(10, dut, tfp);
+    // Mode bits 0x00 on the last read: the flash takes opcodes again
+    std::vector<uint8_t> rd(len, 0);
+    drv.quad_io_read_cont(base + 0x40, rd.data(), len, false);
+    check_bool("Leaving read data", std::equal(rd.begin(), rd.end(), wr.begin() + 0x40), true);
+    check_bool("Driver left continuous read", drv.cont_read, false);
+    check_bool("0x0B after mode bits 0x00", drv.fast_read(base, n) == wr, true);
 
-        // Sector Erase
-        default_inputs(dut);
-        dut->command_i   = 0xD8;
-        dut->data_mode_i = 0b00;  // no data phase, just cmd+addr
-        dut->has_addr_i  = 1;
-        dut->addr_i      = 0x000000;
-        dut->rd_wr_i     = 0;
-
-        start_transfer(dut, tfp);
-        wait_status(dut, tfp);
-        check_bool("Erase completed", dut->status_o, true);
-        clear_status(dut, tfp);
-        tick(20, dut, tfp);
-
-        // Read back — should be 0xFFFFFFFF
-        default_inputs(dut);
-        dut->command_i    = 0x03;
-        dut->data_mode_i  = 0b01;
-        dut->rd_wr_i      = 1;
-        dut->has_addr_i   = 1;
-        dut->addr_i       = 0x000000;
-        dut->data_count_i = 3;
-        dut->dummy_cycle_i= 0;
-
-        start_transfer(dut, tfp);
-        wait_status(dut, tfp);
-        tick(10, dut, tfp);
-        uint32_t rd = pop_rx(dut, tfp);
-        std::cout << "  Post-erase read = 0x" << std::hex << rd << "\n";
-        check("Erased region reads 0xFFFFFFFF", rd, 0xFFFFFFFF);
+    // A plain 0xEB sends zeros through the mode bits and stays out of it
+    rd.assign(len, 0);
+    drv.quad_io_read(base + 0x20, rd.data(), len);
+    check_bool("0x0B after plain 0xEB", drv.fast_read(base, n) == wr, true);
+
+    // Mode bit reset
+    rd.assign(len, 0);
+    drv.quad_io_read_cont(base + 0x80, rd.data(), len);
+    check_bool("Re-entered continuous read", drv.cont_read, true);
+    check_bool("Mode bit reset (0xFF) completed", drv.exit_cont_read(), true);
+    check("JEDEC ID after mode bit reset", drv.read_jedec(), 0x20BA19);
+    check_bool("Mode bit reset outside continuous read", drv.exit_cont_read(), true);
+    check_bool("0x0B after the second reset", drv.fast_read(base, n) == wr, true);
+
+    // Divider 0, through the whole page
+    int prescaler = drv.prescaler;
+    drv.prescaler = 0;
+    rd.assign(n, 0);
+    drv.quad_io_read_cont(base, rd.data(), n);
+    rd.assign(n, 0);
+    drv.quad_io_read_cont(base, rd.data(), n, false);
+    check_bool("Continuous read at prescaler 0", rd == wr, true);
+    drv.prescaler = prescaler;
+    tick(20, dut, tfp);
+}
+
+// ============================================================================
+// TEST 27: Two flashes — separate contents, one chain across both chip selects
+// ============================================================================
+void test_multi_cs(Vspi_flash_top* dut, TbTrace* tfp, FlashDriver& drv) {
+    std::cout << "\n[TEST 27] Two devices on spi_csn0 / spi_csn1\n";
+    default_inputs(dut);
+    tick(2, dut, tfp);
 
-        clear_status(dut, tfp);
-        tick(20, dut, tfp);
+    FlashDriver drv1(dut, tfp, sim_time);
+    drv1.cs = 1;
+    check("JEDEC ID of device 0", drv.read_jedec(), 0x20BA19);
+    check("JEDEC ID of device 1", drv1.read_jedec(), 0x20BA1A);
+
+    // The same address on both, different data
+    const uint32_t base = 0x020A00;
+    const size_t   n    = 64;
+    std::vector<uint8_t> wr0(n), wr1(n);
+    for (size_t i = 0; i < n; i++) {
+        wr0[i] = uint8_t(i * 7 + 0x11);
+        wr1[i] = uint8_t(i * 11 + 0x82);
     }
+    check_bool("Program device 0", drv.program(base, wr0), true);
+    check_bool("Program device 1", drv1.program(base, wr1), true);
+    check_bool("WIP poll on device 1", drv1.wait_ready(), true);
+    check_bool("Device 0 data", drv.fast_read(base, n) == wr0, true);
+    check_bool("Device 1 data", drv1.fast_read(base, n) == wr1, true);
 
-    // =========================================================================
-    // TEST 10: Software Reset (0x66 then 0x99)
-    // =========================================================================
-    std::cout << "\n[TEST 10] Software Reset (0x66 + 0x99)\n";
-    {
-        // Reset Enable
-        default_inputs(dut);
-        dut->command_i   = 0x66;
-        dut->data_mode_i = 0b00;
-        dut->has_addr_i  = 0;
-        dut->rd_wr_i     = 0;
-        start_transfer(dut, tfp);
-        wait_status(dut, tfp);
-        clear_status(dut, tfp);
-        tick(10, dut, tfp);
+    // One chain, commands alternating between the devices: each program is
+    // followed by a WIP poll of its own device, the reads come back in
+    // queue order
+    std::vector<uint8_t> tx(2 * n), rx(2 * n, 0);
+    for (size_t i = 0; i < n; i++) {
+        tx[i]     = uint8_t(i ^ 0x5A);
+        tx[n + i] = uint8_t(i ^ 0xA5);
+    }
+    std::vector<FlashDesc> chain(6);
+    chain[0].cmd.opcode    = OP_WRITE_ENABLE;
+    chain[0].cmd.data_mode = MODE_NONE;
+    chain[1].cmd.opcode    = OP_PAGE_PROGRAM;
+    chain[1].cmd.has_addr  = true;
+    chain[1].cmd.addr      = base + 0x100;
+    chain[1].len           = n;
+    chain[1].poll          = true;
+    chain[0].cs            = 1;
+    chain[1].cs            = 1;
+    chain[2]               = chain[0];
+    chain[2].cs            = 0;
+    chain[3]               = chain[1];
+    chain[3].cs            = 0;
+    chain[4].cmd.opcode    = OP_FAST_READ;
+    chain[4].cmd.read      = true;
+    chain[4].cmd.has_addr  = true;
+    chain[4].cmd.dummy     = FlashDriver::FAST_DUMMY;
+    chain[4].cmd.addr      = base + 0x100;
+    chain[4].len           = n;
+    chain[4].cs            = 1;
+    chain[5]               = chain[4];
+    chain[5].cs            = 0;
+    drv.set_poll(OP_READ_STATUS, FlashDriver::SR_WIP, 0x00, 0, 0);
+    check_bool("Chain across both devices", drv.run_chain(chain, tx.data(), rx.data()), true);
+    check_bool("Device 1 read back", std::equal(rx.begin(), rx.begin() + n, tx.begin()), true);
+    check_bool("Device 0 read back", std::equal(rx.begin() + n, rx.end(), tx.begin() + n), true);
+    check("No device busy after the chain", dut->dev_busy_o, 0);
+    check_bool("Device 0 page untouched", drv.fast_read(base, n) == wr0, true);
+    default_inputs(dut);
+    tick(10, dut, tfp);
+}
 
-        // Reset Execute
-        default_inputs(dut);
-        dut->command_i   = 0x99;
-        dut->data_mode_i = 0b00;
-        dut->has_addr_i  = 0;
-        dut->rd_wr_i     = 0;
-        start_transfer(dut, tfp);
-        wait_status(dut, tfp);
-        check_bool("Reset completed", dut->status_o, true);
-        clear_status(dut, tfp);
-        tick(20, dut, tfp);
+// ============================================================================
+// TEST 28: Busy timing — WIP and flag status ready while flash 1 programs and
+// erases, other commands ignored until it is done
+// ============================================================================
+void test_busy_timing(Vspi_flash_top* dut, TbTrace* tfp, FlashDriver& drv) {
+    std::cout << "\n[TEST 28] Program / erase busy time on device 1\n";
+    default_inputs(dut);
+    tick(2, dut, tfp);
+
+    const uint64_t t_pp = TB_T_PP, t_se = TB_T_SE;
+    const uint32_t base = 0x020C00;
+    const size_t   n    = 32;
+    FlashDriver drv1(dut, tfp, sim_time);
+    drv1.cs = 1;
+    std::vector<uint8_t> wr(n);
+    for (size_t i = 0; i < n; i++)
+        wr[i] = uint8_t(i * 5 + 0x33);
+
+    check("Flag status ready when idle", drv1.read_flag_status(), 0x80);
+
+    // One page program without waiting
+    FlashCmd pp;
+    pp.opcode   = OP_PAGE_PROGRAM;
+    pp.has_addr = true;
+    pp.addr     = base;
+    check_bool("WREN", drv1.write_enable(), true);
+    uint64_t t0 = drv1.ticks;
+    check_bool("Page program sent", drv1.transfer(pp, wr.data(), nullptr, n), true);
+    check("WIP set after CS high", drv1.read_status() & FlashDriver::SR_WIP, FlashDriver::SR_WIP);
+    check("Flag status not ready", drv1.read_flag_status() & 0x80, 0x00);
+    check("Device 0 not busy", drv.read_status() & FlashDriver::SR_WIP, 0x00);
+
+    // Ignored while busy: JEDEC ID, and a WREN + program over the same page
+    check_bool("JEDEC ID ignored", drv1.read_jedec() != 0x20BA1A, true);
+    const uint8_t zeros[4] = {0, 0, 0, 0};
+    drv1.write_enable();
+    drv1.transfer(pp, zeros, nullptr, sizeof(zeros));
+
+    check_bool("WIP clears", drv1.wait_ready(), true);
+    uint64_t t = drv1.ticks - t0;
+    std::cout << "  program to ready: " << std::dec << t << " cycles, "
+              << drv1.last_poll_count << " status reads\n";
+    check_bool("Busy for at least tPP", t >= t_pp, true);
+    check_bool("Status read more than once", drv1.last_poll_count > 1, true);
+    check("Flag status ready again", drv1.read_flag_status(), 0x80);
+    check_bool("Ignored program left the data", drv1.fast_read(base, n) == wr, true);
+    check("JEDEC ID after ready", drv1.read_jedec(), 0x20BA1A);
+
+    // An erase only starts at CS high right after the address: clocks past
+    // it cancel the erase, and the device never goes busy
+    FlashCmd se_long;
+    se_long.opcode   = OP_SECTOR_ERASE;
+    se_long.has_addr = true;
+    se_long.addr     = base;
+    check_bool("WREN before a cut-short erase", drv1.write_enable(), true);
+    check_bool("Erase with a data byte sent", drv1.transfer(se_long, zeros, nullptr, 1), true);
+    check("No WIP after the cut-short erase", drv1.read_status() & FlashDriver::SR_WIP, 0x00);
+    check_bool("Cut-short erase left the data", drv1.fast_read(base, n) == wr, true);
+    drv1.command(OP_WRITE_DISABLE);
+
+    // program() and erase_sector() wait on their own
+    t0 = drv1.ticks;
+    check_bool("Sector erase", drv1.erase_sector(base), true);
+    check_bool("Erase took at least tSE", drv1.ticks - t0 >= t_se, true);
+    check("Ready after erase_sector()", drv1.read_status() & FlashDriver::SR_WIP, 0x00);
+    check_bool("Sector erased", drv1.fast_read(base, n) == std::vector<uint8_t>(n, 0xFF), true);
+
+    // Device 0 is served while device 1 erases and is polled back to back
+    // (interval 0): host commands and queued commands go between the reads
+    FlashCmd se;
+    se.opcode    = OP_SECTOR_ERASE;
+    se.data_mode = MODE_NONE;
+    se.has_addr  = true;
+    se.addr      = base;
+    drv.set_poll(OP_READ_STATUS, FlashDriver::SR_WIP, 0x00, 0, 0);
+    check_bool("WREN before erase", drv1.write_enable(), true);
+    check_bool("Erase sent", drv1.transfer(se, nullptr, nullptr, 0), true);
+    dut->cs_i         = 1;
+    dut->poll_start_i = 1;
+    tick(1, dut, tfp);
+    dut->poll_start_i = 0;
+    vluint64_t s0 = sim_time;
+    std::vector<uint8_t> rd0 = drv.fast_read(0x020A00, n);
+    check("JEDEC ID of device 0 during the erase", drv.read_jedec(), 0x20BA19);
+    uint64_t host_c = (sim_time - s0) / 2;
+    std::cout << "  host read and JEDEC ID of device 0: " << host_c << " cycles\n";
+    check("Device 1 still polled", dut->dev_busy_o, 0x2);
+    check_bool("Host commands not behind the erase", host_c < t_se, true);
+    bool erased = false;
+    for (uint64_t i = 0; i < 4 * t_se && !erased; i++) {
+        tick(1, dut, tfp);
+        erased = dut->status_o && !dut->dev_busy_o;
     }
+    check_bool("Erase poll done", erased, true);
+    check_bool("Erase poll matched", dut->poll_timeout_o, false);
+    clear_status(dut, tfp);
 
-    // =========================================================================
-    // TEST 11: TX FIFO flush
-    // =========================================================================
-    std::cout << "\n[TEST 11] TX FIFO flush\n";
-    {
-        default_inputs(dut);
-        // Push some data
-        push_tx(dut, tfp, 0x11223344);
-        push_tx(dut, tfp, 0x55667788);
-        check_bool("TX FIFO not empty before flush", !dut->tx_fifo_empty_o, true);
-
-        // Flush
-        dut->flush_tx_i = 1;
-        tick(2, dut, tfp);
-        dut->flush_tx_i = 0;
-        tick(2, dut, tfp);
-        check_bool("TX FIFO empty after flush", dut->tx_fifo_empty_o, true);
-        tick(10, dut, tfp);
+    std::vector<FlashDesc> chain(3);
+    chain[0].cmd.opcode    = OP_WRITE_ENABLE;
+    chain[0].cmd.data_mode = MODE_NONE;
+    chain[0].cs            = 1;
+    chain[1].cmd           = se;
+    chain[1].poll          = true;
+    chain[1].cs            = 1;
+    chain[2].cmd.opcode    = OP_FAST_READ;
+    chain[2].cmd.read      = true;
+    chain[2].cmd.has_addr  = true;
+    chain[2].cmd.dummy     = FlashDriver::FAST_DUMMY;
+    chain[2].cmd.addr      = 0x020A00;
+    chain[2].len           = n;
+    chain[2].cs            = 0;
+    std::vector<uint8_t> rx(n, 0);
+    check_bool("Chain: erase on 1, read on 0", drv.run_chain(chain, nullptr, rx.data()), true);
+    std::cout << "  queued read of device 0 back after " << drv.last_first_rx << " of "
+              << drv.last_cycles << " chain cycles\n";
+    check_bool("Queued read not behind the erase", drv.last_first_rx < t_se, true);
+    check_bool("Chain waited for the erase", drv.last_cycles >= t_se, true);
+    check_bool("Queued read data", rx == rd0, true);
+    check_bool("program() back to back", drv1.program(base, wr) && drv1.program(base + 0x100, wr),
+               true);
+    check_bool("Both pages programmed", drv1.fast_read(base, n) == wr &&
+                                        drv1.fast_read(base + 0x100, n) == wr, true);
+    default_inputs(dut);
+    tick(10, dut, tfp);
+}
+
+// ============================================================================
+// Test table
+//
+// +test=<name|number>[,...] runs a subset, +list prints the table. A test
+// whose checks rely on flash contents written by an earlier one names it in
+// dep and gets it run first, so every test can be run on its own (see
+// run_tests.py); without +test= all tests run in order, as one scenario.
+// ============================================================================
+typedef void (*TestFn)(Vspi_flash_top*, TbTrace*, FlashDriver&);
+
+struct TbTest {
+    const char* name;
+    TestFn      fn;
+    int         dep;    // test number to run first, 0 for none
+};
+
+const TbTest tests[] = {
+    {"write_enable",     test_write_enable,     0},
+    {"write_disable",    test_write_disable,    0},
+    {"jedec_id",         test_jedec_id,         0},
+    {"read_status",      test_read_status,      0},
+    {"read_flag_status", test_read_flag_status, 0},
+    {"page_program",     test_page_program,     0},
+    {"fast_read",        test_fast_read,        6},
+    {"read",             test_read,             0},
+    {"sector_erase",     test_sector_erase,     0},
+    {"soft_reset",       test_soft_reset,       0},
+    {"tx_flush",         test_tx_flush,         0},
+    {"back_to_back",     test_back_to_back,     0},
+    {"busy",             test_busy,             0},
+    {"clr_status",       test_clr_status,       0},
+    {"multi_page",       test_multi_page,       0},
+    {"quad_io",          test_quad_io,          0},
+    {"dual_io",          test_dual_io,          0},
+    {"long_reads",       test_long_reads,       0},
+    {"watermarks",       test_watermarks,       16},
+    {"cmd_queue",        test_cmd_queue,        0},
+    {"auto_poll",        test_auto_poll,        0},
+    {"chip_erase",       test_chip_erase,       21},
+    {"image_dump",       test_image_dump,       22},
+    {"dtr",              test_dtr,              0},
+    {"four_byte",        test_four_byte,        0},
+    {"cont_read",        test_cont_read,        0},
+    {"multi_cs",         test_multi_cs,         0},
+    {"busy_timing",      test_busy_timing,      0},
+};
+const int NUM_TESTS = int(sizeof(tests) / sizeof(tests[0]));
+
+// Number of a test given by name or number, 0 when there is none
+int test_number(const std::string& tok) {
+    int n = std::atoi(tok.c_str());
+    for (int i = 0; n == 0 && i < NUM_TESTS; i++)
+        if (tok == tests[i].name) n = i + 1;
+    return (n >= 1 && n <= NUM_TESTS) ? n : 0;
+}
+
+// Test numbers to run, in order, with their dependencies; empty on a bad name
+std::vector<int> select_tests() {
+    std::vector<int> run;
+    const char* arg = Verilated::commandArgsPlusMatch("test=");
+    if (!arg[0]) {
+        for (int n = 1; n <= NUM_TESTS; n++)
+            run.push_back(n);
+        return run;
     }
 
-    // =========================================================================
-    // TEST 12: Back-to-back writes — write 8 bytes to consecutive addresses
-    // =========================================================================
-    std::cout << "\n[TEST 12] Back-to-back writes (0x000010 and 0x000014)\n";
-    {
-        for (int i = 0; i < 2; i++) {
-            uint32_t waddr  = 0x000010 + (i * 4);
-            uint32_t wdata  = (i == 0) ? 0xAABBCCDD : 0x11223344;
-
-            // Write Enable
-            default_inputs(dut);
-            dut->command_i   = 0x06;
-            dut->data_mode_i = 0b00;
-            dut->has_addr_i  = 0;
-            dut->rd_wr_i     = 0;
-            start_transfer(dut, tfp);
-            wait_status(dut, tfp);
-            clear_status(dut, tfp);
-            tick(5, dut, tfp);
-
-            // Write
-            default_inputs(dut);
-            dut->command_i    = 0x02;
-            dut->data_mode_i  = 0b01;
-            dut->rd_wr_i      = 0;
-            dut->has_addr_i   = 1;
-            dut->addr_i       = waddr;
-            dut->data_count_i = 3;
-            push_tx(dut, tfp, wdata);
-            start_transfer(dut, tfp);
-            wait_status(dut, tfp);
-            clear_status(dut, tfp);
-            tick(5, dut, tfp);
-        }
+    std::vector<bool> want(NUM_TESTS + 1, false);
+    std::string list(arg + std::strlen("+test="));
+    size_t pos = 0;
+    while (pos <= list.size()) {
+        size_t comma = list.find(',', pos);
+        if (comma == std::string::npos) comma = list.size();
+        std::string tok = list.substr(pos, comma - pos);
+        pos = comma + 1;
+        if (tok.empty()) continue;
 
-        // Read both back
-        uint32_t expected[2] = {0xAABBCCDD, 0x11223344};
-        for (int i = 0; i < 2; i++) {
-            uint32_t raddr = 0x000010 + (i * 4);
-            default_inputs(dut);
-            dut->command_i    = 0x03;
-            dut->data_mode_i  = 0b01;
-            dut->rd_wr_i      = 1;
-            dut->has_addr_i   = 1;
-            dut->addr_i       = raddr;
-            dut->data_count_i = 3;
-            dut->dummy_cycle_i= 0;
-            start_transfer(dut, tfp);
-            wait_status(dut, tfp);
-            tick(10, dut, tfp);
-            uint32_t rd = pop_rx(dut, tfp);
-            check("Back-to-back read word " + std::to_string(i), rd, expected[i]);
-            clear_status(dut, tfp);
-            tick(5, dut, tfp);
+        int n = test_number(tok);
+        if (n == 0) {
+            std::cout << "Unknown test '" << tok << "', see +list\n";
+            return {};
         }
+        for (; n != 0; n = tests[n - 1].dep)
+            want[n] = true;
     }
+    for (int n = 1; n <= NUM_TESTS; n++)
+        if (want[n]) run.push_back(n);
+    return run;
+}
 
-    // =========================================================================
-    // TEST 13: Busy signal — check it goes high during transfer
-    // =========================================================================
-    std::cout << "\n[TEST 13] Busy signal during transfer\n";
-    {
-        default_inputs(dut);
-        dut->command_i   = 0x06;
-        dut->data_mode_i = 0b00;
-        dut->has_addr_i  = 0;
-        dut->rd_wr_i     = 0;
-
-        start_transfer(dut, tfp);
-        tick(2, dut, tfp);  // a couple cycles in — should be busy
-        check_bool("busy_o high during transfer", dut->busy_o, true);
-
-        wait_status(dut, tfp);
-        tick(2, dut, tfp);
-        check_bool("busy_o low after transfer", dut->busy_o, false);
-        clear_status(dut, tfp);
-        tick(10, dut, tfp);
+// ============================================================================
+// Checkpoints
+//
+//   +save=<file>           write a checkpoint at +save_at
+//   +save_at=<point>       "reset", or a test name or number: after that test
+//                          (default: after the last test that runs)
+//   +restore=<file>        start from a checkpoint instead of reset; tests it
+//                          has already run, and their dependencies, are skipped
+//
+// Only models built with --savable (make build_model_save) have them. A
+// checkpoint holds the model, every flash store (FlashMem::save_all()), the
+// driver and the test results so far, so one warmed-up run can be restored
+// by many runs with different +test= lists. Model plusargs (log levels,
+// busy times, +flash_image) are those of the saving run; +flash_image must
+// still be in place.
+// ============================================================================
+std::string plusarg(const char* name) {
+    std::string key = std::string(name) + "=";
+    const char* arg = Verilated::commandArgsPlusMatch(key.c_str());
+    if (!arg || !arg[0]) return "";
+    return std::string(arg + 1 + key.size());
+}
+
+#ifdef TB_SAVABLE
+const char CKPT_MAGIC[8] = {'T', 'B', 'C', 'K', 'P', 'T', '0', '1'};
+
+bool save_checkpoint(const std::string& file, Vspi_flash_top* dut, FlashDriver& drv,
+                     const std::vector<bool>& done) {
+    VerilatedSave os;
+    os.open(file.c_str());
+    if (!os.isOpen()) {
+        std::cout << "Cannot write checkpoint " << file << "\n";
+        return false;
     }
+    int num_tests = NUM_TESTS;
+    os.write(CKPT_MAGIC, sizeof(CKPT_MAGIC));
+    os.write(&num_tests, sizeof(num_tests));
+    for (int n = 1; n <= NUM_TESTS; n++) {
+        uint8_t d = done[n];
+        os.write(&d, sizeof(d));
+    }
+    os.write(&sim_time, sizeof(sim_time));
+    os.write(&test_pass, sizeof(test_pass));
+    os.write(&test_fail, sizeof(test_fail));
+    drv.save(os);
+    FlashMem::save_all(os);
+    os << *dut;
+    os.close();
+    std::cout << "Checkpoint " << file << " at " << std::dec << sim_time / 2 << " cycles\n";
+    return true;
+}
 
-    // =========================================================================
-    // TEST 14: clr_status_i clears status_o
-    // =========================================================================
-    std::cout << "\n[TEST 14] clr_status_i clears status_o\n";
+bool restore_checkpoint(const std::string& file, Vspi_flash_top* dut, FlashDriver& drv,
+                        std::vector<bool>& done) {
+    VerilatedRestore is;
+    is.open(file.c_str());
+    if (!is.isOpen()) {
+        std::cout << "Cannot read checkpoint " << file << "\n";
+        return false;
+    }
+    char magic[sizeof(CKPT_MAGIC)];
+    int  num_tests = 0;
+    is.read(magic, sizeof(magic));
+    is.read(&num_tests, sizeof(num_tests));
+    if (std::memcmp(magic, CKPT_MAGIC, sizeof(magic)) != 0 || num_tests != NUM_TESTS) {
+        std::cout << file << ": not a checkpoint of this testbench\n";
+        return false;
+    }
+    for (int n = 1; n <= NUM_TESTS; n++) {
+        uint8_t d = 0;
+        is.read(&d, sizeof(d));
+        done[n] = d != 0;
+    }
+    is.read(&sim_time, sizeof(sim_time));
+    is.read(&test_pass, sizeof(test_pass));
+    is.read(&test_fail, sizeof(test_fail));
+    drv.restore(is);
+    if (!FlashMem::restore_all(is)) {
+        std::cout << file << ": cannot restore the flash image\n";
+        return false;
+    }
+    is >> *dut;
+    is.close();
+    std::cout << "Restored " << file << " at " << std::dec << sim_time / 2 << " cycles\n";
+    return true;
+}
+#endif
+
+// ============================================================================
+// main
+// ============================================================================
+int main(int argc, char **argv) {
+    Verilated::commandArgs(argc, argv);
+
+    if (Verilated::commandArgsPlusMatch("list")[0]) {
+        for (int i = 0; i < NUM_TESTS; i++)
+            std::cout << (i + 1) << " " << tests[i].name << "\n";
+        return 0;
+    }
+    std::vector<int> run = select_tests();
+    if (run.empty())
+        return 2;
+
+    std::string save_file    = plusarg("save");
+    std::string save_at      = plusarg("save_at");
+    std::string restore_file = plusarg("restore");
+    int save_test = save_at.empty() ? run.back() : test_number(save_at);
+    if (!save_file.empty() && save_at != "reset" &&
+        std::find(run.begin(), run.end(), save_test) == run.end()) {
+        std::cout << "+save_at=" << save_at << " is not a test of this run, see +list\n";
+        return 2;
+    }
+#ifndef TB_SAVABLE
+    if (!save_file.empty() || !restore_file.empty()) {
+        std::cout << "+save / +restore need a --savable model (make build_model_save)\n";
+        return 2;
+    }
+#endif
+
+    // +trace=none|vcd|fst, +trace_ring=<cycles>, see tb_trace.h
+    TbTrace* tfp = new TbTrace;
+    tfp->init();
+    trace = tfp;
+
+    Vspi_flash_top *dut = new Vspi_flash_top;
+    tfp->open(dut, "waveform");
+
+    auto wall_start = std::chrono::steady_clock::now();
+
+    FlashDriver drv(dut, tfp, sim_time);
+    std::vector<bool> done(NUM_TESTS + 1, false);
+
+    // -------------------------------------------------------------------------
+    // Reset, or the state of a checkpoint
+    // -------------------------------------------------------------------------
+#ifdef TB_SAVABLE
+    if (!restore_file.empty()) {
+        if (!restore_checkpoint(restore_file, dut, drv, done))
+            return 2;
+    } else
+#endif
     {
         default_inputs(dut);
-        dut->command_i   = 0x06;
-        dut->data_mode_i = 0b00;
-        dut->has_addr_i  = 0;
-        dut->rd_wr_i     = 0;
-        start_transfer(dut, tfp);
-        wait_status(dut, tfp);
-        check_bool("status_o high before clear", dut->status_o, true);
-
-        dut->clr_status_i = 1;
-        tick(1, dut, tfp);
-        dut->clr_status_i = 0;
-        tick(2, dut, tfp);
-        check_bool("status_o low after clear", dut->status_o, false);
+        dut->rstn = 0;
         tick(10, dut, tfp);
+        dut->rstn = 1;
+        dut->data_rx_ready_i = 0;
+        tick(10, dut, tfp);
+    }
+
+    std::cout << "\n=== SPI Flash Top Testbench ===\n\n";
+
+#ifdef TB_SAVABLE
+    if (!save_file.empty() && save_at == "reset" && !save_checkpoint(save_file, dut, drv, done))
+        return 2;
+#endif
+    for (int n : run) {
+        if (done[n]) {
+            std::cout << "[TEST " << n << "] " << tests[n - 1].name << ": from checkpoint\n";
+            continue;
+        }
+        tests[n - 1].fn(dut, tfp, drv);
+        done[n] = true;
+#ifdef TB_SAVABLE
+        if (!save_file.empty() && save_at != "reset" && n == save_test &&
+            !save_checkpoint(save_file, dut, drv, done))
+            return 2;
+#endif
     }
 
     // =========================================================================
     // Summary
     // =========================================================================
+    test_fail += drv.timeouts;
     std::cout << "\n=== Results: "
               << test_pass << " passed, "
               << test_fail << " failed ===\n";
 
     tick(20, dut, tfp);
+
+    std::chrono::duration<double> wall =
+        std::chrono::steady_clock::now() - wall_start;
+    std::cout << "Wall time: " << std::dec << wall.count() << " s\n";
+
     dut->final();
     tfp->close();
+    delete tfp;
     delete dut;
     return (test_fail > 0) ? 1 : 0;
 }
\ No newline at end of file
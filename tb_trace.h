@@ -0,0 +1,238 @@
+// Waveform tracing shared by the Verilator testbenches.
+//
+// The trace format is fixed when the model is verilated (--trace for VCD,
+// --trace-fst for FST); whether a trace is written at all is chosen at
+// runtime:
+//
+//   +trace          write waveform.<vcd|fst> in the format the model has
+//   +trace=none     no waveform (default for models built without tracing)
+//   +trace=vcd      only valid for --trace builds
+//   +trace=fst      only valid for --trace-fst builds
+//   +trace_ring=<n> VCD builds: keep the last n to 2n cycles in memory and
+//                   write them only when the testbench calls capture(), as
+//                   <basename>_fail<k>.vcd
+//
+// Models built without tracing turn dump() into an empty inline function, so
+// the per-cycle calls in tick() and friends cost nothing.
+//
+// The ring holds two segments of n cycles of VerilatedVcdC output. Every
+// segment after the first starts with a full dump (openNext()), so the older
+// segment can be dropped and the two kept ones, behind the header, still make
+// one valid VCD. Value changes are still computed each cycle, but nothing is
+// written to disk until a failure. capture() writes nothing again if no cycle
+// was dumped since the last capture, and stops after MAX_CAPTURES files.
+#pragma once
+
+#include "verilated.h"
+#include <cstring>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#if VM_TRACE_FST
+#include "verilated_fst_c.h"
+#elif VM_TRACE
+#include "verilated_vcd_c.h"
+#endif
+
+enum TraceMode { TRACE_NONE, TRACE_VCD, TRACE_FST };
+
+#if VM_TRACE && !VM_TRACE_FST
+// VerilatedVcdC output kept in memory: the header, the previous segment and
+// the one being written. Each open() (openNext()) starts a new segment.
+class TbVcdRing : public VerilatedVcdFile {
+public:
+    bool open(const std::string&) override {
+        if (head.empty() && !cur.empty()) {
+            // only the first segment has the header
+            size_t p = cur.find("$enddefinitions $end");
+            p = (p == std::string::npos) ? 0 : cur.find('\n', p) + 1;
+            head = cur.substr(0, p);
+            cur.erase(0, p);
+        }
+        prev.swap(cur);
+        cur.clear();
+        return true;
+    }
+
+    void close() override {}
+
+    ssize_t write(const char* bufp, ssize_t len) override {
+        cur.append(bufp, len);
+        return len;
+    }
+
+    bool save(const std::string& path) const {
+        std::ofstream f(path, std::ios::binary);
+        f << head << prev << cur;
+        return bool(f);
+    }
+
+private:
+    std::string head;
+    std::string prev;
+    std::string cur;
+};
+#endif
+
+class TbTrace {
+public:
+    // Format the model was built with
+    static TraceMode built_mode() {
+#if VM_TRACE_FST
+        return TRACE_FST;
+#elif VM_TRACE
+        return TRACE_VCD;
+#else
+        return TRACE_NONE;
+#endif
+    }
+
+    // Parse +trace[=mode]. Call after Verilated::commandArgs() and before the
+    // model is constructed.
+    void init() {
+        const char* arg = Verilated::commandArgsPlusMatch("trace");
+        std::string req = "";
+        if (arg && std::strncmp(arg, "+trace", 6) == 0) {
+            req = arg + 6;
+            if (!req.empty() && req[0] == '=') req = req.substr(1);
+            else if (req.compare(0, 6, "_ring=") == 0) req = "on";
+            else if (!req.empty()) req = "invalid";   // e.g. +tracefoo
+            else req = "on";
+        }
+
+        if (req.empty() || req == "on")
+            mode = built_mode();
+        else if (req == "none")
+            mode = TRACE_NONE;
+        else if (req == "vcd" || req == "fst") {
+            mode = (req == "vcd") ? TRACE_VCD : TRACE_FST;
+            if (mode != built_mode()) {
+                std::cout << "[TRACE] model not built with " << req
+                          << " support, tracing disabled\n";
+                mode = TRACE_NONE;
+            }
+        } else {
+            std::cout << "[TRACE] unknown +trace mode '" << req
+                      << "', expected none|vcd|fst\n";
+            mode = TRACE_NONE;
+        }
+
+        const char* ring = Verilated::commandArgsPlusMatch("trace_ring=");
+        if (ring && std::strncmp(ring, "+trace_ring=", 12) == 0) {
+            ring_cycles = std::strtoull(ring + 12, nullptr, 0);
+            if (ring_cycles && mode != TRACE_VCD) {
+                std::cout << "[TRACE] +trace_ring needs a --trace (VCD) model, tracing disabled\n";
+                mode = TRACE_NONE;
+                ring_cycles = 0;
+            }
+        }
+
+        if (mode != TRACE_NONE)
+            Verilated::traceEverOn(true);
+    }
+
+    // Attach to the model and open <basename>.vcd / <basename>.fst
+    template <class Model>
+    void open(Model* dut, const std::string& basename) {
+#if VM_TRACE_FST
+        if (mode == TRACE_FST) {
+            m_tfp = new VerilatedFstC;
+            dut->trace(m_tfp, 99);
+            m_tfp->open((basename + ".fst").c_str());
+        }
+#elif VM_TRACE
+        if (mode == TRACE_VCD) {
+            if (ring_cycles) {
+                m_ring     = new TbVcdRing;
+                m_basename = basename;
+            }
+            m_tfp = new VerilatedVcdC(m_ring);
+            dut->trace(m_tfp, 99);
+            m_tfp->open((basename + ".vcd").c_str());
+        }
+#else
+        (void)dut;
+        (void)basename;
+#endif
+    }
+
+    inline void dump(vluint64_t t) {
+#if VM_TRACE
+        if (m_tfp) {
+            m_tfp->dump(t);
+#if !VM_TRACE_FST
+            // two dumps per cycle in the tick() loops
+            if (m_ring && ++m_seg_dumps >= 2 * ring_cycles) {
+                m_seg_dumps = 0;
+                m_tfp->openNext(false);
+            }
+            m_dumps++;
+#endif
+        }
+#else
+        (void)t;
+#endif
+    }
+
+    // +trace_ring: write the cycles in memory to <basename>_fail<k>.vcd,
+    // why says which failure. Does nothing in the other modes.
+    void capture(const std::string& why) {
+#if VM_TRACE && !VM_TRACE_FST
+        if (!m_ring || m_captures > MAX_CAPTURES)
+            return;
+        if (m_dumps == m_capture_dumps && m_captures > 0) {
+            std::cout << "[TRACE] " << why << ": see " << m_capture_path << "\n";
+            return;
+        }
+        if (m_captures == MAX_CAPTURES) {
+            std::cout << "[TRACE] " << MAX_CAPTURES << " failure traces written, no more\n";
+            m_captures++;
+            return;
+        }
+        m_tfp->flush();
+        m_capture_path  = m_basename + "_fail" + std::to_string(++m_captures) + ".vcd";
+        m_capture_dumps = m_dumps;
+        if (m_ring->save(m_capture_path))
+            std::cout << "[TRACE] " << why << ": last cycles in " << m_capture_path << "\n";
+        else
+            std::cout << "[TRACE] cannot write " << m_capture_path << "\n";
+#else
+        (void)why;
+#endif
+    }
+
+    void close() {
+#if VM_TRACE
+        if (m_tfp) {
+            m_tfp->close();
+            delete m_tfp;
+            m_tfp = nullptr;
+        }
+#if !VM_TRACE_FST
+        delete m_ring;
+        m_ring = nullptr;
+#endif
+#endif
+    }
+
+    TraceMode          mode        = TRACE_NONE;
+    unsigned long long ring_cycles = 0;   // +trace_ring, 0 when off
+
+private:
+#if VM_TRACE_FST
+    VerilatedFstC* m_tfp = nullptr;
+#elif VM_TRACE
+    static const int MAX_CAPTURES = 10;
+
+    VerilatedVcdC*     m_tfp  = nullptr;
+    TbVcdRing*         m_ring = nullptr;
+    std::string        m_basename;
+    std::string        m_capture_path;
+    unsigned long long m_seg_dumps     = 0;
+    unsigned long long m_dumps         = 0;
+    unsigned long long m_capture_dumps = 0;
+    int                m_captures      = 0;
+#endif
+};